@@ -67,6 +67,9 @@
 
 #include "src/maerklin_ir_gw/maerklin292xxir.h"
 #include "src/maerklin_ir_gw/irgatewaywebserver.h"
+#include "src/maerklin_ir_gw/irgatewayudp.h"
+#include "src/maerklin_ir_gw/irgatewaywebsocket.h"
+#include "src/maerklin_ir_gw/irgatewaypeers.h"
 #include "src/maerklin_ir_gw/locodatabase.h"
 #include "src/withrottle/withrottle.h"
 
@@ -222,9 +225,19 @@ void setup() {
   MDNS.addService("irgateway", "tcp", 80);
   MDNS.addService("withrottle", "tcp", 2560);
 
-  WiThrottle_Init();
+  WiThrottle_Init(AppConfig_GetWiThrottleClients());
+  WiThrottle_SetStopLocos(AppConfig_GetWiThrottleStopLocos() != 0);
+
+  IrGatewayUdp_Init(AppConfig_GetUdpCmdPort());
+  if (AppConfig_GetUdpCmdPort() != 0)
+  {
+    MDNS.addService("irgateway", "udp", AppConfig_GetUdpCmdPort());
+  }
+
+  IrGatewayWebSocket_Init(IRGATEWAYWEBSOCKET_PORT);
 
   MdnsClientList_Init("irgateway");
+  IrGatewayPeers_Init(AppConfig_GetPeerMulticast() != 0);
 
   //add your initial stuff here
 }
@@ -264,6 +277,10 @@ void loop() {
   AppWebServer_Update();
 #if defined(ARDUINO_ARCH_ESP8266)
   MDNS.update();
+#endif
+  IrGatewayWebServer_RunScheduled();
+#if defined(ARDUINO_ARCH_ESP8266)
+  MDNS.update();
 #endif
   Maerklin292xxIr_Update();
 #if defined(ARDUINO_ARCH_ESP8266)
@@ -272,6 +289,18 @@ void loop() {
   WiThrottle_Update();
 #if defined(ARDUINO_ARCH_ESP8266)
   MDNS.update();
+#endif
+  IrGatewayUdp_Update();
+#if defined(ARDUINO_ARCH_ESP8266)
+  MDNS.update();
+#endif
+  IrGatewayWebSocket_Update();
+#if defined(ARDUINO_ARCH_ESP8266)
+  MDNS.update();
+#endif
+  IrGatewayPeers_Update();
+#if defined(ARDUINO_ARCH_ESP8266)
+  MDNS.update();
 #endif
   MdnsClientList_Update();
 #if defined(ARDUINO_ARCH_ESP8266)
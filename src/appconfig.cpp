@@ -80,6 +80,14 @@ stc_appconfig_t stcAppConfig = {
   12, // GpioIr
   -32, // GpioStatus
   -32, // GpioButton
+  -32, // GpioIr2
+  -32, // GpioIr3
+  -32, // GpioIr4
+  {"11111111"}, // IrEmitterMap
+  3, // WiThrottleClients
+  1, // WiThrottleStopLocos
+  2561, // UdpCmdPort
+  0, // PeerMulticast
 
   0xCFDFAABBUL
 };
@@ -93,6 +101,14 @@ stc_webconfig_description_t astcAppConfigDescription[] = {
     {enWebConfigTypeInt32,"GpioIr","GPIO IR LED"},
     {enWebConfigTypeInt32,"GpioStatus","GPIO Status LED"},
     {enWebConfigTypeInt32,"GpioButton","GPIO Button"},
+    {enWebConfigTypeInt32,"GpioIr2","GPIO IR LED 2"},
+    {enWebConfigTypeInt32,"GpioIr3","GPIO IR LED 3"},
+    {enWebConfigTypeInt32,"GpioIr4","GPIO IR LED 4"},
+    {enWebConfigTypeStringLen32,"IrEmitterMap","IR LED (1-4) of loco A,B,C,D,G,H,I,J"},
+    {enWebConfigTypeInt32,"WiThrottleClients","WiThrottle max. clients"},
+    {enWebConfigTypeInt32,"WiThrottleStopLocos","WiThrottle stop locos of lost throttles (0/1)"},
+    {enWebConfigTypeInt32,"UdpCmdPort","UDP command port, 0 = off"},
+    {enWebConfigTypeInt32,"PeerMulticast","Sync gateways via UDP multicast (all gateways need this firmware), 0 = HTTP"},
 
 };
 
@@ -217,6 +233,14 @@ void AppConfig_Init(WebServer* pWebServerHandle)
       AppConfig_SetGpioIr(12);
       AppConfig_SetGpioStatus(-32);
       AppConfig_SetGpioButton(-32);
+      AppConfig_SetGpioIr2(-32);
+      AppConfig_SetGpioIr3(-32);
+      AppConfig_SetGpioIr4(-32);
+      AppConfig_SetIrEmitterMap({"11111111"});
+      AppConfig_SetWiThrottleClients(3);
+      AppConfig_SetWiThrottleStopLocos(1);
+      AppConfig_SetUdpCmdPort(2561);
+      AppConfig_SetPeerMulticast(0);
 
       bLockWrite = false;
       AppConfig_Write();
@@ -471,6 +495,254 @@ void AppConfig_SetGpioButton(int32_t GpioButton)
   stcAppConfig.GpioButton = GpioButton;
   AppConfig_Write();
 }
+/**********************************************
+ * Get GpioIr2 - GPIO IR LED 2
+ * 
+ * \return GpioIr2
+ **********************************************
+ */
+int32_t AppConfig_GetGpioIr2(void)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  return stcAppConfig.GpioIr2;
+}
+
+/*********************************************
+ * Set GpioIr2 - GPIO IR LED 2
+ * 
+ * \param GpioIr2 GPIO IR LED 2
+ * 
+ ********************************************* 
+ */
+void AppConfig_SetGpioIr2(int32_t GpioIr2)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  stcAppConfig.GpioIr2 = GpioIr2;
+  AppConfig_Write();
+}
+/**********************************************
+ * Get GpioIr3 - GPIO IR LED 3
+ * 
+ * \return GpioIr3
+ **********************************************
+ */
+int32_t AppConfig_GetGpioIr3(void)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  return stcAppConfig.GpioIr3;
+}
+
+/*********************************************
+ * Set GpioIr3 - GPIO IR LED 3
+ * 
+ * \param GpioIr3 GPIO IR LED 3
+ * 
+ ********************************************* 
+ */
+void AppConfig_SetGpioIr3(int32_t GpioIr3)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  stcAppConfig.GpioIr3 = GpioIr3;
+  AppConfig_Write();
+}
+/**********************************************
+ * Get GpioIr4 - GPIO IR LED 4
+ * 
+ * \return GpioIr4
+ **********************************************
+ */
+int32_t AppConfig_GetGpioIr4(void)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  return stcAppConfig.GpioIr4;
+}
+
+/*********************************************
+ * Set GpioIr4 - GPIO IR LED 4
+ * 
+ * \param GpioIr4 GPIO IR LED 4
+ * 
+ ********************************************* 
+ */
+void AppConfig_SetGpioIr4(int32_t GpioIr4)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  stcAppConfig.GpioIr4 = GpioIr4;
+  AppConfig_Write();
+}
+/**********************************************
+ * Get IrEmitterMap - IR LED (1-4) of loco A,B,C,D,G,H,I,J
+ * 
+ * \return IrEmitterMap
+ **********************************************
+ */
+const char* AppConfig_GetIrEmitterMap(void)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  return stcAppConfig.IrEmitterMap;
+}
+
+/*********************************************
+ * Set IrEmitterMap - IR LED (1-4) of loco A,B,C,D,G,H,I,J
+ * 
+ * \param IrEmitterMap IR LED (1-4) of loco A,B,C,D,G,H,I,J
+ * 
+ ********************************************* 
+ */
+void AppConfig_SetIrEmitterMap(const char* IrEmitterMap)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  strncpy(stcAppConfig.IrEmitterMap,IrEmitterMap,32);
+  AppConfig_Write();
+}
+/**********************************************
+ * Get WiThrottleClients - WiThrottle max. clients
+ * 
+ * \return WiThrottleClients
+ **********************************************
+ */
+int32_t AppConfig_GetWiThrottleClients(void)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  return stcAppConfig.WiThrottleClients;
+}
+
+/*********************************************
+ * Set WiThrottleClients - WiThrottle max. clients
+ * 
+ * \param WiThrottleClients WiThrottle max. clients
+ * 
+ ********************************************* 
+ */
+void AppConfig_SetWiThrottleClients(int32_t WiThrottleClients)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  stcAppConfig.WiThrottleClients = WiThrottleClients;
+  AppConfig_Write();
+}
+/**********************************************
+ * Get WiThrottleStopLocos - WiThrottle stop locos of lost throttles (0/1)
+ * 
+ * \return WiThrottleStopLocos
+ **********************************************
+ */
+int32_t AppConfig_GetWiThrottleStopLocos(void)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  return stcAppConfig.WiThrottleStopLocos;
+}
+
+/*********************************************
+ * Set WiThrottleStopLocos - WiThrottle stop locos of lost throttles (0/1)
+ * 
+ * \param WiThrottleStopLocos WiThrottle stop locos of lost throttles (0/1)
+ * 
+ ********************************************* 
+ */
+void AppConfig_SetWiThrottleStopLocos(int32_t WiThrottleStopLocos)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  stcAppConfig.WiThrottleStopLocos = WiThrottleStopLocos;
+  AppConfig_Write();
+}
+/**********************************************
+ * Get UdpCmdPort - UDP command port, 0 = off
+ * 
+ * \return UdpCmdPort
+ **********************************************
+ */
+int32_t AppConfig_GetUdpCmdPort(void)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  return stcAppConfig.UdpCmdPort;
+}
+
+/*********************************************
+ * Set UdpCmdPort - UDP command port, 0 = off
+ * 
+ * \param UdpCmdPort UDP command port, 0 = off
+ * 
+ ********************************************* 
+ */
+void AppConfig_SetUdpCmdPort(int32_t UdpCmdPort)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  stcAppConfig.UdpCmdPort = UdpCmdPort;
+  AppConfig_Write();
+}
+/**********************************************
+ * Get PeerMulticast - Sync gateways via UDP multicast (all gateways need this firmware), 0 = HTTP
+ * 
+ * \return PeerMulticast
+ **********************************************
+ */
+int32_t AppConfig_GetPeerMulticast(void)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  return stcAppConfig.PeerMulticast;
+}
+
+/*********************************************
+ * Set PeerMulticast - Sync gateways via UDP multicast (all gateways need this firmware), 0 = HTTP
+ * 
+ * \param PeerMulticast Sync gateways via UDP multicast (all gateways need this firmware), 0 = HTTP
+ * 
+ ********************************************* 
+ */
+void AppConfig_SetPeerMulticast(int32_t PeerMulticast)
+{
+  if (bInitDone == false)
+  {
+    AppConfig_Init(NULL);
+  }
+  stcAppConfig.PeerMulticast = PeerMulticast;
+  AppConfig_Write();
+}
 
 
 /**
@@ -101,6 +101,14 @@ typedef struct __attribute__((__packed__)) stc_appconfig
   int32_t GpioIr;
   int32_t GpioStatus;
   int32_t GpioButton;
+  int32_t GpioIr2;
+  int32_t GpioIr3;
+  int32_t GpioIr4;
+  char IrEmitterMap[32];
+  int32_t WiThrottleClients;
+  int32_t WiThrottleStopLocos;
+  int32_t UdpCmdPort;
+  int32_t PeerMulticast;
 
   uint32_t u32magic;
 } stc_appconfig_t;
@@ -138,6 +146,22 @@ int32_t AppConfig_GetGpioStatus(void);
 void AppConfig_SetGpioStatus(int32_t GpioStatus);
 int32_t AppConfig_GetGpioButton(void);
 void AppConfig_SetGpioButton(int32_t GpioButton);
+int32_t AppConfig_GetGpioIr2(void);
+void AppConfig_SetGpioIr2(int32_t GpioIr2);
+int32_t AppConfig_GetGpioIr3(void);
+void AppConfig_SetGpioIr3(int32_t GpioIr3);
+int32_t AppConfig_GetGpioIr4(void);
+void AppConfig_SetGpioIr4(int32_t GpioIr4);
+const char* AppConfig_GetIrEmitterMap(void);
+void AppConfig_SetIrEmitterMap(const char* IrEmitterMap);
+int32_t AppConfig_GetWiThrottleClients(void);
+void AppConfig_SetWiThrottleClients(int32_t WiThrottleClients);
+int32_t AppConfig_GetWiThrottleStopLocos(void);
+void AppConfig_SetWiThrottleStopLocos(int32_t WiThrottleStopLocos);
+int32_t AppConfig_GetUdpCmdPort(void);
+void AppConfig_SetUdpCmdPort(int32_t UdpCmdPort);
+int32_t AppConfig_GetPeerMulticast(void);
+void AppConfig_SetPeerMulticast(int32_t PeerMulticast);
 
 
 //@} // AppConfigGroup
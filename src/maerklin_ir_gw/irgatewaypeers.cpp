@@ -0,0 +1,822 @@
+/**
+ *******************************************************************************
+ ** Copyright © 2021 io-expert.com. All rights reserved.
+ **
+ ** 1. Redistributions of source code must retain the above copyright notice,
+ **    this condition and the following disclaimer.
+ **
+ ** This software is provided by the copyright holder and contributors "AS IS"
+ ** and any warranties related to this software are DISCLAIMED.
+ ** The copyright owner or contributors be NOT LIABLE for any damages caused
+ ** by use of this software.
+
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ **\file irgatewaypeers.cpp
+ **
+ ** Command replication to peer gateways
+ ** A detailed description is available at
+ ** @link IrGatewayPeersGroup file description @endlink
+ **
+ ** History:
+ ** - 2026-10-17  1.00  First version, forwards /api/cmd to peer gateways from loop()
+ *******************************************************************************
+ */
+
+#define __IRGATEWAYPEERS_C__
+
+/**
+ *******************************************************************************
+ ** Include files
+ *******************************************************************************
+ */
+
+#include <Arduino.h>
+
+#if defined(ARDUINO_ARCH_ESP8266)
+  #include <ESP8266WiFi.h>
+  #include <WiFiUdp.h>
+#elif defined(ARDUINO_ARCH_ESP32)
+  #include <WiFi.h>
+  #include <WiFiUdp.h>
+#elif defined(ARDUINO_ARCH_RP2040)
+  #include <WiFi.h>
+  #include <WiFiUdp.h>
+#else
+#error Not supported architecture
+#endif
+
+#include "irgatewaypeers.h"
+#include "../mdns/mdnsclientlist.h"
+#include "maerklin292xxir.h"
+
+/**
+ *******************************************************************************
+ ** Local pre-processor symbols/macros ('#define') 
+ *******************************************************************************
+ */
+
+#define PEER_PORT 80
+#define MAX_MESSAGES 8             //commands or batches in flight, shared by all peers
+#define BODY_SIZE (64 + IRGATEWAYPEERS_MAX_ENTRIES * 64)
+#define PEER_QUEUE_SIZE 4          //oldest message of a peer is dropped if more are pending
+#define CONNECT_TIMEOUT_MS 200     //connect is blocking in all cores, keep it short, peers are in the LAN
+#define RESPONSE_TIMEOUT_MS 1000   //per response, pipelined responses arrive one after the other
+#define RESPONSE_LINE_SIZE 48      //only status line, Content-Length and Connection are evaluated
+#define MAX_RETRIES 3
+#define BACKOFF_BASE_MS 250        //250, 500, 1000 ms after the 1st, 2nd, 3rd failure
+#define BACKOFF_MAX_MS 4000
+
+#define MULTICAST_COPIES 2         //multicast is not acknowledged by the access point, copies are dropped by the receivers
+#define MAX_PACKETS_PER_UPDATE 8
+#define MAX_ORIGINS 10
+#define SEQUENCE_WINDOW 32         //bits of stc_peer_origin_t::u32Window
+#define PACKET_SIZE (IRGATEWAYPEERS_HEADER_SIZE + IRGATEWAYPEERS_MAX_ENTRIES * IRGATEWAYPEERS_ENTRY_SIZE)
+
+/**
+ *******************************************************************************
+ ** Global variable definitions (declared in header file with 'extern') 
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** Local type definitions ('typedef') 
+ *******************************************************************************
+ */
+
+typedef struct stc_peer_message
+{
+  stc_irgateway_cmd_t astcCmds[IRGATEWAYPEERS_MAX_ENTRIES];
+  uint8_t u8Count;
+  uint8_t u8Refs;                  //number of peer queues holding the message
+} stc_peer_message_t;
+
+typedef struct stc_peer
+{
+  char acIp[18];                   //empty if the slot is not used
+  WiFiClient client;               //kept open between commands (HTTP/1.1 keep-alive)
+  uint8_t au8Queue[PEER_QUEUE_SIZE];
+  uint8_t u8QueueHead;
+  uint8_t u8QueueLen;
+  uint8_t u8InFlight;              //commands at the head of the queue sent without response yet
+  uint8_t u8Retries;
+  uint32_t u32Since;               //time of the last request/response or of the last failure
+  uint32_t u32Backoff;             //time to wait after the last failure
+  char acLine[RESPONSE_LINE_SIZE]; //response header line
+  uint8_t u8LineLen;
+  bool bStatusLine;                //next line is the status line of a response
+  bool bBody;
+  bool bClose;                     //peer closes the connection after the response
+  uint16_t u16BodyLeft;
+} stc_peer_t;
+
+typedef struct stc_peer_origin
+{
+  uint32_t u32Origin;              //0 if the slot is not used
+  uint32_t u32LastSeq;             //highest received sequence number
+  uint32_t u32Window;              //bit n: u32LastSeq - n was received
+  uint32_t u32LastSeen;
+} stc_peer_origin_t;
+
+/**
+ *******************************************************************************
+ ** Local variable definitions ('static') 
+ *******************************************************************************
+ */
+
+static stc_peer_message_t astcMessages[MAX_MESSAGES];
+static stc_peer_t astcPeers[IRGATEWAYPEERS_MAX_PEERS];
+static uint32_t u32Sent = 0;
+static uint32_t u32Retries = 0;
+static uint32_t u32Dropped = 0;
+
+static bool bMulticast = false;
+static WiFiUDP udp;
+static uint32_t u32Seq = 0;              //random start, see IrGatewayPeers_Init()
+static stc_peer_origin_t astcOrigins[MAX_ORIGINS];
+static uint32_t u32MulticastSent = 0;
+static uint32_t u32MulticastReceived = 0;
+static uint32_t u32MulticastDuplicates = 0;
+
+//HTTP body, indexed by en_irgateway_cmd_t
+static const char* const apcCommandNames[] = {"","stop","forward","backward","light","sound","speed","keepalive"};
+
+/**
+ *******************************************************************************
+ ** Local function prototypes ('static') 
+ *******************************************************************************
+ */
+
+static stc_peer_t* getPeer(const char* pcIp);
+static void popMessage(stc_peer_t* pPeer);
+static void resetConnection(stc_peer_t* pPeer);
+static bool connectPeer(stc_peer_t* pPeer);
+static bool writeRequests(stc_peer_t* pPeer);
+static bool receiveResponses(stc_peer_t* pPeer);
+static void failed(stc_peer_t* pPeer);
+static int formatBody(const stc_peer_message_t* pMessage, char* pcBody, int size);
+static void sendHttp(const stc_irgateway_cmd_t* pastcCmds, uint8_t u8Count);
+static void sendMulticast(const stc_irgateway_cmd_t* pastcCmds, uint8_t u8Count);
+static bool isNewSequence(uint32_t u32Origin, uint32_t u32Seq);
+static void receiveMulticast(void);
+
+/**
+ *******************************************************************************
+ ** Function implementation - global ('extern') and local ('static') 
+ *******************************************************************************
+ */
+
+/**
+ * Get the slot of a peer, a new slot is assigned if needed
+ * 
+ * \param pcIp IP address of the peer
+ * 
+ * \return peer slot, NULL if all slots are busy
+ */
+static stc_peer_t* getPeer(const char* pcIp)
+{
+  stc_peer_t* pFree = NULL;
+  for(int i = 0; i < IRGATEWAYPEERS_MAX_PEERS; i++)
+  {
+    if (strcmp(astcPeers[i].acIp,pcIp) == 0)
+    {
+      return &astcPeers[i];
+    }
+    //prefer unused slots, otherwise take over the connection of a peer without pending commands
+    if ((astcPeers[i].u8QueueLen == 0) && ((pFree == NULL) || ((pFree->acIp[0] != 0) && (astcPeers[i].acIp[0] == 0))))
+    {
+      pFree = &astcPeers[i];
+    }
+  }
+  if (pFree != NULL)
+  {
+    resetConnection(pFree);
+    strncpy(pFree->acIp,pcIp,sizeof(pFree->acIp) - 1);
+    pFree->acIp[sizeof(pFree->acIp) - 1] = 0;
+    pFree->u8QueueHead = 0;
+    pFree->u8Retries = 0;
+    pFree->u32Backoff = 0;
+  }
+  return pFree;
+}
+
+/**
+ * Remove the oldest command from the queue of a peer
+ * 
+ * \param pPeer peer slot
+ */
+static void popMessage(stc_peer_t* pPeer)
+{
+  astcMessages[pPeer->au8Queue[pPeer->u8QueueHead]].u8Refs--;
+  pPeer->u8QueueHead = (pPeer->u8QueueHead + 1) % PEER_QUEUE_SIZE;
+  pPeer->u8QueueLen--;
+  pPeer->u8Retries = 0;
+}
+
+/**
+ * Close the connection of a peer, commands without response are sent
+ * again on the next connection
+ * 
+ * \param pPeer peer slot
+ */
+static void resetConnection(stc_peer_t* pPeer)
+{
+  pPeer->client.stop();
+  pPeer->u8InFlight = 0;
+  pPeer->u8LineLen = 0;
+  pPeer->bStatusLine = true;
+  pPeer->bBody = false;
+  pPeer->bClose = false;
+  pPeer->u16BodyLeft = 0;
+}
+
+/**
+ * Open the connection to a peer
+ * 
+ * \param pPeer peer slot
+ * 
+ * \return false if the peer is not reachable
+ */
+static bool connectPeer(stc_peer_t* pPeer)
+{
+  IPAddress ip;
+  bool bConnected;
+
+  resetConnection(pPeer);
+  if (!ip.fromString(pPeer->acIp))
+  {
+    return false;
+  }
+#if defined(ARDUINO_ARCH_ESP32)
+  bConnected = pPeer->client.connect(ip,PEER_PORT,CONNECT_TIMEOUT_MS);
+#else
+  pPeer->client.setTimeout(CONNECT_TIMEOUT_MS);
+  bConnected = pPeer->client.connect(ip,PEER_PORT);
+#endif
+  if (bConnected)
+  {
+    pPeer->client.setNoDelay(true);
+  }
+  return bConnected;
+}
+
+/**
+ * Send all queued commands which were not sent yet on the open connection,
+ * without waiting for the responses of the commands sent before (pipelining)
+ * 
+ * \param pPeer peer slot
+ * 
+ * \return false if the connection is broken
+ */
+static bool writeRequests(stc_peer_t* pPeer)
+{
+  static char acBody[BODY_SIZE];
+  char acHeader[160];
+  int lenBody;
+  int lenHeader;
+
+  while(pPeer->u8InFlight < pPeer->u8QueueLen)
+  {
+    lenBody = formatBody(&astcMessages[pPeer->au8Queue[(pPeer->u8QueueHead + pPeer->u8InFlight) % PEER_QUEUE_SIZE]],acBody,sizeof(acBody));
+    lenHeader = snprintf(acHeader,sizeof(acHeader),"POST /api/cmd HTTP/1.1\r\nHost: %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\n\r\n",
+                         pPeer->acIp,lenBody);
+#if !defined(ARDUINO_ARCH_ESP32)
+    //pipeline only complete requests, try again in the next loop() if the send buffer is full,
+    //the first request is written in any case, a batch can be larger than the empty buffer
+    if ((pPeer->u8InFlight > 0) && (pPeer->client.availableForWrite() < (lenHeader + lenBody)))
+    {
+      return true;
+    }
+#endif
+    if ((pPeer->client.write((const uint8_t*)acHeader,lenHeader) != (size_t)lenHeader) ||
+        (pPeer->client.write((const uint8_t*)acBody,lenBody) != (size_t)lenBody))
+    {
+      return false;
+    }
+    if (pPeer->u8InFlight == 0)
+    {
+      pPeer->u32Since = millis();
+    }
+    pPeer->u8InFlight++;
+  }
+  return true;
+}
+
+/**
+ * Read the responses of pipelined commands, every complete response
+ * removes the oldest command from the queue
+ * 
+ * \param pPeer peer slot
+ * 
+ * \return false if the peer did not send a HTTP response
+ */
+static bool receiveResponses(stc_peer_t* pPeer)
+{
+  int c;
+  while((pPeer->u8InFlight > 0) && (pPeer->client.available() > 0))
+  {
+    c = pPeer->client.read();
+    if (c < 0)
+    {
+      break;
+    }
+    if (pPeer->bBody)
+    {
+      pPeer->u16BodyLeft--;
+    } else if (c != '\n')
+    {
+      if (pPeer->u8LineLen < (RESPONSE_LINE_SIZE - 1))
+      {
+        pPeer->acLine[pPeer->u8LineLen++] = c;
+      }
+      continue;
+    } else
+    {
+      if ((pPeer->u8LineLen > 0) && (pPeer->acLine[pPeer->u8LineLen - 1] == '\r'))
+      {
+        pPeer->u8LineLen--;
+      }
+      pPeer->acLine[pPeer->u8LineLen] = 0;
+      if (pPeer->bStatusLine)
+      {
+        if (strncmp(pPeer->acLine,"HTTP/",5) != 0)
+        {
+          return false;
+        }
+        pPeer->bStatusLine = false;
+      } else if (pPeer->u8LineLen == 0)
+      {
+        pPeer->bBody = true;
+      } else if (strncasecmp(pPeer->acLine,"Content-Length:",15) == 0)
+      {
+        pPeer->u16BodyLeft = atoi(&pPeer->acLine[15]);
+      } else if (strncasecmp(pPeer->acLine,"Connection: close",17) == 0)
+      {
+        pPeer->bClose = true;
+      }
+      pPeer->u8LineLen = 0;
+    }
+    if ((pPeer->bBody) && (pPeer->u16BodyLeft == 0))
+    {
+      //any HTTP response, the peer has executed the command
+      popMessage(pPeer);
+      pPeer->u8InFlight--;
+      pPeer->u32Backoff = 0;
+      pPeer->u32Since = millis();
+      pPeer->bStatusLine = true;
+      pPeer->bBody = false;
+      u32Sent++;
+      if (pPeer->bClose)
+      {
+        //the peer does not read the pipelined commands, send them again
+        resetConnection(pPeer);
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Handle a failed request, retry with backoff or drop the command
+ * 
+ * \param pPeer peer slot
+ */
+static void failed(stc_peer_t* pPeer)
+{
+  resetConnection(pPeer);
+  pPeer->u32Since = millis();
+  pPeer->u32Backoff = BACKOFF_BASE_MS << pPeer->u8Retries;
+  if (pPeer->u32Backoff > BACKOFF_MAX_MS)
+  {
+    pPeer->u32Backoff = BACKOFF_MAX_MS;
+  }
+  if (pPeer->u8Retries < MAX_RETRIES)
+  {
+    pPeer->u8Retries++;
+    u32Retries++;
+  } else
+  {
+    //keep the backoff, the next command of an offline peer is tried at most every BACKOFF_MAX_MS
+    popMessage(pPeer);
+    u32Dropped++;
+  }
+}
+
+/**
+ * Init peer replication
+ * 
+ * \param bUseMulticast true: UDP multicast, false: HTTP to each peer
+ */
+void IrGatewayPeers_Init(bool bUseMulticast)
+{
+  IPAddress group(IRGATEWAYPEERS_MULTICAST_GROUP);
+  memset(astcMessages,0,sizeof(astcMessages));
+  memset(astcOrigins,0,sizeof(astcOrigins));
+  //a restarted gateway keeps its IP address (origin), a random start avoids
+  //that the other gateways drop its first commands as already received
+#if defined(ARDUINO_ARCH_ESP32)
+  u32Seq = esp_random();
+#elif defined(ARDUINO_ARCH_ESP8266)
+  u32Seq = RANDOM_REG32;
+#else
+  u32Seq = rp2040.hwrand32();
+#endif
+  for(int i = 0; i < IRGATEWAYPEERS_MAX_PEERS; i++)
+  {
+    astcPeers[i].acIp[0] = 0;
+    astcPeers[i].u8QueueLen = 0;
+    resetConnection(&astcPeers[i]);
+  }
+  bMulticast = false;
+  if (bUseMulticast)
+  {
+#if defined(ARDUINO_ARCH_ESP32)
+    bMulticast = (udp.beginMulticast(group,IRGATEWAYPEERS_MULTICAST_PORT) != 0);
+#else
+    bMulticast = (udp.beginMulticast(WiFi.localIP(),group,IRGATEWAYPEERS_MULTICAST_PORT) != 0);
+#endif
+  }
+}
+
+/**
+ * Update peer replication in loop: send queued commands, collect responses
+ * and retry failed requests. At most one connect is done per call, the
+ * responses of all peers are awaited concurrently.
+ */
+void IrGatewayPeers_Update(void)
+{
+  stc_peer_t* pPeer;
+  bool bConnectDone = false;
+
+  if (bMulticast)
+  {
+    receiveMulticast();
+    return;
+  }
+  for(int i = 0; i < IRGATEWAYPEERS_MAX_PEERS; i++)
+  {
+    pPeer = &astcPeers[i];
+    if (pPeer->u8InFlight > 0)
+    {
+      if (!receiveResponses(pPeer))
+      {
+        failed(pPeer);
+        continue;
+      }
+      if ((pPeer->u8InFlight > 0) && ((!pPeer->client.connected()) || ((millis() - pPeer->u32Since) > RESPONSE_TIMEOUT_MS)))
+      {
+        failed(pPeer);
+        continue;
+      }
+    }
+    if (pPeer->u8InFlight >= pPeer->u8QueueLen)
+    {
+      continue;
+    }
+    if (!pPeer->client.connected())
+    {
+      //closed by the peer while idle or after a failure, connect blocks up to CONNECT_TIMEOUT_MS
+      //and is postponed while IR frames are waiting, local IR transmission is never delayed
+      if ((bConnectDone) || ((millis() - pPeer->u32Since) < pPeer->u32Backoff) || (Maerklin292xxIr_GetQueueCount() != 0))
+      {
+        continue;
+      }
+      bConnectDone = true;
+      if (!connectPeer(pPeer))
+      {
+        failed(pPeer);
+        continue;
+      }
+    }
+    if (!writeRequests(pPeer))
+    {
+      failed(pPeer);
+    }
+  }
+}
+
+/**
+ * Create the JSON body of POST /api/cmd, a single command in the format
+ * of older gateways, a batch with the delays between the commands
+ * 
+ * \param pMessage command or batch
+ * 
+ * \param pcBody buffer
+ * 
+ * \param size size of the buffer, BODY_SIZE is enough for IRGATEWAYPEERS_MAX_ENTRIES commands
+ * 
+ * \return length of the body
+ */
+static int formatBody(const stc_peer_message_t* pMessage, char* pcBody, int size)
+{
+  const stc_irgateway_cmd_t* pCmd = &pMessage->astcCmds[0];
+  char acChannel[16] = {0};
+  char acArg[8] = {0};
+  int len;
+
+  if ((pMessage->u8Count == 1) && (pCmd->u16OffsetMs == 0))
+  {
+    acChannel[0] = pCmd->channel;
+    if ((pCmd->u8Cmd == enIrGatewayCmdSpeed) || (pCmd->u8Cmd == enIrGatewayCmdSound))
+    {
+      snprintf(acArg,sizeof(acArg),"%d",pCmd->i8Arg);
+    }
+    return snprintf(pcBody,size,"{\"channel\":\"%s\",\"cmd\":\"%s\",\"args\":\"%s\",\"repeated\":\"true\"}",
+                    acChannel,apcCommandNames[pCmd->u8Cmd],acArg);
+  }
+  len = snprintf(pcBody,size,"{\"repeated\":\"true\",\"commands\":[");
+  for(int i = 0; i < pMessage->u8Count; i++)
+  {
+    pCmd = &pMessage->astcCmds[i];
+    acChannel[0] = 0;
+    if (pCmd->channel != 0)
+    {
+      snprintf(acChannel,sizeof(acChannel),"\"channel\":\"%c\",",pCmd->channel);
+    }
+    len += snprintf(&pcBody[len],size - len,"%s{%s\"cmd\":\"%s\",\"args\":%d,\"delay\":%u}",(i == 0) ? "" : ",",
+                    acChannel,apcCommandNames[pCmd->u8Cmd],pCmd->i8Arg,
+                    (unsigned)(pCmd->u16OffsetMs - ((i == 0) ? 0 : pMessage->astcCmds[i - 1].u16OffsetMs)));
+  }
+  len += snprintf(&pcBody[len],size - len,"]}");
+  return len;
+}
+
+/**
+ * Queue a command or batch for all peers found via mDNS
+ * 
+ * \param pastcCmds commands
+ * 
+ * \param u8Count number of commands, 1...IRGATEWAYPEERS_MAX_ENTRIES
+ */
+static void sendHttp(const stc_irgateway_cmd_t* pastcCmds, uint8_t u8Count)
+{
+  stc_peer_message_t* pMessage = NULL;
+  stc_peer_t* pPeer;
+  uint8_t u8Message;
+
+  if (MdnsClientList_Count() == 0)
+  {
+    return;
+  }
+  for(u8Message = 0; u8Message < MAX_MESSAGES; u8Message++)
+  {
+    if (astcMessages[u8Message].u8Refs == 0)
+    {
+      pMessage = &astcMessages[u8Message];
+      break;
+    }
+  }
+  if (pMessage == NULL)
+  {
+    u32Dropped += MdnsClientList_Count();
+    return;
+  }
+  memcpy(pMessage->astcCmds,pastcCmds,u8Count * sizeof(stc_irgateway_cmd_t));
+  pMessage->u8Count = u8Count;
+  for(int i = 0; i < MdnsClientList_Count(); i++)
+  {
+    pPeer = getPeer(MdnsClientList_GetIPString(i));
+    if (pPeer == NULL)
+    {
+      u32Dropped++;
+      continue;
+    }
+    if (pPeer->u8QueueLen >= PEER_QUEUE_SIZE)
+    {
+      //a newer command is more important than an old one of a slow peer,
+      //the responses of pipelined commands can not be assigned anymore
+      if (pPeer->u8InFlight > 0)
+      {
+        resetConnection(pPeer);
+      }
+      popMessage(pPeer);
+      u32Dropped++;
+    }
+    pPeer->au8Queue[(pPeer->u8QueueHead + pPeer->u8QueueLen) % PEER_QUEUE_SIZE] = u8Message;
+    pPeer->u8QueueLen++;
+    pMessage->u8Refs++;
+  }
+}
+
+/**
+ * Send a command or batch to all gateways with one multicast datagram
+ * 
+ * \param pastcCmds commands
+ * 
+ * \param u8Count number of commands, 1...IRGATEWAYPEERS_MAX_ENTRIES
+ */
+static void sendMulticast(const stc_irgateway_cmd_t* pastcCmds, uint8_t u8Count)
+{
+  uint8_t au8Packet[PACKET_SIZE];
+  uint8_t* pu8Entry;
+  uint32_t u32Origin = (uint32_t)WiFi.localIP();
+  IPAddress group(IRGATEWAYPEERS_MULTICAST_GROUP);
+  int len = IRGATEWAYPEERS_HEADER_SIZE + u8Count * IRGATEWAYPEERS_ENTRY_SIZE;
+
+  u32Seq++;
+  memset(au8Packet,0,sizeof(au8Packet));
+  au8Packet[0] = IRGATEWAYPEERS_MAGIC;
+  au8Packet[1] = u8Count;
+  for(int i = 0; i < 4; i++)
+  {
+    au8Packet[4 + i] = u32Origin >> (i * 8);
+    au8Packet[8 + i] = u32Seq >> (i * 8);
+  }
+  for(int i = 0; i < u8Count; i++)
+  {
+    pu8Entry = &au8Packet[IRGATEWAYPEERS_HEADER_SIZE + i * IRGATEWAYPEERS_ENTRY_SIZE];
+    pu8Entry[0] = pastcCmds[i].channel;
+    pu8Entry[1] = pastcCmds[i].u8Cmd;
+    pu8Entry[2] = pastcCmds[i].i8Arg;
+    pu8Entry[4] = pastcCmds[i].u16OffsetMs;
+    pu8Entry[5] = pastcCmds[i].u16OffsetMs >> 8;
+  }
+  for(int i = 0; i < MULTICAST_COPIES; i++)
+  {
+    udp.beginPacket(group,IRGATEWAYPEERS_MULTICAST_PORT);
+    udp.write(au8Packet,len);
+    udp.endPacket();
+  }
+  u32MulticastSent++;
+}
+
+/**
+ * Check the sequence number of a datagram against the window of its origin
+ * 
+ * \param u32Origin origin of the datagram
+ * 
+ * \param u32Seq sequence number of the datagram
+ * 
+ * \return true if the datagram was not received before
+ */
+static bool isNewSequence(uint32_t u32Origin, uint32_t u32Seq)
+{
+  stc_peer_origin_t* pOrigin = &astcOrigins[0];
+  int32_t i32Diff;
+
+  for(int i = 0; i < MAX_ORIGINS; i++)
+  {
+    if (astcOrigins[i].u32Origin == u32Origin)
+    {
+      pOrigin = &astcOrigins[i];
+      break;
+    }
+    //otherwise use a free slot or the gateway not heard from for the longest time
+    if ((pOrigin->u32Origin != 0) && ((astcOrigins[i].u32Origin == 0) || ((millis() - astcOrigins[i].u32LastSeen) > (millis() - pOrigin->u32LastSeen))))
+    {
+      pOrigin = &astcOrigins[i];
+    }
+  }
+  pOrigin->u32LastSeen = millis();
+  i32Diff = (int32_t)(u32Seq - pOrigin->u32LastSeq);
+  if ((pOrigin->u32Origin != u32Origin) || (i32Diff <= -SEQUENCE_WINDOW))
+  {
+    //new origin, or the origin was restarted with a new random sequence number
+    pOrigin->u32Origin = u32Origin;
+    pOrigin->u32LastSeq = u32Seq;
+    pOrigin->u32Window = 1;
+    return true;
+  }
+  if (i32Diff > 0)
+  {
+    pOrigin->u32Window = (i32Diff < SEQUENCE_WINDOW) ? ((pOrigin->u32Window << i32Diff) | 1) : 1;
+    pOrigin->u32LastSeq = u32Seq;
+    return true;
+  }
+  if (pOrigin->u32Window & (1UL << -i32Diff))
+  {
+    return false;
+  }
+  pOrigin->u32Window |= (1UL << -i32Diff);
+  return true;
+}
+
+/**
+ * Execute commands received from other gateways via multicast
+ */
+static void receiveMulticast(void)
+{
+  uint8_t au8Packet[PACKET_SIZE];
+  stc_irgateway_cmd_t astcBatch[IRGATEWAYPEERS_MAX_ENTRIES];
+  uint8_t u8Count;
+  uint32_t u32Origin;
+  uint32_t u32PacketSeq;
+  uint8_t* pu8Entry;
+  int len;
+
+  for(int i = 0; i < MAX_PACKETS_PER_UPDATE; i++)
+  {
+    len = udp.parsePacket();
+    if (len <= 0)
+    {
+      return;
+    }
+    if ((len > (int)sizeof(au8Packet)) || (udp.read(au8Packet,len) != len) || (len < IRGATEWAYPEERS_HEADER_SIZE) ||
+        (au8Packet[0] != IRGATEWAYPEERS_MAGIC) || (len != IRGATEWAYPEERS_HEADER_SIZE + au8Packet[1] * IRGATEWAYPEERS_ENTRY_SIZE))
+    {
+      continue;
+    }
+    u32Origin = au8Packet[4] | (au8Packet[5] << 8) | (au8Packet[6] << 16) | ((uint32_t)au8Packet[7] << 24);
+    u32PacketSeq = au8Packet[8] | (au8Packet[9] << 8) | (au8Packet[10] << 16) | ((uint32_t)au8Packet[11] << 24);
+    if ((u32Origin == 0) || (u32Origin == (uint32_t)WiFi.localIP()))
+    {
+      //own datagram, multicast is looped back
+      continue;
+    }
+    if (!isNewSequence(u32Origin,u32PacketSeq))
+    {
+      u32MulticastDuplicates++;
+      continue;
+    }
+    u32MulticastReceived++;
+    u8Count = 0;
+    for(int n = 0; n < au8Packet[1]; n++)
+    {
+      pu8Entry = &au8Packet[IRGATEWAYPEERS_HEADER_SIZE + n * IRGATEWAYPEERS_ENTRY_SIZE];
+      if (((pu8Entry[0] == 0) || ((pu8Entry[0] >= 'A') && (pu8Entry[0] <= 'J'))) && (pu8Entry[1] <= enIrGatewayCmdKeepAlive))
+      {
+        astcBatch[u8Count].channel = (char)pu8Entry[0];
+        astcBatch[u8Count].u8Cmd = pu8Entry[1];
+        astcBatch[u8Count].i8Arg = (int8_t)pu8Entry[2];
+        astcBatch[u8Count].u16OffsetMs = pu8Entry[4] | (pu8Entry[5] << 8);
+        u8Count++;
+      }
+    }
+    //delays are relative to the reception, the datagram is not delayed by the network
+    IrGatewayWebServer_ExecuteBatch(astcBatch,u8Count);
+  }
+}
+
+/**
+ * Send a command or a batch of commands to all other gateways as one
+ * message, returns at once
+ * 
+ * \param pastcCmds commands, ascending u16OffsetMs
+ * 
+ * \param u8Count number of commands
+ */
+void IrGatewayPeers_Send(const stc_irgateway_cmd_t* pastcCmds, uint8_t u8Count)
+{
+  stc_irgateway_cmd_t astcValid[IRGATEWAYPEERS_MAX_ENTRIES];
+  uint8_t u8Valid = 0;
+  for(int i = 0; (i < u8Count) && (u8Valid < IRGATEWAYPEERS_MAX_ENTRIES); i++)
+  {
+    if ((pastcCmds[i].u8Cmd != enIrGatewayCmdUnknown) && (pastcCmds[i].u8Cmd <= enIrGatewayCmdKeepAlive))
+    {
+      astcValid[u8Valid++] = pastcCmds[i];
+    }
+  }
+  if (u8Valid == 0)
+  {
+    return;
+  }
+  if (bMulticast)
+  {
+    sendMulticast(astcValid,u8Valid);
+  } else
+  {
+    sendHttp(astcValid,u8Valid);
+  }
+}
+
+/**
+ * Get counters of the peer replication
+ * 
+ * \param pu32Sent commands delivered to a peer
+ * 
+ * \param pu32Retries failed requests which were retried
+ * 
+ * \param pu32Dropped commands not delivered after all retries or because queues were full
+ */
+void IrGatewayPeers_GetStats(uint32_t* pu32Sent, uint32_t* pu32Retries, uint32_t* pu32Dropped)
+{
+  *pu32Sent = u32Sent;
+  *pu32Retries = u32Retries;
+  *pu32Dropped = u32Dropped;
+}
+
+/**
+ * Get counters of the multicast replication
+ * 
+ * \param pu32Sent commands sent
+ * 
+ * \param pu32Received commands received from other gateways
+ * 
+ * \param pu32Duplicates copies and retransmissions dropped by the sequence window
+ */
+void IrGatewayPeers_GetMulticastStats(uint32_t* pu32Sent, uint32_t* pu32Received, uint32_t* pu32Duplicates)
+{
+  *pu32Sent = u32MulticastSent;
+  *pu32Received = u32MulticastReceived;
+  *pu32Duplicates = u32MulticastDuplicates;
+}
+
+/**
+ *******************************************************************************
+ ** EOF (not truncated)
+ *******************************************************************************
+ */
@@ -0,0 +1,145 @@
+/**
+ *******************************************************************************
+ ** Copyright © 2021 io-expert.com. All rights reserved.
+ **
+ ** 1. Redistributions of source code must retain the above copyright notice,
+ **    this condition and the following disclaimer.
+ **
+ ** This software is provided by the copyright holder and contributors "AS IS"
+ ** and any warranties related to this software are DISCLAIMED.
+ ** The copyright owner or contributors be NOT LIABLE for any damages caused
+ ** by use of this software.
+
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ **\file irgatewaypeers.h
+ **
+ ** Command replication to peer gateways
+ ** A detailed description is available at
+ ** @link IrGatewayPeersGroup file description @endlink
+ **
+ ** History:
+ ** - 2026-10-17  1.00  First version, forwards /api/cmd to peer gateways from loop()
+ *******************************************************************************
+ */
+
+#if !defined(__IRGATEWAYPEERS_H__)
+#define __IRGATEWAYPEERS_H__
+
+///* C binding of definitions if building with C++ compiler */
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif
+
+/**
+ *******************************************************************************
+ ** \defgroup IrGatewayPeersGroup Command replication to peer gateways
+ **
+ ** Provided functions of IrGatewayPeers:
+ **
+ ** Commands received via /api/cmd are forwarded to all other gateways, a
+ ** batch of commands is forwarded as one message.
+ **
+ ** UDP multicast: one datagram per command or batch to
+ ** IRGATEWAYPEERS_MULTICAST_GROUP:IRGATEWAYPEERS_MULTICAST_PORT, independent
+ ** of the number of gateways. Every datagram carries the IP address of the
+ ** sending gateway as origin and a sequence number, receivers drop copies
+ ** and retransmissions with a window of the last 32 sequence numbers per origin.
+ ** The sequence number starts at a random value after every boot.
+ **
+ ** Byte 0      'R' (magic)
+ ** Byte 1      number of commands n
+ ** Byte 2,3    reserved, 0
+ ** Byte 4...7  origin, little endian
+ ** Byte 8...11 sequence number, little endian
+ ** n times 6 bytes:
+ **   channel 'A'...'J' or 0, command (en_irgateway_cmd_t), argument (int8), reserved,
+ **   offset in ms after the first command of the batch (little endian)
+ **
+ ** HTTP (default): POST /api/cmd with "repeated":"true" to all gateways found via mDNS
+ ** (service "irgateway"). IrGatewayPeers_Send() only queues the command,
+ ** IrGatewayPeers_Update() sends it from loop(). Every peer has its own queue,
+ ** connection, timeouts and retries with backoff, a slow or offline peer does
+ ** not delay the others.
+ **
+ *******************************************************************************
+ */
+
+//@{
+
+/**
+ *******************************************************************************
+** \page irgatewaypeers_module_includes Required includes in main application
+** \brief Following includes are required
+** @code
+** #include "irgatewaypeers.h"
+** @endcode
+**
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** (Global) Include files
+ *******************************************************************************
+ */
+
+#include <stdint.h>
+#include "irgatewaywebserver.h"
+
+/**
+ *******************************************************************************
+ ** Global pre-processor symbols/macros ('#define')
+ *******************************************************************************
+ */
+
+#define IRGATEWAYPEERS_MAX_PEERS 10     //same as MAX_REMOTE_STATIONS of mdnsclientlist.cpp
+
+#define IRGATEWAYPEERS_MULTICAST_GROUP 239,255,29,2
+#define IRGATEWAYPEERS_MULTICAST_PORT 2562
+#define IRGATEWAYPEERS_MAGIC 'R'
+#define IRGATEWAYPEERS_HEADER_SIZE 12
+#define IRGATEWAYPEERS_ENTRY_SIZE 6
+#define IRGATEWAYPEERS_MAX_ENTRIES IRGATEWAYWEBSERVER_MAX_BATCH
+
+/**
+ *******************************************************************************
+ ** Global type definitions ('typedef')
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** Global variable declarations ('extern', definition in C source)
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** Global function prototypes ('extern', definition in C source)
+ *******************************************************************************
+ */
+
+void IrGatewayPeers_Init(bool bMulticast);
+void IrGatewayPeers_Update(void);
+void IrGatewayPeers_Send(const stc_irgateway_cmd_t* pastcCmds, uint8_t u8Count);
+void IrGatewayPeers_GetStats(uint32_t* pu32Sent, uint32_t* pu32Retries, uint32_t* pu32Dropped);
+void IrGatewayPeers_GetMulticastStats(uint32_t* pu32Sent, uint32_t* pu32Received, uint32_t* pu32Duplicates);
+
+//@} // IrGatewayPeersGroup
+
+//#ifdef __cplusplus
+//}
+//#endif
+
+#endif /* __IRGATEWAYPEERS_H__ */
+
+/**
+ *******************************************************************************
+ ** EOF (not truncated)
+ *******************************************************************************
+ */
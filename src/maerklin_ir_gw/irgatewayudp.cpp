@@ -0,0 +1,252 @@
+/**
+ *******************************************************************************
+ ** Copyright © 2021 io-expert.com. All rights reserved.
+ **
+ ** 1. Redistributions of source code must retain the above copyright notice,
+ **    this condition and the following disclaimer.
+ **
+ ** This software is provided by the copyright holder and contributors "AS IS"
+ ** and any warranties related to this software are DISCLAIMED.
+ ** The copyright owner or contributors be NOT LIABLE for any damages caused
+ ** by use of this software.
+
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ **\file irgatewayudp.cpp
+ **
+ ** UDP command interface of the IR gateway
+ ** A detailed description is available at
+ ** @link IrGatewayUdpGroup file description @endlink
+ **
+ ** History:
+ ** - 2026-10-17  1.00  First version, UDP command interface
+ *******************************************************************************
+ */
+
+#define __IRGATEWAYUDP_C__
+
+/**
+ *******************************************************************************
+ ** Include files
+ *******************************************************************************
+ */
+
+#include <Arduino.h>
+
+#if defined(ARDUINO_ARCH_ESP8266)
+  #include <ESP8266WiFi.h>
+  #include <WiFiUdp.h>
+#elif defined(ARDUINO_ARCH_ESP32)
+  #include <WiFi.h>
+  #include <WiFiUdp.h>
+#elif defined(ARDUINO_ARCH_RP2040)
+  #include <WiFi.h>
+  #include <WiFiUdp.h>
+#else
+#error Not supported architecture
+#endif
+
+#include "irgatewayudp.h"
+#include "irgatewaywebserver.h"
+#include "../wifimcu/wifimcuctrl.h"
+
+/**
+ *******************************************************************************
+ ** Local pre-processor symbols/macros ('#define') 
+ *******************************************************************************
+ */
+
+#define MAX_PACKETS_PER_UPDATE 8   //keeps loop() responsive while a client floods the port
+
+/**
+ *******************************************************************************
+ ** Global variable definitions (declared in header file with 'extern') 
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** Local type definitions ('typedef') 
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** Local variable definitions ('static') 
+ *******************************************************************************
+ */
+
+static WiFiUDP udp;
+static bool bStarted = false;
+static uint32_t u32Received = 0;
+static uint32_t u32Invalid = 0;
+static uint32_t u32Duplicates = 0;
+
+//last executed packet, a retransmission is acknowledged again but not executed
+static IPAddress lastIp;
+static uint16_t u16LastPort = 0;
+static uint16_t u16LastSeq = 0;
+static bool bLastValid = false;
+
+static const en_irgateway_cmd_t aenCommands[] = {
+  enIrGatewayCmdStop,       //enIrGatewayUdpCmdStop
+  enIrGatewayCmdForward,    //enIrGatewayUdpCmdForward
+  enIrGatewayCmdBackward,   //enIrGatewayUdpCmdBackward
+  enIrGatewayCmdLight,      //enIrGatewayUdpCmdLight
+  enIrGatewayCmdSound,      //enIrGatewayUdpCmdSound
+  enIrGatewayCmdSpeed,      //enIrGatewayUdpCmdSpeed
+  enIrGatewayCmdKeepAlive,  //enIrGatewayUdpCmdKeepAlive
+};
+
+/**
+ *******************************************************************************
+ ** Local function prototypes ('static') 
+ *******************************************************************************
+ */
+
+static bool execute(uint8_t* pu8Packet);
+static void sendAck(uint16_t u16Seq, uint8_t u8Status);
+
+/**
+ *******************************************************************************
+ ** Function implementation - global ('extern') and local ('static') 
+ *******************************************************************************
+ */
+
+/**
+ * Execute a command packet
+ * 
+ * \param pu8Packet packet of IRGATEWAYUDP_PACKET_SIZE bytes
+ * 
+ * \return false if the packet is invalid
+ */
+static bool execute(uint8_t* pu8Packet)
+{
+  uint8_t u8Cmd = pu8Packet[5];
+  int8_t i8Arg = (int8_t)pu8Packet[6];
+
+  if (u8Cmd >= (sizeof(aenCommands) / sizeof(aenCommands[0])))
+  {
+    return false;
+  }
+  if ((pu8Packet[4] != 0) && ((pu8Packet[4] < 'A') || (pu8Packet[4] > 'J')))
+  {
+    return false;
+  }
+  IrGatewayWebServer_ExecuteCommand((char)pu8Packet[4],aenCommands[u8Cmd],i8Arg);
+  return true;
+}
+
+/**
+ * Send acknowledge to the sender of the current packet
+ * 
+ * \param u16Seq sequence number of the packet
+ * 
+ * \param u8Status 0 = ok, 1 = invalid
+ */
+static void sendAck(uint16_t u16Seq, uint8_t u8Status)
+{
+  uint8_t au8Ack[IRGATEWAYUDP_ACK_SIZE];
+  au8Ack[0] = IRGATEWAYUDP_MAGIC_ACK;
+  au8Ack[1] = u8Status;
+  au8Ack[2] = u16Seq & 0xFF;
+  au8Ack[3] = u16Seq >> 8;
+  udp.beginPacket(udp.remoteIP(),udp.remotePort());
+  udp.write(au8Ack,sizeof(au8Ack));
+  udp.endPacket();
+}
+
+/**
+ * Init UDP command interface
+ * 
+ * \param u16Port UDP port, 0 to disable
+ */
+void IrGatewayUdp_Init(uint16_t u16Port)
+{
+  if (u16Port == 0)
+  {
+    return;
+  }
+  bStarted = (udp.begin(u16Port) != 0);
+}
+
+/**
+ * Update UDP command interface in loop, executes received packets
+ */
+void IrGatewayUdp_Update(void)
+{
+  uint8_t au8Packet[IRGATEWAYUDP_PACKET_SIZE];
+  uint16_t u16Seq;
+  bool bOk;
+  int len;
+
+  if (!bStarted)
+  {
+    return;
+  }
+  for(int i = 0; i < MAX_PACKETS_PER_UPDATE; i++)
+  {
+    len = udp.parsePacket();
+    if (len <= 0)
+    {
+      return;
+    }
+    u32Received++;
+    if ((len != IRGATEWAYUDP_PACKET_SIZE) || (udp.read(au8Packet,sizeof(au8Packet)) != IRGATEWAYUDP_PACKET_SIZE) || (au8Packet[0] != IRGATEWAYUDP_MAGIC))
+    {
+      //not for us, no acknowledge
+      u32Invalid++;
+      continue;
+    }
+    WifiMcuCtrl_KeepAlive();
+    u16Seq = au8Packet[2] | (au8Packet[3] << 8);
+    if ((bLastValid) && (udp.remoteIP() == lastIp) && (udp.remotePort() == u16LastPort) && (u16Seq == u16LastSeq))
+    {
+      //retransmission, the acknowledge was lost
+      u32Duplicates++;
+      bOk = true;
+    } else
+    {
+      bOk = execute(au8Packet);
+      if (bOk)
+      {
+        lastIp = udp.remoteIP();
+        u16LastPort = udp.remotePort();
+        u16LastSeq = u16Seq;
+        bLastValid = true;
+      } else
+      {
+        u32Invalid++;
+      }
+    }
+    if (au8Packet[1] & IRGATEWAYUDP_FLAG_ACK)
+    {
+      sendAck(u16Seq, bOk ? 0 : 1);
+    }
+  }
+}
+
+/**
+ * Get counters of the UDP command interface
+ * 
+ * \param pu32Received received packets
+ * 
+ * \param pu32Invalid packets with wrong size, magic or command
+ * 
+ * \param pu32Duplicates retransmitted packets, acknowledged but not executed
+ */
+void IrGatewayUdp_GetStats(uint32_t* pu32Received, uint32_t* pu32Invalid, uint32_t* pu32Duplicates)
+{
+  *pu32Received = u32Received;
+  *pu32Invalid = u32Invalid;
+  *pu32Duplicates = u32Duplicates;
+}
+
+/**
+ *******************************************************************************
+ ** EOF (not truncated)
+ *******************************************************************************
+ */
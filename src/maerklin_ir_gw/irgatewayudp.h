@@ -0,0 +1,137 @@
+/**
+ *******************************************************************************
+ ** Copyright © 2021 io-expert.com. All rights reserved.
+ **
+ ** 1. Redistributions of source code must retain the above copyright notice,
+ **    this condition and the following disclaimer.
+ **
+ ** This software is provided by the copyright holder and contributors "AS IS"
+ ** and any warranties related to this software are DISCLAIMED.
+ ** The copyright owner or contributors be NOT LIABLE for any damages caused
+ ** by use of this software.
+
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ **\file irgatewayudp.h
+ **
+ ** UDP command interface of the IR gateway
+ ** A detailed description is available at
+ ** @link IrGatewayUdpGroup file description @endlink
+ **
+ ** History:
+ ** - 2026-10-17  1.00  First version, UDP command interface
+ *******************************************************************************
+ */
+
+#if !defined(__IRGATEWAYUDP_H__)
+#define __IRGATEWAYUDP_H__
+
+///* C binding of definitions if building with C++ compiler */
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif
+
+/**
+ *******************************************************************************
+ ** \defgroup IrGatewayUdpGroup UDP command interface of the IR gateway
+ **
+ ** Provided functions of IrGatewayUdp:
+ **
+ ** One datagram carries one command, same commands as /cmd/... :
+ **
+ ** Byte 0    'M' (magic)
+ ** Byte 1    flags, bit 0: acknowledge requested
+ ** Byte 2,3  sequence number, little endian
+ ** Byte 4    channel 'A'...'J', 0 for the current channel
+ ** Byte 5    command, see en_irgateway_udp_cmd_t
+ ** Byte 6    argument, speed -3...3 or sound 1...3
+ ** Byte 7    reserved, 0
+ **
+ ** Acknowledge: 'm', status (0 = ok, 1 = invalid), sequence number
+ **
+ *******************************************************************************
+ */
+
+//@{
+
+/**
+ *******************************************************************************
+** \page irgatewayudp_module_includes Required includes in main application
+** \brief Following includes are required
+** @code
+** #include "irgatewayudp.h"
+** @endcode
+**
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** (Global) Include files
+ *******************************************************************************
+ */
+
+#include <stdint.h>
+
+/**
+ *******************************************************************************
+ ** Global pre-processor symbols/macros ('#define') 
+ *******************************************************************************
+ */
+
+#define IRGATEWAYUDP_PACKET_SIZE 8
+#define IRGATEWAYUDP_ACK_SIZE 4
+#define IRGATEWAYUDP_MAGIC 'M'
+#define IRGATEWAYUDP_MAGIC_ACK 'm'
+#define IRGATEWAYUDP_FLAG_ACK 0x01
+
+/**
+ *******************************************************************************
+ ** Global type definitions ('typedef') 
+ *******************************************************************************
+ */
+
+typedef enum en_irgateway_udp_cmd
+{
+  enIrGatewayUdpCmdStop = 0,
+  enIrGatewayUdpCmdForward = 1,
+  enIrGatewayUdpCmdBackward = 2,
+  enIrGatewayUdpCmdLight = 3,
+  enIrGatewayUdpCmdSound = 4,
+  enIrGatewayUdpCmdSpeed = 5,
+  enIrGatewayUdpCmdKeepAlive = 6,
+} en_irgateway_udp_cmd_t;
+
+/**
+ *******************************************************************************
+ ** Global variable declarations ('extern', definition in C source)
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** Global function prototypes ('extern', definition in C source) 
+ *******************************************************************************
+ */
+
+void IrGatewayUdp_Init(uint16_t u16Port);
+void IrGatewayUdp_Update(void);
+void IrGatewayUdp_GetStats(uint32_t* pu32Received, uint32_t* pu32Invalid, uint32_t* pu32Duplicates);
+
+//@} // IrGatewayUdpGroup
+
+//#ifdef __cplusplus
+//}
+//#endif
+
+#endif /* __IRGATEWAYUDP_H__ */
+
+/**
+ *******************************************************************************
+ ** EOF (not truncated)
+ *******************************************************************************
+ */
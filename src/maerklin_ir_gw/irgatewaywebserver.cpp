@@ -41,15 +41,12 @@
 #if defined(ARDUINO_ARCH_ESP8266)
   #include <ESP8266WiFi.h>
   #include <ESP8266WebServer.h>
-  #include <ESP8266HTTPClient.h>
   #include <uri/UriBraces.h>
 #elif defined(ARDUINO_ARCH_ESP32)
   #include <WebServer.h>
-  #include <HTTPClient.h>
   #include <WiFi.h>
 #elif defined(ARDUINO_ARCH_RP2040)
   #include <WebServer.h>
-  #include <HTTPClient.h>
   #include <WiFi.h>
 #else
 #error Not supported architecture
@@ -62,8 +59,10 @@
 #include "irgatewaywebserver.h"
 #include "../wifimcu/htmlfs.h"
 #include "../wifimcu/wifimcuctrl.h"
-#include "../mdns/mdnsclientlist.h"
+#include "irgatewaypeers.h"
 #include "maerklin292xxir.h"
+#include "locodatabase.h"
+#include "../withrottle/withrottle.h"
 
 
 /**
@@ -74,6 +73,8 @@
 
 #pragma GCC optimize ("-O3")
 
+#define COMMAND_HASH_SIZE 8 //power of 2, see commandHash()
+
 /**
  *******************************************************************************
  ** Global variable definitions (declared in header file with 'extern') 
@@ -98,7 +99,7 @@
 
 //static ESPHTTPUpdateServer httpUpdater;
 
-StaticJsonDocument<256> doc;
+StaticJsonDocument<2048> doc; //a batch of IRGATEWAYWEBSERVER_MAX_BATCH commands
 
 #if defined(ARDUINO_ARCH_ESP8266)
 static ESP8266WebServer* pServer;
@@ -106,17 +107,68 @@ static ESP8266WebServer* pServer;
 static WebServer* pServer;
 #endif
 
-WiFiClient client;
-HTTPClient httpClient;
-
 static en_maerklin_292xx_ir_address_t enIrAddress = enMaerklin292xxIrAddressA;
+
+//delayed commands of batches, executed from IrGatewayWebServer_RunScheduled()
+static struct {
+    stc_irgateway_cmd_t stcCmd;
+    uint32_t u32Due;
+    uint32_t u32Order;         //commands due at the same time are executed in the order they were queued
+    bool bUsed;
+} astcScheduled[IRGATEWAYWEBSERVER_MAX_SCHEDULED];
+static uint32_t u32ScheduledOrder = 0;
+
+static const struct {
+    char channel;
+    en_maerklin_292xx_ir_address_t enAddress;
+} astcChannels[] = {
+    {'A',enMaerklin292xxIrAddressA},
+    {'B',enMaerklin292xxIrAddressB},
+    {'C',enMaerklin292xxIrAddressC},
+    {'D',enMaerklin292xxIrAddressD},
+    {'G',enMaerklin292xxIrAddressG},
+    {'H',enMaerklin292xxIrAddressH},
+    {'I',enMaerklin292xxIrAddressI},
+    {'J',enMaerklin292xxIrAddressJ},
+};
+
+//channel letter - 'A' to IR address, 0 = not a channel
+static const uint8_t au8ChannelAddresses[26] = {
+    enMaerklin292xxIrAddressA,enMaerklin292xxIrAddressB,enMaerklin292xxIrAddressC,enMaerklin292xxIrAddressD,
+    0,0,
+    enMaerklin292xxIrAddressG,enMaerklin292xxIrAddressH,enMaerklin292xxIrAddressI,enMaerklin292xxIrAddressJ,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+};
+
+//commands indexed by commandHash(), the hash has no collisions for these names
+static const struct {
+    const char* pcName;
+    en_irgateway_cmd_t enCmd;
+} astcCommands[COMMAND_HASH_SIZE] = {
+    {"light",enIrGatewayCmdLight},          //0
+    {"backward",enIrGatewayCmdBackward},    //1
+    {NULL,enIrGatewayCmdUnknown},           //2
+    {"keepalive",enIrGatewayCmdKeepAlive},  //3
+    {"speed",enIrGatewayCmdSpeed},          //4
+    {"sound",enIrGatewayCmdSound},          //5
+    {"forward",enIrGatewayCmdForward},      //6
+    {"stop",enIrGatewayCmdStop},            //7
+};
 /**
  *******************************************************************************
  ** Local function prototypes ('static') 
  *******************************************************************************
  */
 
-static void processCommand(String channel, String command, String commandArg);
+static uint32_t commandHash(const char* command, uint32_t u32Len);
+static en_irgateway_cmd_t parseCommand(const char* command);
+static char parseChannel(const char* channel);
+static int parseArgument(en_irgateway_cmd_t enCmd, const char* commandArg);
+static void processCommand(const char* channel, const char* command, const char* commandArg);
+static void executeAndForward(char channel, en_irgateway_cmd_t enCmd, int iArg, bool bForward);
+static bool parseBatchEntry(JsonVariant entry, uint32_t* pu32Offset, stc_irgateway_cmd_t* pstcCmd);
+static void resolveChannels(stc_irgateway_cmd_t* pastcCmds, uint8_t u8Count);
+static void handleStatsAPI(void);
 
 /**
  *******************************************************************************
@@ -124,75 +176,370 @@ static void processCommand(String channel, String command, String commandArg);
  *******************************************************************************
  */
 
-static void processCommand(String channel, String command, String commandArg)
+/*
+ * Perfect hash of the command names, see astcCommands[]
+ * 
+ * \param command command name, at least the terminating zero is read
+ * 
+ * \param u32Len length of the command name
+ */
+static uint32_t commandHash(const char* command, uint32_t u32Len)
 {
-    WifiMcuCtrl_KeepAlive();
-    if (channel != "")
+    return ((uint8_t)command[0] * 5 + (uint8_t)command[1] * 7 + u32Len) & (COMMAND_HASH_SIZE - 1);
+}
+
+/*
+ * Look up a command name
+ * 
+ * \param command command name, NULL allowed
+ * 
+ * \return command, enIrGatewayCmdUnknown if not found
+ */
+static en_irgateway_cmd_t parseCommand(const char* command)
+{
+    uint32_t u32Hash;
+    if ((command == NULL) || (command[0] == 0))
     {
-        if (channel == "A")
-        {
-           enIrAddress = enMaerklin292xxIrAddressA;
-        } else if (channel == "B")
+        return enIrGatewayCmdUnknown;
+    }
+    u32Hash = commandHash(command,strlen(command));
+    if ((astcCommands[u32Hash].pcName == NULL) || (strcmp(astcCommands[u32Hash].pcName,command) != 0))
+    {
+        return enIrGatewayCmdUnknown;
+    }
+    return astcCommands[u32Hash].enCmd;
+}
+
+/*
+ * Get the channel letter
+ * 
+ * \param channel A...J, "" or NULL
+ * 
+ * \return channel letter or 0 for the current channel
+ */
+static char parseChannel(const char* channel)
+{
+    if ((channel != NULL) && (channel[0] != 0) && (channel[1] == 0))
+    {
+        return channel[0];
+    }
+    return 0;
+}
+
+/*
+ * Convert the argument of a command
+ * 
+ * \param enCmd command
+ * 
+ * \param commandArg argument, NULL allowed
+ * 
+ * \return speed -3...3, sound 1 (coupler), 2 (horn) or 3 (motor), otherwise 0
+ */
+static int parseArgument(en_irgateway_cmd_t enCmd, const char* commandArg)
+{
+    if (commandArg == NULL)
+    {
+        return 0;
+    }
+    if (enCmd == enIrGatewayCmdSound)
+    {
+        if (strcmp(commandArg,"motor") == 0)
         {
-           enIrAddress = enMaerklin292xxIrAddressB;
-        } else if (channel == "C")
+            return 3;
+        } else if (strcmp(commandArg,"horn") == 0)
         {
-           enIrAddress = enMaerklin292xxIrAddressC;
-        } else if (channel == "D")
+            return 2;
+        } else if (strcmp(commandArg,"coupler") == 0)
         {
-           enIrAddress = enMaerklin292xxIrAddressD;
-        } else if (channel == "G")
+            return 1;
+        }
+    }
+    return atoi(commandArg);
+}
+
+/*
+ * Decode and execute a command, no heap allocation
+ * 
+ * \param channel A...J, "" or NULL for the current channel
+ * 
+ * \param command stop, forward, backward, light, sound, speed or keepalive
+ * 
+ * \param commandArg argument of sound and speed
+ */
+static void processCommand(const char* channel, const char* command, const char* commandArg)
+{
+    en_irgateway_cmd_t enCmd = parseCommand(command);
+    IrGatewayWebServer_ExecuteCommand(parseChannel(channel),enCmd,parseArgument(enCmd,commandArg));
+}
+
+/*
+ * Execute a decoded command
+ * 
+ * \param channel A...J or 0 for the current channel
+ * 
+ * \param enCmd command
+ * 
+ * \param iArg speed -3...3 or sound 1...3
+ */
+void IrGatewayWebServer_ExecuteCommand(char channel, en_irgateway_cmd_t enCmd, int iArg)
+{
+    WifiMcuCtrl_KeepAlive();
+    if ((channel >= 'A') && (channel <= 'Z') && (au8ChannelAddresses[channel - 'A'] != 0))
+    {
+        enIrAddress = (en_maerklin_292xx_ir_address_t)au8ChannelAddresses[channel - 'A'];
+    }
+    switch(enCmd)
+    {
+        case enIrGatewayCmdSound:
+            if (iArg == 3)
+            {
+                Maerklin292xxIr_ToggleSoundLight(enIrAddress,enMaerklin292xxIrFuncSound1);
+                LocoDatabase_FunctionToggled(enIrAddress,1);
+            } else if (iArg == 2)
+            {
+                Maerklin292xxIr_ToggleSoundLight(enIrAddress,enMaerklin292xxIrFuncSound2);
+                LocoDatabase_FunctionToggled(enIrAddress,2);
+            } else if (iArg == 1)
+            {
+                Maerklin292xxIr_ToggleSoundLight(enIrAddress,enMaerklin292xxIrFuncSound3);
+                LocoDatabase_FunctionToggled(enIrAddress,3);
+            }
+            break;
+        case enIrGatewayCmdSpeed:
+            Maerklin292xxIr_SetSpeed(enIrAddress,iArg);
+            LocoDatabase_SpeedChanged(enIrAddress,iArg);
+            break;
+        case enIrGatewayCmdForward:
+            Maerklin292xxIr_Send(enIrAddress,enMaerklin292xxIrFuncForward);
+            break;
+        case enIrGatewayCmdStop:
+            Maerklin292xxIr_Send(enIrAddress,enMaerklin292xxIrFuncStop);
+            LocoDatabase_SpeedChanged(enIrAddress,0);
+            break;
+        case enIrGatewayCmdBackward:
+            Maerklin292xxIr_Send(enIrAddress,enMaerklin292xxIrFuncBackward);
+            break;
+        case enIrGatewayCmdLight:
+            Maerklin292xxIr_ToggleSoundLight(enIrAddress,enMaerklin292xxIrFuncLight);
+            LocoDatabase_FunctionToggled(enIrAddress,0);
+            break;
+        default:
+            //keepalive, unknown
+            break;
+    }
+}
+
+/*
+ * Execute a single command of the web page and forward it to the peer gateways
+ * 
+ * \param channel A...J or 0 for the current channel
+ * 
+ * \param enCmd command
+ * 
+ * \param iArg speed -3...3 or sound 1...3
+ * 
+ * \param bForward false if the command was forwarded by another gateway
+ */
+static void executeAndForward(char channel, en_irgateway_cmd_t enCmd, int iArg, bool bForward)
+{
+    stc_irgateway_cmd_t stcCmd = {channel,(uint8_t)enCmd,(int8_t)iArg,0};
+    IrGatewayWebServer_ExecuteCommand(channel,enCmd,iArg);
+    if (bForward)
+    {
+        //returns at once, see IrGatewayPeers_Update()
+        IrGatewayPeers_Send(&stcCmd,1);
+    }
+}
+
+/*
+ * Execute a command from another interface (WebSocket) and forward it to
+ * the peer gateways, same as a single command of /api/cmd
+ * 
+ * \param channel A...J or "" for the current channel
+ * 
+ * \param command stop, forward, backward, light, sound, speed or keepalive
+ * 
+ * \param commandArg argument of sound and speed
+ */
+void IrGatewayWebServer_ProcessCommand(const char* channel, const char* command, const char* commandArg)
+{
+    en_irgateway_cmd_t enCmd = parseCommand(command);
+    executeAndForward(parseChannel(channel),enCmd,parseArgument(enCmd,commandArg),true);
+}
+
+/*
+ * Execute a batch of commands, commands with an offset are executed later
+ * from IrGatewayWebServer_RunScheduled(). The batch is accepted completely or not
+ * at all, other commands are not executed between the commands of the batch
+ * which are due at the same time.
+ * 
+ * \param pastcCmds commands, ascending u16OffsetMs
+ * 
+ * \param u8Count number of commands
+ * 
+ * \return false if there is not enough space for the delayed commands
+ */
+bool IrGatewayWebServer_ExecuteBatch(const stc_irgateway_cmd_t* pastcCmds, uint8_t u8Count)
+{
+    uint32_t u32Now = millis();
+    int iFree = 0;
+    int iDelayed = 0;
+    int slot = 0;
+    for(int i = 0; i < IRGATEWAYWEBSERVER_MAX_SCHEDULED; i++)
+    {
+        if (!astcScheduled[i].bUsed)
         {
-           enIrAddress = enMaerklin292xxIrAddressG;
-        } else if (channel == "H")
+            iFree++;
+        }
+    }
+    for(int i = 0; i < u8Count; i++)
+    {
+        if (pastcCmds[i].u16OffsetMs != 0)
         {
-           enIrAddress = enMaerklin292xxIrAddressH;
-        } else if (channel == "I")
+            iDelayed++;
+        }
+    }
+    if (iDelayed > iFree)
+    {
+        return false;
+    }
+    for(int i = 0; i < u8Count; i++)
+    {
+        if (pastcCmds[i].u16OffsetMs == 0)
         {
-           enIrAddress = enMaerklin292xxIrAddressI;
-        } else if (channel == "J")
+            IrGatewayWebServer_ExecuteCommand(pastcCmds[i].channel,(en_irgateway_cmd_t)pastcCmds[i].u8Cmd,pastcCmds[i].i8Arg);
+            continue;
+        }
+        while(astcScheduled[slot].bUsed)
         {
-           enIrAddress = enMaerklin292xxIrAddressJ;
+            slot++;
         }
+        astcScheduled[slot].stcCmd = pastcCmds[i];
+        astcScheduled[slot].u32Due = u32Now + pastcCmds[i].u16OffsetMs;
+        astcScheduled[slot].u32Order = u32ScheduledOrder++;
+        astcScheduled[slot].bUsed = true;
     }
-    if (command == "sound")
+    return true;
+}
+
+/*
+ * Execute all delayed commands of batches which are due, oldest first,
+ * called from loop()
+ */
+void IrGatewayWebServer_RunScheduled(void)
+{
+    uint32_t u32Now = millis();
+    int next;
+    do
     {
-        if ((commandArg == "motor") || (commandArg == "3"))
+        next = -1;
+        for(int i = 0; i < IRGATEWAYWEBSERVER_MAX_SCHEDULED; i++)
         {
-            Maerklin292xxIr_ToggleSoundLight(enIrAddress,enMaerklin292xxIrFuncSound1);
-        } else if ((commandArg == "horn") || (commandArg == "2"))
-        {
-            Maerklin292xxIr_ToggleSoundLight(enIrAddress,enMaerklin292xxIrFuncSound2);
-        } else if ((commandArg == "coupler") || (commandArg == "1"))
+            if ((astcScheduled[i].bUsed) && ((int32_t)(u32Now - astcScheduled[i].u32Due) >= 0) &&
+                ((next < 0) || ((int32_t)(astcScheduled[i].u32Due - astcScheduled[next].u32Due) < 0) ||
+                 ((astcScheduled[i].u32Due == astcScheduled[next].u32Due) && ((int32_t)(astcScheduled[i].u32Order - astcScheduled[next].u32Order) < 0))))
+            {
+                next = i;
+            }
+        }
+        if (next >= 0)
         {
-            Maerklin292xxIr_ToggleSoundLight(enIrAddress,enMaerklin292xxIrFuncSound3);
-        } 
-    } else if (command == "speed")
+            astcScheduled[next].bUsed = false;
+            IrGatewayWebServer_ExecuteCommand(astcScheduled[next].stcCmd.channel,(en_irgateway_cmd_t)astcScheduled[next].stcCmd.u8Cmd,
+                                              astcScheduled[next].stcCmd.i8Arg);
+        }
+    } while(next >= 0);
+}
+
+/*
+ * Decode one command of a batch
+ * 
+ * \param entry {"channel":"A","cmd":"speed","args":"2","delay":500}, channel, args and delay are optional
+ * 
+ * \param pu32Offset time after the start of the batch, the delay in ms is added
+ * 
+ * \param pstcCmd decoded command
+ * 
+ * \return false if the command, channel or delay is invalid
+ */
+static bool parseBatchEntry(JsonVariant entry, uint32_t* pu32Offset, stc_irgateway_cmd_t* pstcCmd)
+{
+    const char* channel = entry["channel"];
+    en_irgateway_cmd_t enCmd = parseCommand(entry["cmd"]);
+    int iArg;
+    long delay = entry["delay"] | 0L;
+
+    if (entry["args"].is<int>())
     {
-      int speed = commandArg.toInt();
-      Maerklin292xxIr_SetSpeed(enIrAddress,speed);
-    } else if (command == "forward")
+        iArg = entry["args"];
+    } else
     {
-        Maerklin292xxIr_Send(enIrAddress,enMaerklin292xxIrFuncForward);
-    } else if (command == "stop")
+        iArg = parseArgument(enCmd,entry["args"]);
+    }
+    if ((delay < 0) || (delay > IRGATEWAYWEBSERVER_MAX_BATCH_MS))
     {
-        Maerklin292xxIr_Send(enIrAddress,enMaerklin292xxIrFuncStop);
-    }  else if (command == "backward")
+        return false;
+    }
+    //the delay of an invalid command still counts, following commands keep their timing
+    *pu32Offset += delay;
+    pstcCmd->channel = parseChannel(channel);
+    pstcCmd->u8Cmd = enCmd;
+    pstcCmd->i8Arg = iArg;
+    pstcCmd->u16OffsetMs = *pu32Offset;
+    if ((enCmd == enIrGatewayCmdUnknown) || (*pu32Offset > IRGATEWAYWEBSERVER_MAX_BATCH_MS) || (iArg < -128) || (iArg > 127))
     {
-        Maerklin292xxIr_Send(enIrAddress,enMaerklin292xxIrFuncBackward);
-    } else if (command == "light")
+        return false;
+    }
+    if ((channel != NULL) && ((pstcCmd->channel < 'A') || (pstcCmd->channel > 'Z') || (au8ChannelAddresses[pstcCmd->channel - 'A'] == 0)))
     {
-        Maerklin292xxIr_ToggleSoundLight(enIrAddress,enMaerklin292xxIrFuncLight);
-    } else if (command == "keepalive")
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Replace "current channel" (0) in a batch by the channel letter, delayed
+ * commands and the peers must not depend on the channel selected later.
+ * A command without channel uses the channel of the command before it.
+ * 
+ * \param pastcCmds commands
+ * 
+ * \param u8Count number of commands
+ */
+static void resolveChannels(stc_irgateway_cmd_t* pastcCmds, uint8_t u8Count)
+{
+    char current = 0;
+    for (int i = 0;i < (int)(sizeof(astcChannels)/sizeof(astcChannels[0]));i++)
     {
-        //Serial.println("k");
+        if (astcChannels[i].enAddress == enIrAddress)
+        {
+            current = astcChannels[i].channel;
+        }
+    }
+    for (int i = 0;i < u8Count;i++)
+    {
+        if (pastcCmds[i].channel == 0)
+        {
+            pastcCmds[i].channel = current;
+        } else
+        {
+            current = pastcCmds[i].channel;
+        }
     }
-    pServer->send(200, "text/plain", "done");
 }
 
+/*
+ * POST /api/cmd
+ * 
+ * single command, answered with "OK":
+ *   {"channel":"A","cmd":"speed","args":"2"}
+ * 
+ * batch, the delay in ms is relative to the previous command, answered with the status of every command:
+ *   [{"channel":"A","cmd":"light"},{"channel":"A","cmd":"sound","args":"horn","delay":500}]
+ *   {"commands":[...],"repeated":"true"} (forwarded by other gateways)
+ *   {"results":["ok","scheduled","invalid"]}
+ */
 static void handleCmdAPI(void) {
-  static char urlClient[128];
-  static char jsonData[128];
   if (pServer->method() == HTTP_GET) {
       pServer->send(404, "text/plain", "Page not found.");
   } else if (pServer->method() == HTTP_POST)
@@ -207,41 +554,121 @@ static void handleCmdAPI(void) {
       }
       Serial.println(json);
       deserializeJson(doc, json);
-      const char* channel = NULL;
-      const char* cmd = NULL;
-      const char* cmdArgs = NULL;
       bool bRepeated = false;
-      if (doc.containsKey("channel"))
-      {
-          channel = doc["channel"];
-      }
-      if (doc.containsKey("cmd"))
+      if (doc.containsKey("repeated"))
       {
-          cmd = doc["cmd"];
+          //gateways send the string "true"
+          bRepeated = (doc["repeated"] == true) || (doc["repeated"] == "true");
       }
-      if (doc.containsKey("args"))
+      JsonArray commands = doc.is<JsonArray>() ? doc.as<JsonArray>() : doc["commands"].as<JsonArray>();
+      if (commands.isNull())
       {
-          cmdArgs = doc["args"];
+          const char* channel = NULL;
+          const char* cmd = NULL;
+          const char* cmdArgs = NULL;
+          if (doc.containsKey("channel"))
+          {
+              channel = doc["channel"];
+          }
+          if (doc.containsKey("cmd"))
+          {
+              cmd = doc["cmd"];
+          }
+          if (doc.containsKey("args"))
+          {
+              cmdArgs = doc["args"];
+          }
+          en_irgateway_cmd_t enCmd = parseCommand(cmd);
+          executeAndForward(parseChannel(channel),enCmd,parseArgument(enCmd,cmdArgs),!bRepeated);
+          pServer->send(200, "text/plain", "OK");
+          return;
       }
-      if (doc.containsKey("repeated"))
+
+      static stc_irgateway_cmd_t astcBatch[IRGATEWAYWEBSERVER_MAX_BATCH];
+      static char acResponse[16 + IRGATEWAYWEBSERVER_MAX_BATCH * 12];
+      bool abValid[IRGATEWAYWEBSERVER_MAX_BATCH];
+      uint8_t u8Count = 0;
+      uint32_t u32Offset = 0;
+      int n = 0;
+      int len;
+      if (commands.size() > IRGATEWAYWEBSERVER_MAX_BATCH)
       {
-          bRepeated = doc["repeated"];
+          pServer->send(413, "text/plain", "Too many commands.");
+          return;
       }
-      processCommand(channel,cmd,cmdArgs);
-      pServer->send(200, "text/plain", "OK");
-      if (!bRepeated)
+      for (JsonVariant entry : commands)
       {
-          for (int i = 0;i < MdnsClientList_Count();i++)
+          abValid[n] = parseBatchEntry(entry,&u32Offset,&astcBatch[u8Count]);
+          if (abValid[n])
           {
-              sprintf(urlClient,"http://%s/api/cmd",MdnsClientList_GetIPString(i));
-              sprintf(jsonData,"{\"channel\":\"%s\",\"cmd\":\"%s\",\"args\":\"%s\",\"repeated\":\"true\"}",channel,cmd,cmdArgs);
-              httpClient.begin(client, urlClient);  // HTTP
-              httpClient.addHeader("Content-Type", "application/json");
-              httpClient.POST(jsonData);
-              httpClient.end();
+              u8Count++;
           }
+          n++;
+      }
+      resolveChannels(astcBatch,u8Count);
+      if (!IrGatewayWebServer_ExecuteBatch(astcBatch,u8Count))
+      {
+          pServer->send(503, "text/plain", "Too many scheduled commands.");
+          return;
+      }
+      len = snprintf(acResponse,sizeof(acResponse),"{\"results\":[");
+      u8Count = 0;
+      for (int i = 0; i < n; i++)
+      {
+          len += snprintf(&acResponse[len],sizeof(acResponse) - len,"%s\"%s\"",(i == 0) ? "" : ",",
+                          !abValid[i] ? "invalid" : (astcBatch[u8Count++].u16OffsetMs == 0) ? "ok" : "scheduled");
       }
+      snprintf(&acResponse[len],sizeof(acResponse) - len,"]}");
+      pServer->send(200, "application/json", acResponse);
+      if ((!bRepeated) && (u8Count > 0))
+      {
+          //whole batch in one message, see IrGatewayPeers_Update()
+          IrGatewayPeers_Send(astcBatch,u8Count);
+      }
+  }
+}
+
+static void handleStatsAPI(void) {
+  static char jsonData[1536];
+  int len;
+  uint32_t u32Sent;
+  uint32_t u32Dropped;
+  uint32_t u32Updates;
+  uint32_t u32Coalesced;
+  uint32_t u32Heartbeat;
+  uint32_t u32Idle;
+  uint32_t u32Disconnected;
+  uint32_t u32LocosStopped;
+  uint32_t u32PeersSent;
+  uint32_t u32PeersRetries;
+  uint32_t u32PeersDropped;
+  uint32_t u32MulticastSent;
+  uint32_t u32MulticastReceived;
+  uint32_t u32MulticastDuplicates;
+
+  len = snprintf(jsonData,sizeof(jsonData),"{\"txQueue\":%u,\"locos\":{",(unsigned)Maerklin292xxIr_GetQueueCount());
+  for (int i = 0;i < (int)(sizeof(astcChannels)/sizeof(astcChannels[0]));i++)
+  {
+      u32Sent = 0;
+      u32Dropped = 0;
+      u32Updates = 0;
+      u32Coalesced = 0;
+      Maerklin292xxIr_GetRepeatStats(astcChannels[i].enAddress,&u32Sent,&u32Dropped);
+      Maerklin292xxIr_GetSpeedStats(astcChannels[i].enAddress,&u32Updates,&u32Coalesced);
+      len += snprintf(&jsonData[len],sizeof(jsonData) - len,"%s\"%c\":{\"repeatsSent\":%u,\"repeatsDropped\":%u,\"speedUpdates\":%u,\"speedCoalesced\":%u,\"irLed\":%d}",
+                      (i == 0) ? "" : ",",astcChannels[i].channel,(unsigned)u32Sent,(unsigned)u32Dropped,
+                      (unsigned)u32Updates,(unsigned)u32Coalesced,
+                      Maerklin292xxIr_GetEmitter(astcChannels[i].enAddress) + 1);
   }
+  WiThrottle_GetCloseStats(&u32Heartbeat,&u32Idle,&u32Disconnected,&u32LocosStopped);
+  IrGatewayPeers_GetStats(&u32PeersSent,&u32PeersRetries,&u32PeersDropped);
+  IrGatewayPeers_GetMulticastStats(&u32MulticastSent,&u32MulticastReceived,&u32MulticastDuplicates);
+  snprintf(&jsonData[len],sizeof(jsonData) - len,"},\"withrottle\":{\"heartbeatTimeouts\":%u,\"idleEvictions\":%u,\"disconnects\":%u,\"locosStopped\":%u},\"peers\":{\"sent\":%u,\"retries\":%u,\"dropped\":%u,"
+           "\"multicastSent\":%u,\"multicastReceived\":%u,\"multicastDuplicates\":%u}}",
+           (unsigned)u32Heartbeat,(unsigned)u32Idle,(unsigned)u32Disconnected,(unsigned)u32LocosStopped,
+           (unsigned)u32PeersSent,(unsigned)u32PeersRetries,(unsigned)u32PeersDropped,
+           (unsigned)u32MulticastSent,(unsigned)u32MulticastReceived,(unsigned)u32MulticastDuplicates);
+  pServer->send(200, "application/json", jsonData);
 }
 
 /*
@@ -259,6 +686,7 @@ static void handleCmdAPI(void) {
   enIrAddress = enIrChannelAddress;
 
   pServer->on("/api/cmd", handleCmdAPI);
+  pServer->on("/api/stats", handleStatsAPI);
   
 
   #if defined(ARDUINO_ARCH_ESP8266)
@@ -266,10 +694,12 @@ static void handleCmdAPI(void) {
   #else
     pServer->on("/cmd/{}/{}/{}", []() {
   #endif
-    String channel = pServer->pathArg(0);
-    String cmd = pServer->pathArg(1);
-    String cmdArgs = pServer->pathArg(2);
-    processCommand(channel,cmd,cmdArgs);
+    //const reference: no copy on ESP8266, the copy of the other cores lives until the end of the handler
+    const String& channel = pServer->pathArg(0);
+    const String& cmd = pServer->pathArg(1);
+    const String& cmdArgs = pServer->pathArg(2);
+    processCommand(channel.c_str(),cmd.c_str(),cmdArgs.c_str());
+    pServer->send(200, "text/plain", "done");
   });
 
   #if defined(ARDUINO_ARCH_ESP8266)
@@ -277,16 +707,16 @@ static void handleCmdAPI(void) {
   #else
     pServer->on("/cmd/{}/{}", []() {
   #endif
-    String channel = pServer->pathArg(0);
-    String cmd = pServer->pathArg(1);
-    String cmdArgs = "";
-    if (!((channel.charAt(0) >= 'A') && (channel.charAt(0) <= 'Z')))
+    const String& first = pServer->pathArg(0);
+    const String& second = pServer->pathArg(1);
+    if ((first[0] >= 'A') && (first[0] <= 'Z'))
     {
-       channel = "";
-       cmd = pServer->pathArg(0);
-       cmdArgs = pServer->pathArg(1);
+       processCommand(first.c_str(),second.c_str(),"");
+    } else
+    {
+       processCommand("",first.c_str(),second.c_str());
     }
-    processCommand(channel,cmd,cmdArgs);
+    pServer->send(200, "text/plain", "done");
   });
 
   #if defined(ARDUINO_ARCH_ESP8266)
@@ -294,14 +724,15 @@ static void handleCmdAPI(void) {
   #else
     pServer->on("/cmd/{}", []() {
   #endif
-    String cmd = pServer->pathArg(0);
+    const String& cmd = pServer->pathArg(0);
     WifiMcuCtrl_KeepAlive();
     if (cmd == "keepalive")
     {
         pServer->send(200, "text/plain", "keep alive accepted");
     } else
     {
-        processCommand("",cmd,"");
+        processCommand("",cmd.c_str(),"");
+        pServer->send(200, "text/plain", "done");
     } 
   });
 
@@ -81,12 +81,35 @@
  *******************************************************************************
  */
 
+#define IRGATEWAYWEBSERVER_MAX_BATCH 16       //commands per POST /api/cmd
+#define IRGATEWAYWEBSERVER_MAX_SCHEDULED 32   //delayed commands of all batches waiting for execution
+#define IRGATEWAYWEBSERVER_MAX_BATCH_MS 65535 //sum of the delays of a batch
+
 /**
  *******************************************************************************
  ** Global type definitions ('typedef') 
  *******************************************************************************
  */
 
+typedef enum en_irgateway_cmd
+{
+  enIrGatewayCmdUnknown = 0,
+  enIrGatewayCmdStop,
+  enIrGatewayCmdForward,
+  enIrGatewayCmdBackward,
+  enIrGatewayCmdLight,
+  enIrGatewayCmdSound,
+  enIrGatewayCmdSpeed,
+  enIrGatewayCmdKeepAlive,
+} en_irgateway_cmd_t;
+
+typedef struct stc_irgateway_cmd
+{
+  char channel;                 //'A'...'J' or 0 for the current channel
+  uint8_t u8Cmd;                //en_irgateway_cmd_t
+  int8_t i8Arg;                 //speed -3...3 or sound 1...3
+  uint16_t u16OffsetMs;         //time after the start of the batch
+} stc_irgateway_cmd_t;
 
 
 /**
@@ -108,6 +131,10 @@
 #endif
 
 void IrGatewayWebServer_Update(void);
+void IrGatewayWebServer_ProcessCommand(const char* channel, const char* command, const char* commandArg);
+void IrGatewayWebServer_ExecuteCommand(char channel, en_irgateway_cmd_t enCmd, int iArg);
+bool IrGatewayWebServer_ExecuteBatch(const stc_irgateway_cmd_t* pastcCmds, uint8_t u8Count);
+void IrGatewayWebServer_RunScheduled(void);
 
 //@} // IrGatewayWebServerGroup
 
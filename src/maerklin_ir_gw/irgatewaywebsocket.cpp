@@ -0,0 +1,721 @@
+/**
+ *******************************************************************************
+ ** Copyright © 2021 io-expert.com. All rights reserved.
+ **
+ ** 1. Redistributions of source code must retain the above copyright notice,
+ **    this condition and the following disclaimer.
+ **
+ ** This software is provided by the copyright holder and contributors "AS IS"
+ ** and any warranties related to this software are DISCLAIMED.
+ ** The copyright owner or contributors be NOT LIABLE for any damages caused
+ ** by use of this software.
+
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ **\file irgatewaywebsocket.cpp
+ **
+ ** WebSocket control channel of the IR gateway
+ ** A detailed description is available at
+ ** @link IrGatewayWebSocketGroup file description @endlink
+ **
+ ** History:
+ ** - 2026-10-17  1.00  First version, WebSocket control channel for the web page
+ *******************************************************************************
+ */
+
+#define __IRGATEWAYWEBSOCKET_C__
+
+/**
+ *******************************************************************************
+ ** Include files
+ *******************************************************************************
+ */
+
+#include <Arduino.h>
+
+#if defined(ARDUINO_ARCH_ESP8266)
+  #include <ESP8266WiFi.h>
+#elif defined(ARDUINO_ARCH_ESP32)
+  #include <WiFi.h>
+#elif defined(ARDUINO_ARCH_RP2040)
+  #include <WiFi.h>
+#else
+#error Not supported architecture
+#endif
+
+#include "irgatewaywebsocket.h"
+#include "irgatewaywebserver.h"
+#include "locodatabase.h"
+#include "../wifimcu/wifimcuctrl.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+  //after irgatewaywebserver.h, lwip defines send() as macro
+  #include <errno.h>
+  #include "lwip/sockets.h"
+#endif
+
+/**
+ *******************************************************************************
+ ** Local pre-processor symbols/macros ('#define')
+ *******************************************************************************
+ */
+
+#define LINE_BUFFER_SIZE 128     //handshake header lines, longer lines are not needed and skipped
+#define KEY_SIZE 32              //Sec-WebSocket-Key is 24 characters
+#define MAX_PAYLOAD 125          //commands fit into a frame without extended length
+#define RX_BUFFER_SIZE (MAX_PAYLOAD + 8)
+#define TX_BUFFER_SIZE 160       //handshake response or one state frame
+#define MAX_LOCOS 10             //loco addresses 1...10, see locodatabase.cpp
+
+#define PING_INTERVAL_MS 5000    //same interval as the keepalive polling of the web page
+#define TIMEOUT_MS 15000         //close clients which did not answer three pings
+
+#define OPCODE_CONTINUATION 0x0
+#define OPCODE_TEXT 0x1
+#define OPCODE_BINARY 0x2
+#define OPCODE_CLOSE 0x8
+#define OPCODE_PING 0x9
+#define OPCODE_PONG 0xA
+
+#define CLOSE_NORMAL 1000
+#define CLOSE_PROTOCOL_ERROR 1002
+#define CLOSE_TOO_BIG 1009
+
+/**
+ *******************************************************************************
+ ** Global variable definitions (declared in header file with 'extern')
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** Local type definitions ('typedef')
+ *******************************************************************************
+ */
+
+typedef struct stc_irgateway_websocket_client
+{
+  WiFiClient client;
+  bool bOpen;                       //handshake done
+  bool bDiscard;                    //skip rest of a too long header line
+  char acKey[KEY_SIZE];
+  uint8_t au8Rx[RX_BUFFER_SIZE];    //header line while connecting, frames while open
+  uint16_t u16RxLen;
+  uint8_t au8Tx[TX_BUFFER_SIZE];    //rest of a frame the TCP stack did not accept yet
+  uint16_t u16TxHead;
+  uint16_t u16TxLen;
+  uint16_t u16Changed;              //bit n: state of loco address n has to be sent
+  uint32_t u32LastRx;
+  uint32_t u32LastPing;
+} stc_irgateway_websocket_client_t;
+
+/**
+ *******************************************************************************
+ ** Local variable definitions ('static')
+ *******************************************************************************
+ */
+
+static WiFiServer* pServer = NULL;
+static stc_irgateway_websocket_client_t astcClients[IRGATEWAYWEBSOCKET_MAX_CLIENTS];
+
+static const char acWebSocketGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+static const char acBase64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/**
+ *******************************************************************************
+ ** Local function prototypes ('static')
+ *******************************************************************************
+ */
+
+static void sha1(const uint8_t* pu8Data, uint32_t u32Len, uint8_t* pu8Digest);
+static void acceptKey(const char* pcKey, char* pcAccept);
+static int writeNonBlocking(stc_irgateway_websocket_client_t* pClient, const uint8_t* pu8Data, uint32_t u32Len);
+static bool flush(stc_irgateway_websocket_client_t* pClient);
+static bool sendFrame(stc_irgateway_websocket_client_t* pClient, uint8_t u8Opcode, const uint8_t* pu8Payload, uint32_t u32Len);
+static void closeClient(stc_irgateway_websocket_client_t* pClient, uint16_t u16Status);
+static void handshakeLine(stc_irgateway_websocket_client_t* pClient, char* pcLine, uint32_t u32Len);
+static void receiveHandshake(stc_irgateway_websocket_client_t* pClient);
+static void executeText(char* pcText, uint32_t u32Len);
+static void receiveFrames(stc_irgateway_websocket_client_t* pClient);
+static void sendChangedLocos(stc_irgateway_websocket_client_t* pClient);
+
+/**
+ *******************************************************************************
+ ** Function implementation - global ('extern') and local ('static')
+ *******************************************************************************
+ */
+
+/**
+ * SHA-1 of a short message, only used for the handshake
+ *
+ * \param pu8Data message
+ *
+ * \param u32Len message length, up to 119 bytes (two blocks)
+ *
+ * \param pu8Digest returns 20 bytes digest
+ */
+static void sha1(const uint8_t* pu8Data, uint32_t u32Len, uint8_t* pu8Digest)
+{
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+  uint32_t w[80];
+  uint8_t au8Blocks[128];
+  uint32_t u32Blocks = (u32Len + 8) / 64 + 1;
+  uint32_t a, b, c, d, e, f, k, t;
+  uint8_t* pu8Block;
+  int i;
+
+  memset(au8Blocks,0,sizeof(au8Blocks));
+  memcpy(au8Blocks,pu8Data,u32Len);
+  au8Blocks[u32Len] = 0x80;
+  au8Blocks[u32Blocks * 64 - 2] = (u32Len * 8) >> 8;
+  au8Blocks[u32Blocks * 64 - 1] = (u32Len * 8) & 0xFF;
+  for(uint32_t u32Block = 0; u32Block < u32Blocks; u32Block++)
+  {
+    pu8Block = &au8Blocks[u32Block * 64];
+    for(i = 0; i < 16; i++)
+    {
+      w[i] = ((uint32_t)pu8Block[i*4] << 24) | ((uint32_t)pu8Block[i*4+1] << 16) | ((uint32_t)pu8Block[i*4+2] << 8) | pu8Block[i*4+3];
+    }
+    for(i = 16; i < 80; i++)
+    {
+      t = w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16];
+      w[i] = (t << 1) | (t >> 31);
+    }
+    a = h[0]; b = h[1]; c = h[2]; d = h[3]; e = h[4];
+    for(i = 0; i < 80; i++)
+    {
+      if (i < 20)
+      {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      } else if (i < 40)
+      {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      } else if (i < 60)
+      {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      } else
+      {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+      t = ((a << 5) | (a >> 27)) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = (b << 30) | (b >> 2);
+      b = a;
+      a = t;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+  }
+  for(i = 0; i < 20; i++)
+  {
+    pu8Digest[i] = h[i / 4] >> (24 - (i % 4) * 8);
+  }
+}
+
+/**
+ * Calculate Sec-WebSocket-Accept of a Sec-WebSocket-Key
+ *
+ * \param pcKey key sent by the browser
+ *
+ * \param pcAccept returns base64 of SHA-1(key + GUID), 29 bytes incl. termination
+ */
+static void acceptKey(const char* pcKey, char* pcAccept)
+{
+  uint8_t au8Message[KEY_SIZE + sizeof(acWebSocketGuid)];
+  uint8_t au8Digest[21];
+  uint32_t u32Len = strlen(pcKey);
+  uint32_t u32Triple;
+  int i;
+
+  memcpy(au8Message,pcKey,u32Len);
+  memcpy(&au8Message[u32Len],acWebSocketGuid,sizeof(acWebSocketGuid) - 1);
+  sha1(au8Message,u32Len + sizeof(acWebSocketGuid) - 1,au8Digest);
+  au8Digest[20] = 0;
+  for(i = 0; i < 7; i++)
+  {
+    u32Triple = ((uint32_t)au8Digest[i*3] << 16) | ((uint32_t)au8Digest[i*3+1] << 8) | au8Digest[i*3+2];
+    pcAccept[i*4] = acBase64[(u32Triple >> 18) & 0x3F];
+    pcAccept[i*4+1] = acBase64[(u32Triple >> 12) & 0x3F];
+    pcAccept[i*4+2] = acBase64[(u32Triple >> 6) & 0x3F];
+    pcAccept[i*4+3] = acBase64[u32Triple & 0x3F];
+  }
+  pcAccept[27] = '='; //20 bytes, last group has 2 bytes only
+  pcAccept[28] = 0;
+}
+
+/**
+ * Write as much data as the TCP stack accepts without blocking
+ *
+ * \param pClient client handle
+ *
+ * \param pu8Data data
+ *
+ * \param u32Len data length
+ *
+ * \return number of bytes written, -1 if the connection is broken
+ */
+static int writeNonBlocking(stc_irgateway_websocket_client_t* pClient, const uint8_t* pu8Data, uint32_t u32Len)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  //
+  // WiFiClient::write() of ESP32 waits up to seconds while the send buffer is full, use the socket directly
+  //
+  int res = lwip_send(pClient->client.fd(), pu8Data, u32Len, MSG_DONTWAIT);
+  if (res < 0)
+  {
+    return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : -1;
+  }
+  return res;
+#else
+  int free = pClient->client.availableForWrite();
+  if (free <= 0)
+  {
+    return 0;
+  }
+  if (u32Len > (uint32_t)free)
+  {
+    u32Len = free;
+  }
+  return pClient->client.write(pu8Data, u32Len);
+#endif
+}
+
+/**
+ * Write the pending rest of the transmit buffer
+ *
+ * \param pClient client handle
+ *
+ * \return true if the transmit buffer is empty
+ */
+static bool flush(stc_irgateway_websocket_client_t* pClient)
+{
+  int written;
+  if (pClient->u16TxLen == 0)
+  {
+    return true;
+  }
+  written = writeNonBlocking(pClient,&pClient->au8Tx[pClient->u16TxHead],pClient->u16TxLen);
+  if (written < 0)
+  {
+    pClient->u16TxLen = 0;
+    pClient->client.stop();
+    pClient->bOpen = false;
+    return false;
+  }
+  pClient->u16TxHead += written;
+  pClient->u16TxLen -= written;
+  return (pClient->u16TxLen == 0);
+}
+
+/**
+ * Send a frame, server frames are not masked
+ *
+ * \param pClient client handle
+ *
+ * \param u8Opcode OPCODE_TEXT, OPCODE_CLOSE, OPCODE_PING or OPCODE_PONG
+ *
+ * \param pu8Payload payload
+ *
+ * \param u32Len payload length, up to MAX_PAYLOAD
+ *
+ * \return false if the previous frame is not sent yet, nothing was sent
+ */
+static bool sendFrame(stc_irgateway_websocket_client_t* pClient, uint8_t u8Opcode, const uint8_t* pu8Payload, uint32_t u32Len)
+{
+  if ((!flush(pClient)) || (u32Len > MAX_PAYLOAD))
+  {
+    return false;
+  }
+  pClient->au8Tx[0] = 0x80 | u8Opcode; //FIN
+  pClient->au8Tx[1] = u32Len;
+  if (u32Len > 0)
+  {
+    memcpy(&pClient->au8Tx[2],pu8Payload,u32Len);
+  }
+  pClient->u16TxHead = 0;
+  pClient->u16TxLen = u32Len + 2;
+  flush(pClient);
+  return true;
+}
+
+/**
+ * Send a close frame and close the connection
+ *
+ * \param pClient client handle
+ *
+ * \param u16Status status code, 0 for none (connection not open)
+ */
+static void closeClient(stc_irgateway_websocket_client_t* pClient, uint16_t u16Status)
+{
+  uint8_t au8Status[2];
+  if ((pClient->bOpen) && (u16Status != 0))
+  {
+    au8Status[0] = u16Status >> 8;
+    au8Status[1] = u16Status & 0xFF;
+    sendFrame(pClient,OPCODE_CLOSE,au8Status,sizeof(au8Status));
+  }
+  pClient->client.stop();
+  pClient->bOpen = false;
+  pClient->u16TxLen = 0;
+}
+
+/**
+ * Process a header line of the HTTP upgrade request
+ *
+ * \param pClient client handle
+ *
+ * \param pcLine line without '\n', zero terminated
+ *
+ * \param u32Len line length
+ */
+static void handshakeLine(stc_irgateway_websocket_client_t* pClient, char* pcLine, uint32_t u32Len)
+{
+  static const char acKeyHeader[] = "Sec-WebSocket-Key:";
+  char acAccept[29];
+  int len;
+
+  if ((u32Len > 0) && (pcLine[u32Len - 1] == '\r'))
+  {
+    pcLine[--u32Len] = 0;
+  }
+  if (u32Len > 0)
+  {
+    if (strncasecmp(pcLine,acKeyHeader,sizeof(acKeyHeader) - 1) == 0)
+    {
+      pcLine += sizeof(acKeyHeader) - 1;
+      while(*pcLine == ' ')
+      {
+        pcLine++;
+      }
+      if (strlen(pcLine) < KEY_SIZE)
+      {
+        strcpy(pClient->acKey,pcLine);
+      }
+    }
+    return;
+  }
+  //empty line, end of request
+  if (pClient->acKey[0] == 0)
+  {
+    len = snprintf((char*)pClient->au8Tx,TX_BUFFER_SIZE,"HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n");
+    pClient->u16TxHead = 0;
+    pClient->u16TxLen = len;
+    flush(pClient);
+    pClient->client.stop();
+    return;
+  }
+  acceptKey(pClient->acKey,acAccept);
+  len = snprintf((char*)pClient->au8Tx,TX_BUFFER_SIZE,"HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n",acAccept);
+  pClient->u16TxHead = 0;
+  pClient->u16TxLen = len;
+  pClient->bOpen = true;
+  pClient->u16Changed = (1 << (MAX_LOCOS + 1)) - 2; //send state of all locos
+  pClient->u32LastPing = millis();
+  flush(pClient);
+}
+
+/**
+ * Read the HTTP upgrade request line by line
+ *
+ * \param pClient client handle
+ */
+static void receiveHandshake(stc_irgateway_websocket_client_t* pClient)
+{
+  int c;
+  while((!pClient->bOpen) && (pClient->client.available() > 0))
+  {
+    c = pClient->client.read();
+    if (c < 0)
+    {
+      break;
+    }
+    pClient->u32LastRx = millis();
+    if (c == '\n')
+    {
+      if (!pClient->bDiscard)
+      {
+        pClient->au8Rx[pClient->u16RxLen] = 0;
+        handshakeLine(pClient,(char*)pClient->au8Rx,pClient->u16RxLen);
+      }
+      pClient->u16RxLen = 0;
+      pClient->bDiscard = false;
+    } else if (pClient->u16RxLen < (LINE_BUFFER_SIZE - 1))
+    {
+      pClient->au8Rx[pClient->u16RxLen++] = c;
+    } else
+    {
+      pClient->bDiscard = true;
+    }
+  }
+  if (pClient->bOpen)
+  {
+    pClient->u16RxLen = 0;
+  }
+}
+
+/**
+ * Execute a text message
+ *
+ * \param pcText <channel>/<command>[/<argument>] or <command>[/<argument>], zero terminated
+ *
+ * \param u32Len message length
+ */
+static void executeText(char* pcText, uint32_t u32Len)
+{
+  const char* apcToken[4] = {pcText,"","",""};
+  int iTokens = 1;
+
+  for(uint32_t i = 0; i < u32Len; i++)
+  {
+    if (pcText[i] == '/')
+    {
+      pcText[i] = 0;
+      if (iTokens < 4)
+      {
+        apcToken[iTokens++] = &pcText[i + 1];
+      }
+    }
+  }
+  if ((strlen(apcToken[0]) == 1) && (apcToken[0][0] >= 'A') && (apcToken[0][0] <= 'Z'))
+  {
+    IrGatewayWebServer_ProcessCommand(apcToken[0],apcToken[1],apcToken[2]);
+  } else
+  {
+    IrGatewayWebServer_ProcessCommand("",apcToken[0],apcToken[1]);
+  }
+}
+
+/**
+ * Read and execute frames of an open connection
+ *
+ * \param pClient client handle
+ */
+static void receiveFrames(stc_irgateway_websocket_client_t* pClient)
+{
+  uint32_t u32Header;
+  uint32_t u32PayloadLen;
+  uint8_t* pu8Payload;
+  uint8_t u8Opcode;
+  int len;
+
+  while((pClient->bOpen) && (pClient->client.available() > 0))
+  {
+    len = pClient->client.read(&pClient->au8Rx[pClient->u16RxLen],RX_BUFFER_SIZE - pClient->u16RxLen);
+    if (len <= 0)
+    {
+      break;
+    }
+    pClient->u16RxLen += len;
+    while((pClient->bOpen) && (pClient->u16RxLen >= 2))
+    {
+      u8Opcode = pClient->au8Rx[0] & 0x0F;
+      u32PayloadLen = pClient->au8Rx[1] & 0x7F;
+      if (((pClient->au8Rx[1] & 0x80) == 0) || ((pClient->au8Rx[0] & 0x70) != 0))
+      {
+        //clients have to mask, no extensions negotiated
+        closeClient(pClient,CLOSE_PROTOCOL_ERROR);
+        return;
+      }
+      if ((u32PayloadLen > MAX_PAYLOAD) || ((pClient->au8Rx[0] & 0x80) == 0) || (u8Opcode == OPCODE_CONTINUATION))
+      {
+        //commands are short, fragmented or long messages are not used by the web page
+        closeClient(pClient,CLOSE_TOO_BIG);
+        return;
+      }
+      u32Header = 2 + 4;
+      if (pClient->u16RxLen < (u32Header + u32PayloadLen))
+      {
+        break;
+      }
+      pu8Payload = &pClient->au8Rx[u32Header];
+      for(uint32_t i = 0; i < u32PayloadLen; i++)
+      {
+        pu8Payload[i] ^= pClient->au8Rx[2 + (i % 4)];
+      }
+      pClient->u32LastRx = millis();
+      WifiMcuCtrl_KeepAlive();
+      switch(u8Opcode)
+      {
+        case OPCODE_TEXT:
+          {
+            char acText[MAX_PAYLOAD + 1];
+            memcpy(acText,pu8Payload,u32PayloadLen);
+            acText[u32PayloadLen] = 0;
+            executeText(acText,u32PayloadLen);
+          }
+          break;
+        case OPCODE_PING:
+          sendFrame(pClient,OPCODE_PONG,pu8Payload,u32PayloadLen);
+          break;
+        case OPCODE_CLOSE:
+          closeClient(pClient,CLOSE_NORMAL);
+          return;
+        default:
+          //pong and binary frames only count as activity
+          break;
+      }
+      pClient->u16RxLen -= u32Header + u32PayloadLen;
+      memmove(pClient->au8Rx,&pClient->au8Rx[u32Header + u32PayloadLen],pClient->u16RxLen);
+    }
+  }
+}
+
+/**
+ * Send the state of changed locos as long as the TCP stack accepts it
+ *
+ * \param pClient client handle
+ */
+static void sendChangedLocos(stc_irgateway_websocket_client_t* pClient)
+{
+  char acState[64];
+  uint32_t u32Functions;
+  int iSpeed;
+  int len;
+
+  for(uint32_t u32Address = 1; (u32Address <= MAX_LOCOS) && (pClient->u16Changed != 0); u32Address++)
+  {
+    if ((pClient->u16Changed & (1 << u32Address)) == 0)
+    {
+      continue;
+    }
+    if (!flush(pClient))
+    {
+      return;
+    }
+    pClient->u16Changed &= ~(1 << u32Address);
+    if (LocoDatabase_GetState(u32Address,&iSpeed,&u32Functions))
+    {
+      len = snprintf(acState,sizeof(acState),"{\"loco\":\"%c\",\"speed\":%d,\"functions\":%u}",(char)('A' + u32Address - 1),iSpeed,(unsigned)u32Functions);
+      sendFrame(pClient,OPCODE_TEXT,(uint8_t*)acState,len);
+    }
+  }
+}
+
+/**
+ * Init WebSocket control channel
+ *
+ * \param u16Port TCP port, 0 to disable
+ */
+void IrGatewayWebSocket_Init(uint16_t u16Port)
+{
+  if ((u16Port == 0) || (pServer != NULL))
+  {
+    return;
+  }
+  pServer = new WiFiServer(u16Port);
+  pServer->begin();
+  pServer->setNoDelay(true);
+}
+
+/**
+ * Update WebSocket control channel in loop: accept connections, execute
+ * commands, ping clients and send loco changes
+ */
+void IrGatewayWebSocket_Update(void)
+{
+  stc_irgateway_websocket_client_t* pClient;
+  int i;
+
+  if (pServer == NULL)
+  {
+    return;
+  }
+  if (pServer->hasClient())
+  {
+    for(i = 0; i < IRGATEWAYWEBSOCKET_MAX_CLIENTS; i++)
+    {
+      if (!astcClients[i].client || !astcClients[i].client.connected())
+      {
+        break;
+      }
+    }
+    if (i < IRGATEWAYWEBSOCKET_MAX_CLIENTS)
+    {
+      pClient = &astcClients[i];
+      if (pClient->client) pClient->client.stop();
+      pClient->client = pServer->available();
+      pClient->bOpen = false;
+      pClient->bDiscard = false;
+      pClient->acKey[0] = 0;
+      pClient->u16RxLen = 0;
+      pClient->u16TxLen = 0;
+      pClient->u16Changed = 0;
+      pClient->u32LastRx = millis();
+    } else
+    {
+      //no free spot, the web page falls back to HTTP
+      pServer->available().stop();
+    }
+  }
+  for(i = 0; i < IRGATEWAYWEBSOCKET_MAX_CLIENTS; i++)
+  {
+    pClient = &astcClients[i];
+    if (!pClient->client || !pClient->client.connected())
+    {
+      if (pClient->client) pClient->client.stop();
+      pClient->bOpen = false;
+      continue;
+    }
+    if (!pClient->bOpen)
+    {
+      receiveHandshake(pClient);
+      if ((!pClient->bOpen) && ((millis() - pClient->u32LastRx) > TIMEOUT_MS))
+      {
+        closeClient(pClient,0);
+      }
+      continue;
+    }
+    receiveFrames(pClient);
+    if (!pClient->bOpen)
+    {
+      continue;
+    }
+    if ((millis() - pClient->u32LastRx) > TIMEOUT_MS)
+    {
+      closeClient(pClient,0);
+      continue;
+    }
+    if (((millis() - pClient->u32LastRx) > PING_INTERVAL_MS) && ((millis() - pClient->u32LastPing) > PING_INTERVAL_MS))
+    {
+      if (sendFrame(pClient,OPCODE_PING,NULL,0))
+      {
+        pClient->u32LastPing = millis();
+      }
+    }
+    sendChangedLocos(pClient);
+  }
+}
+
+/**
+ * Send the new state of a loco to all connected browsers, the state is
+ * read from the loco database in the next IrGatewayWebSocket_Update()
+ *
+ * \param u32Address loco address 1...10
+ */
+void IrGatewayWebSocket_LocoChanged(uint32_t u32Address)
+{
+  if ((u32Address < 1) || (u32Address > MAX_LOCOS))
+  {
+    return;
+  }
+  for(int i = 0; i < IRGATEWAYWEBSOCKET_MAX_CLIENTS; i++)
+  {
+    if (astcClients[i].bOpen)
+    {
+      astcClients[i].u16Changed |= (1 << u32Address);
+    }
+  }
+}
+
+/**
+ *******************************************************************************
+ ** EOF (not truncated)
+ *******************************************************************************
+ */
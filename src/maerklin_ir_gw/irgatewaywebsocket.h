@@ -0,0 +1,122 @@
+/**
+ *******************************************************************************
+ ** Copyright © 2021 io-expert.com. All rights reserved.
+ **
+ ** 1. Redistributions of source code must retain the above copyright notice,
+ **    this condition and the following disclaimer.
+ **
+ ** This software is provided by the copyright holder and contributors "AS IS"
+ ** and any warranties related to this software are DISCLAIMED.
+ ** The copyright owner or contributors be NOT LIABLE for any damages caused
+ ** by use of this software.
+
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ **\file irgatewaywebsocket.h
+ **
+ ** WebSocket control channel of the IR gateway
+ ** A detailed description is available at
+ ** @link IrGatewayWebSocketGroup file description @endlink
+ **
+ ** History:
+ ** - 2026-10-17  1.00  First version, WebSocket control channel for the web page
+ *******************************************************************************
+ */
+
+#if !defined(__IRGATEWAYWEBSOCKET_H__)
+#define __IRGATEWAYWEBSOCKET_H__
+
+///* C binding of definitions if building with C++ compiler */
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif
+
+/**
+ *******************************************************************************
+ ** \defgroup IrGatewayWebSocketGroup WebSocket control channel of the IR gateway
+ **
+ ** Provided functions of IrGatewayWebSocket:
+ **
+ ** One persistent connection per browser (ws://<gateway>:81/).
+ **
+ ** Upstream text messages, same commands as /cmd/... :
+ **   <channel>/<command>[/<argument>]   e.g. "C/speed/2", "A/light"
+ **
+ ** Downstream text messages, sent on connect and on every loco change:
+ **   {"loco":"C","speed":2,"functions":1}
+ **
+ ** The gateway pings every client, answered pings keep the gateway awake
+ ** the same way /cmd/keepalive does.
+ **
+ *******************************************************************************
+ */
+
+//@{
+
+/**
+ *******************************************************************************
+** \page irgatewaywebsocket_module_includes Required includes in main application
+** \brief Following includes are required
+** @code
+** #include "irgatewaywebsocket.h"
+** @endcode
+**
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** (Global) Include files
+ *******************************************************************************
+ */
+
+#include <stdint.h>
+
+/**
+ *******************************************************************************
+ ** Global pre-processor symbols/macros ('#define')
+ *******************************************************************************
+ */
+
+#define IRGATEWAYWEBSOCKET_PORT 81          //html/index.html connects to this port
+#define IRGATEWAYWEBSOCKET_MAX_CLIENTS 4
+
+/**
+ *******************************************************************************
+ ** Global type definitions ('typedef')
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** Global variable declarations ('extern', definition in C source)
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** Global function prototypes ('extern', definition in C source)
+ *******************************************************************************
+ */
+
+void IrGatewayWebSocket_Init(uint16_t u16Port);
+void IrGatewayWebSocket_Update(void);
+void IrGatewayWebSocket_LocoChanged(uint32_t u32Address);
+
+//@} // IrGatewayWebSocketGroup
+
+//#ifdef __cplusplus
+//}
+//#endif
+
+#endif /* __IRGATEWAYWEBSOCKET_H__ */
+
+/**
+ *******************************************************************************
+ ** EOF (not truncated)
+ *******************************************************************************
+ */
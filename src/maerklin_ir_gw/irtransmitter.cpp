@@ -0,0 +1,428 @@
+/**
+ *******************************************************************************
+ ** Copyright © 2021 io-expert.com. All rights reserved.
+ **
+ ** 1. Redistributions of source code must retain the above copyright notice,
+ **    this condition and the following disclaimer.
+ **
+ ** This software is provided by the copyright holder and contributors "AS IS"
+ ** and any warranties related to this software are DISCLAIMED.
+ ** The copyright owner or contributors be NOT LIABLE for any damages caused
+ ** by use of this software.
+
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ **\file irtransmitter.c
+ **
+ ** IR transmitter channels
+ **
+ ** ESP32:   RMT peripheral, one RMT channel per IR LED
+ ** RP2040:  PIO state machine fed by DMA, one state machine per IR LED
+ ** ESP8266: IRsend (blocking)
+ **
+ ** A detailed description is available at
+ ** @link IrTransmitterGroup file description @endlink
+ **
+ ** History:
+ ** - 2026-10-17  1.00  First version, up to four IR LEDs, one transmit queue each
+ *******************************************************************************
+ */
+
+#define __IRTRANSMITTER_C__
+
+/**
+ *******************************************************************************
+ ** Include files
+ *******************************************************************************
+ */
+
+#include <Arduino.h>
+#include "irtransmitter.h"
+#include "maerklin292xxirframe.h"
+#if defined(ARDUINO_ARCH_ESP8266)
+#include <IRremoteESP8266.h>
+#include <IRsend.h>
+#elif defined(ARDUINO_ARCH_ESP32)
+#include "driver/rmt.h"
+#elif defined(ARDUINO_ARCH_RP2040)
+#include <IRremote.h>
+#include <hardware/pio.h>
+#include <hardware/pio_instructions.h>
+#include <hardware/dma.h>
+#include <hardware/clocks.h>
+#else
+#error Not supported architecture
+#endif
+
+/**
+ *******************************************************************************
+ ** Local pre-processor symbols/macros ('#define') 
+ *******************************************************************************
+ */
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #define RMT_CLK_DIV 160 ///< 80MHz / 160 = 2us per tick, so the longest pause (45ms) fits into 15 bits
+  #define RMT_US_PER_TICK 2
+#elif defined(ARDUINO_ARCH_RP2040)
+  #define PIO_CYCLES_PER_CARRIER 24  ///< state machine cycles per carrier period, see initPio()
+  #define PIO_PROGRAM_LEN 11
+#endif
+
+/**
+ *******************************************************************************
+ ** Global variable definitions (declared in header file with 'extern') 
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** Local type definitions ('typedef') 
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** Local variable definitions ('static') 
+ *******************************************************************************
+ */
+
+static bool abInitDone[IRTRANSMITTER_MAX_CHANNELS];
+static bool abPending[IRTRANSMITTER_MAX_CHANNELS];  //frame sent, done callback not called yet
+static pfn_irtransmitter_done_callback_t pfnDoneCallback = NULL;
+
+#if defined(ARDUINO_ARCH_ESP32)
+static rmt_item32_t astcItems[IRTRANSMITTER_MAX_CHANNELS][(MAERKLIN292XXIR_FRAME_MAX_LEN + 2) / 2];
+static volatile bool abBusy[IRTRANSMITTER_MAX_CHANNELS];  //cleared by the RMT TX end interrupt
+#else
+#if defined(ARDUINO_ARCH_RP2040)
+static PIO apPio[IRTRANSMITTER_MAX_CHANNELS];
+static int aiSm[IRTRANSMITTER_MAX_CHANNELS];
+static int aiDma[IRTRANSMITTER_MAX_CHANNELS];
+static int aiPioOffset[2] = {-1, -1};          //program offset in pio0 / pio1
+static uint16_t au16PioProgram[PIO_PROGRAM_LEN];
+static uint32_t au32Items[IRTRANSMITTER_MAX_CHANNELS][MAERKLIN292XXIR_FRAME_MAX_LEN];
+#endif
+static IRsend aIrSend[IRTRANSMITTER_MAX_CHANNELS] = {   //fallback if no hardware transmitter is available
+  IRsend(99),
+  IRsend(99),
+  IRsend(99),
+  IRsend(99)
+};
+#endif
+
+/**
+ *******************************************************************************
+ ** Local function prototypes ('static') 
+ *******************************************************************************
+ */
+
+#if defined(ARDUINO_ARCH_ESP32)
+static void rmtTxEnd(rmt_channel_t channel, void* arg);
+#elif defined(ARDUINO_ARCH_RP2040)
+static bool initPio(uint8_t u8Channel, int32_t i32Gpio);
+#endif
+
+/**
+ *******************************************************************************
+ ** Function implementation - global ('extern') and local ('static') 
+ *******************************************************************************
+ */
+
+#if defined(ARDUINO_ARCH_ESP32)
+/*
+ * RMT TX end interrupt
+ * 
+ * \param channel RMT channel which finished sending
+ * 
+ * \param arg     not used
+ */
+static void rmtTxEnd(rmt_channel_t channel, void* arg)
+{
+  if ((uint8_t)channel < IRTRANSMITTER_MAX_CHANNELS)
+  {
+    abBusy[channel] = false;
+  }
+}
+#elif defined(ARDUINO_ARCH_RP2040)
+/*
+ * Init PIO state machine and DMA channel of a transmitter channel
+ * 
+ * The state machine pulls one word per mark / space: bit 0 is set for a mark,
+ * bits 1..31 hold the number of carrier periods - 1. One carrier period takes
+ * PIO_CYCLES_PER_CARRIER cycles, the LED is on for the first half of a mark period.
+ * 
+ *   0: pull block
+ *   1: out y, 1
+ *   2: out x, 31
+ *   3: jmp !y 8
+ *   4: set pins, 1 [11]    ; mark
+ *   5: set pins, 0 [10]
+ *   6: jmp x-- 4
+ *   7: jmp 0
+ *   8: nop [11]            ; space
+ *   9: nop [10]
+ *  10: jmp x-- 8
+ * 
+ * \param u8Channel channel 0...IRTRANSMITTER_MAX_CHANNELS-1
+ * 
+ * \param i32Gpio   GPIO of the IR LED
+ * 
+ * \return false if no state machine or DMA channel is free
+ */
+static bool initPio(uint8_t u8Channel, int32_t i32Gpio)
+{
+  PIO aPio[2] = {pio0, pio1};
+  pio_program_t stcProgram;
+  pio_sm_config stcConfig;
+  dma_channel_config stcDmaConfig;
+  int iPio;
+  int sm = -1;
+  int dma;
+
+  au16PioProgram[0] = pio_encode_pull(false, true);
+  au16PioProgram[1] = pio_encode_out(pio_y, 1);
+  au16PioProgram[2] = pio_encode_out(pio_x, 31);
+  au16PioProgram[3] = pio_encode_jmp_not_y(8);
+  au16PioProgram[4] = pio_encode_set(pio_pins, 1) | pio_encode_delay(11);
+  au16PioProgram[5] = pio_encode_set(pio_pins, 0) | pio_encode_delay(10);
+  au16PioProgram[6] = pio_encode_jmp_x_dec(4);
+  au16PioProgram[7] = pio_encode_jmp(0);
+  au16PioProgram[8] = pio_encode_nop() | pio_encode_delay(11);
+  au16PioProgram[9] = pio_encode_nop() | pio_encode_delay(10);
+  au16PioProgram[10] = pio_encode_jmp_x_dec(8);
+  stcProgram.instructions = au16PioProgram;
+  stcProgram.length = PIO_PROGRAM_LEN;
+  stcProgram.origin = -1;
+
+  //
+  // pio0 or pio1 may be used by other drivers (e.g. CYW43), take the first one with space left
+  //
+  for(iPio = 0; iPio < 2; iPio++)
+  {
+    if ((aiPioOffset[iPio] < 0) && (pio_can_add_program(aPio[iPio], &stcProgram)))
+    {
+      aiPioOffset[iPio] = pio_add_program(aPio[iPio], &stcProgram);
+    }
+    if (aiPioOffset[iPio] >= 0)
+    {
+      sm = pio_claim_unused_sm(aPio[iPio], false);
+      if (sm >= 0)
+      {
+        break;
+      }
+    }
+  }
+  if (sm < 0)
+  {
+    return false;
+  }
+  dma = dma_claim_unused_channel(false);
+  if (dma < 0)
+  {
+    pio_sm_unclaim(aPio[iPio], sm);
+    return false;
+  }
+
+  pio_gpio_init(aPio[iPio], i32Gpio);
+  pio_sm_set_consecutive_pindirs(aPio[iPio], sm, i32Gpio, 1, true);
+  stcConfig = pio_get_default_sm_config();
+  sm_config_set_wrap(&stcConfig, aiPioOffset[iPio], aiPioOffset[iPio] + PIO_PROGRAM_LEN - 1);
+  sm_config_set_set_pins(&stcConfig, i32Gpio, 1);
+  sm_config_set_out_shift(&stcConfig, true, false, 32);
+  sm_config_set_fifo_join(&stcConfig, PIO_FIFO_JOIN_TX);
+  sm_config_set_clkdiv(&stcConfig, (float)clock_get_hz(clk_sys) / (IRTRANSMITTER_CARRIER_KHZ * 1000.0f * PIO_CYCLES_PER_CARRIER));
+  pio_sm_init(aPio[iPio], sm, aiPioOffset[iPio], &stcConfig);
+  pio_sm_set_enabled(aPio[iPio], sm, true);
+
+  stcDmaConfig = dma_channel_get_default_config(dma);
+  channel_config_set_transfer_data_size(&stcDmaConfig, DMA_SIZE_32);
+  channel_config_set_read_increment(&stcDmaConfig, true);
+  channel_config_set_write_increment(&stcDmaConfig, false);
+  channel_config_set_dreq(&stcDmaConfig, pio_get_dreq(aPio[iPio], sm, true));
+  dma_channel_configure(dma, &stcDmaConfig, &aPio[iPio]->txf[sm], au32Items[u8Channel], 0, false);
+
+  apPio[u8Channel] = aPio[iPio];
+  aiSm[u8Channel] = sm;
+  aiDma[u8Channel] = dma;
+  return true;
+}
+#endif
+
+/*
+ * Init transmitter channel
+ * 
+ * \param u8Channel channel 0...IRTRANSMITTER_MAX_CHANNELS-1
+ * 
+ * \param i32Gpio   GPIO of the IR LED, negative values disable the channel
+ * 
+ * \return true if the channel is ready
+ */
+bool IrTransmitter_Init(uint8_t u8Channel, int32_t i32Gpio)
+{
+  if ((u8Channel >= IRTRANSMITTER_MAX_CHANNELS) || (i32Gpio < 0))
+  {
+    return false;
+  }
+#if defined(ARDUINO_ARCH_ESP32)
+  rmt_config_t stcConfig = RMT_DEFAULT_CONFIG_TX((gpio_num_t)i32Gpio, (rmt_channel_t)u8Channel);
+  stcConfig.clk_div = RMT_CLK_DIV;
+  stcConfig.tx_config.carrier_en = true;
+  stcConfig.tx_config.carrier_freq_hz = IRTRANSMITTER_CARRIER_KHZ * 1000;
+  stcConfig.tx_config.carrier_duty_percent = 50;
+  stcConfig.tx_config.carrier_level = RMT_CARRIER_LEVEL_HIGH;
+  stcConfig.tx_config.idle_output_en = true;
+  stcConfig.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+  if ((rmt_config(&stcConfig) != ESP_OK) || (rmt_driver_install((rmt_channel_t)u8Channel, 0, 0) != ESP_OK))
+  {
+    return false;
+  }
+  rmt_register_tx_end_callback(rmtTxEnd, NULL);
+#else
+#if defined(ARDUINO_ARCH_RP2040)
+  if (!initPio(u8Channel,i32Gpio))
+#endif
+  {
+    aIrSend[u8Channel] = IRsend(i32Gpio);  // Set the GPIO to be used to sending the message.
+    aIrSend[u8Channel].begin();
+  }
+#endif
+  abInitDone[u8Channel] = true;
+  return true;
+}
+
+/*
+ * Send a frame
+ * 
+ * \param u8Channel   channel 0...IRTRANSMITTER_MAX_CHANNELS-1
+ * 
+ * \param pu16Timings mark / space timings in us, starting with a mark
+ * 
+ * \param u8Len       number of timings, max. MAERKLIN292XXIR_FRAME_MAX_LEN
+ * 
+ * \return false if the channel is not ready or still busy
+ */
+bool IrTransmitter_Send(uint8_t u8Channel, const uint16_t* pu16Timings, uint8_t u8Len)
+{
+  if ((u8Channel >= IRTRANSMITTER_MAX_CHANNELS) || (!abInitDone[u8Channel]) || (u8Len > MAERKLIN292XXIR_FRAME_MAX_LEN))
+  {
+    return false;
+  }
+  if (IrTransmitter_IsBusy(u8Channel))
+  {
+    return false;
+  }
+  abPending[u8Channel] = true;
+#if defined(ARDUINO_ARCH_ESP32)
+  rmt_item32_t* pstcItems = astcItems[u8Channel];
+  int i;
+  for(i = 0; i < u8Len; i += 2)
+  {
+    pstcItems[i/2].level0 = 1;
+    pstcItems[i/2].duration0 = pu16Timings[i] / RMT_US_PER_TICK;
+    pstcItems[i/2].level1 = 0;
+    pstcItems[i/2].duration1 = ((i + 1) < u8Len) ? (pu16Timings[i + 1] / RMT_US_PER_TICK) : 0; //duration 0 ends the transmission
+  }
+  if ((u8Len % 2) == 0)
+  {
+    pstcItems[u8Len/2].val = 0;
+    i += 2;
+  }
+  abBusy[u8Channel] = true;
+  if (rmt_write_items((rmt_channel_t)u8Channel, pstcItems, i/2, false) != ESP_OK)
+  {
+    abBusy[u8Channel] = false;
+    return false;
+  }
+  return true;
+#else
+#if defined(ARDUINO_ARCH_RP2040)
+  if (apPio[u8Channel] != NULL)
+  {
+    uint32_t u32Periods;
+    for(int i = 0; i < u8Len; i++)
+    {
+      u32Periods = ((uint32_t)pu16Timings[i] * IRTRANSMITTER_CARRIER_KHZ + 500) / 1000;
+      if (u32Periods == 0)
+      {
+        u32Periods = 1;
+      }
+      au32Items[u8Channel][i] = ((u32Periods - 1) << 1) | (((i % 2) == 0) ? 1 : 0);
+    }
+    dma_channel_transfer_from_buffer_now(aiDma[u8Channel], au32Items[u8Channel], u8Len);
+    return true;
+  }
+#endif
+  aIrSend[u8Channel].sendRaw(pu16Timings,u8Len,IRTRANSMITTER_CARRIER_KHZ);
+  return true;
+#endif
+}
+
+/*
+ * Check if a frame is currently on the air
+ * 
+ * \param u8Channel channel 0...IRTRANSMITTER_MAX_CHANNELS-1
+ * 
+ * \return true if the channel is busy
+ */
+bool IrTransmitter_IsBusy(uint8_t u8Channel)
+{
+  if ((u8Channel >= IRTRANSMITTER_MAX_CHANNELS) || (!abInitDone[u8Channel]))
+  {
+    return false;
+  }
+#if defined(ARDUINO_ARCH_ESP32)
+  return abBusy[u8Channel];
+#elif defined(ARDUINO_ARCH_RP2040)
+  if (apPio[u8Channel] == NULL)
+  {
+    return false;
+  }
+  //
+  // Done when DMA and FIFO are empty and the state machine waits at "pull"
+  //
+  return (dma_channel_is_busy(aiDma[u8Channel]) || 
+          (!pio_sm_is_tx_fifo_empty(apPio[u8Channel], aiSm[u8Channel])) ||
+          (pio_sm_get_pc(apPio[u8Channel], aiSm[u8Channel]) != aiPioOffset[(apPio[u8Channel] == pio0) ? 0 : 1]));
+#else
+  return false;
+#endif
+}
+
+/*
+ * Register a callback, which is called from IrTransmitter_Update() when a
+ * frame was completely sent
+ * 
+ * \param pfnCallback callback or NULL
+ */
+void IrTransmitter_SetDoneCallback(pfn_irtransmitter_done_callback_t pfnCallback)
+{
+  pfnDoneCallback = pfnCallback;
+}
+
+/*
+ * Update in loop, calls the done callback of finished channels
+ */
+void IrTransmitter_Update(void)
+{
+  uint8_t u8Channel;
+  for(u8Channel = 0; u8Channel < IRTRANSMITTER_MAX_CHANNELS; u8Channel++)
+  {
+    if ((abPending[u8Channel]) && (!IrTransmitter_IsBusy(u8Channel)))
+    {
+      abPending[u8Channel] = false;
+      if (pfnDoneCallback != NULL)
+      {
+        pfnDoneCallback(u8Channel);
+      }
+    }
+  }
+}
+
+/**
+ *******************************************************************************
+ ** EOF (not truncated)
+ *******************************************************************************
+ */
@@ -0,0 +1,126 @@
+/**
+ *******************************************************************************
+ ** Copyright © 2021 io-expert.com. All rights reserved.
+ **
+ ** 1. Redistributions of source code must retain the above copyright notice,
+ **    this condition and the following disclaimer.
+ **
+ ** This software is provided by the copyright holder and contributors "AS IS"
+ ** and any warranties related to this software are DISCLAIMED.
+ ** The copyright owner or contributors be NOT LIABLE for any damages caused
+ ** by use of this software.
+
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ **\file irtransmitter.c
+ **
+ ** IR transmitter channels
+ ** A detailed description is available at
+ ** @link IrTransmitterGroup file description @endlink
+ **
+ ** History:
+ ** - 2026-10-17  1.00  First version, up to four IR LEDs, one transmit queue each
+ *******************************************************************************
+ */
+
+#if !defined(__IRTRANSMITTER_H__)
+#define __IRTRANSMITTER_H__
+
+/* C binding of definitions if building with C++ compiler */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ *******************************************************************************
+ ** \defgroup IrTransmitterGroup IR transmitter channels
+ **
+ ** Provided functions of IrTransmitter:
+ **
+ ** Every channel drives one IR LED. On ESP32 each channel uses its own RMT
+ ** channel, on RP2040 a PIO state machine fed by DMA generates carrier and
+ ** timing. In both cases IrTransmitter_Send() returns immediately and frames
+ ** of several channels are on the air at the same time. On ESP8266 (or if no
+ ** state machine is left on RP2040) IRsend is used, which returns after the
+ ** frame was sent.
+ **
+ ** IrTransmitter_Update() calls the done callback in loop context, so the
+ ** callback may send the next frame.
+ **
+ *******************************************************************************
+ */
+
+//@{
+
+/**
+ *******************************************************************************
+** \page irtransmitter_module_includes Required includes in main application
+** \brief Following includes are required
+** @code
+** #include "irtransmitter.h"
+** @endcode
+**
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** (Global) Include files
+ *******************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ *******************************************************************************
+ ** Global pre-processor symbols/macros ('#define') 
+ *******************************************************************************
+ */
+
+#define IRTRANSMITTER_MAX_CHANNELS 4
+#define IRTRANSMITTER_CARRIER_KHZ 38
+
+/**
+ *******************************************************************************
+ ** Global type definitions ('typedef') 
+ *******************************************************************************
+ */
+
+typedef void (*pfn_irtransmitter_done_callback_t)(uint8_t u8Channel);
+
+/**
+ *******************************************************************************
+ ** Global variable declarations ('extern', definition in C source)
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** Global function prototypes ('extern', definition in C source) 
+ *******************************************************************************
+ */
+
+bool IrTransmitter_Init(uint8_t u8Channel, int32_t i32Gpio);
+bool IrTransmitter_Send(uint8_t u8Channel, const uint16_t* pu16Timings, uint8_t u8Len);
+bool IrTransmitter_IsBusy(uint8_t u8Channel);
+void IrTransmitter_SetDoneCallback(pfn_irtransmitter_done_callback_t pfnCallback);
+void IrTransmitter_Update(void);
+
+//@} // IrTransmitterGroup
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IRTRANSMITTER_H__ */
+
+/**
+ *******************************************************************************
+ ** EOF (not truncated)
+ *******************************************************************************
+ */
@@ -39,6 +39,7 @@
 
 #include "locodatabase.h"
 #include "../withrottle/withrottle.h"
+#include "irgatewaywebsocket.h"
 #include "maerklin292xxir.h"
 
 /**
@@ -66,7 +67,9 @@
  */
 
 static stc_withrottle_loco_listitem_t locos[10];
-static int speedstatus[10];
+static int speedstatus[11]; //indexed by address 1...10
+static const char* const locoNames[10] = {"Loco A","Loco B","Loco C","Loco D",NULL,NULL,"Loco G","Loco H","Loco I","Loco J"}; //no IR address E and F, not in the roster
+static const char* const functionLabels[] = {"Light","Sound 1","Sound 2","Sound 3",NULL}; //F0...F3, see locoFunction()
 
 /**
  *******************************************************************************
@@ -109,6 +112,7 @@ static void locoSpeed(stc_withrottle_loco_t* pHandle, bool bForward, uint8_t spe
   {
       speedstatus[pHandle->u32Address] = iSpeed;
       Maerklin292xxIr_SetSpeed((en_maerklin_292xx_ir_address_t)pHandle->u32Address,iSpeed);
+      IrGatewayWebSocket_LocoChanged(pHandle->u32Address);
   }
   
 }
@@ -126,7 +130,9 @@ static bool locoFunction(stc_withrottle_loco_t* pHandle, uint8_t u8Function)
   Serial.print(pHandle->u32Address);
   Serial.print(" Function Updated: ");
   Serial.println(u8Function);
-  pHandle->u32FunctionMask ^= (1 << u8Function);
+  //u32FunctionMask is toggled by the WiThrottle parser after this callback,
+  //the WebSocket state is built from it in IrGatewayWebSocket_Update()
+  IrGatewayWebSocket_LocoChanged(pHandle->u32Address);
   switch(u8Function)
   {
     case 0:
@@ -161,12 +167,103 @@ void LocoDatabase_Init(void)
     locos[i].locoItem.bDir = true;
     locos[i].locoItem.speed = 0;
     locos[i].locoItem.u32FunctionMask = 0;
+    locos[i].locoItem.pName = locoNames[i];
+    if (locoNames[i] != NULL)
+    {
+      locos[i].locoItem.u32FunctionCapabilities = 0x0F; //F0...F3, see locoFunction()
+      locos[i].locoItem.ppFunctionLabels = functionLabels;
+    } else
+    {
+      //no IR address, nothing to switch
+      locos[i].locoItem.u32FunctionCapabilities = WITHROTTLE_FUNCTIONS_NONE;
+      locos[i].locoItem.ppFunctionLabels = NULL;
+    }
     locos[i].pNextItem = NULL;
     speedstatus[i] = 0;
     WiThrottle_AddLoco(&locos[i]);
   }
 }
 
+/**
+ * Update the speed of a loco after a command from another source
+ * (REST API, peer gateway), the IR command was already sent by the caller.
+ * The change is pushed to all throttles which have acquired the loco.
+ * 
+ * \param u32Address loco address 1...10
+ * 
+ * \param iSpeed speed -3...3
+ */
+void LocoDatabase_SpeedChanged(uint32_t u32Address, int iSpeed)
+{
+  stc_withrottle_loco_t* pLoco;
+  uint8_t u8Changed = WITHROTTLE_CHANGED_SPEED;
+  if ((u32Address < 1) || (u32Address > 10))
+  {
+    return;
+  }
+  if ((iSpeed > 3) || (iSpeed < -3))
+  {
+    iSpeed = 0; //same as Maerklin292xxIr_SetSpeed()
+  }
+  pLoco = &locos[u32Address - 1].locoItem;
+  speedstatus[u32Address] = iSpeed;
+  if (iSpeed != 0)
+  {
+    if (pLoco->bDir != (iSpeed > 0))
+    {
+      u8Changed |= WITHROTTLE_CHANGED_DIR;
+    }
+    pLoco->bDir = (iSpeed > 0);
+  }
+  pLoco->speed = abs(iSpeed) * 42;
+  WiThrottle_PublishLoco(pLoco,u8Changed,0);
+  IrGatewayWebSocket_LocoChanged(u32Address);
+}
+
+/**
+ * Update a function of a loco after a command from another source
+ * (REST API, peer gateway), the IR command was already sent by the caller.
+ * The change is pushed to all throttles which have acquired the loco.
+ * 
+ * \param u32Address loco address 1...10
+ * 
+ * \param u8Function function between 0...28
+ */
+void LocoDatabase_FunctionToggled(uint32_t u32Address, uint8_t u8Function)
+{
+  stc_withrottle_loco_t* pLoco;
+  if ((u32Address < 1) || (u32Address > 10) || (u8Function > 28))
+  {
+    return;
+  }
+  pLoco = &locos[u32Address - 1].locoItem;
+  pLoco->u32FunctionMask ^= (1 << u8Function);
+  WiThrottle_PublishLoco(pLoco,0,(1UL << u8Function));
+  IrGatewayWebSocket_LocoChanged(u32Address);
+}
+
+/**
+ * Get the current state of a loco
+ * 
+ * \param u32Address loco address 1...10
+ * 
+ * \param piSpeed returns speed -3...3
+ * 
+ * \param pu32Functions returns mask of active functions, bit 0 = light
+ * 
+ * \return false if the address is not in the database
+ */
+bool LocoDatabase_GetState(uint32_t u32Address, int* piSpeed, uint32_t* pu32Functions)
+{
+  if ((u32Address < 1) || (u32Address > 10))
+  {
+    return false;
+  }
+  *piSpeed = speedstatus[u32Address];
+  *pu32Functions = locos[u32Address - 1].locoItem.u32FunctionMask;
+  return true;
+}
+
 
 
 /**
@@ -67,6 +67,7 @@ extern "C"
  */
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /**
  *******************************************************************************
@@ -94,6 +95,9 @@ extern "C"
 
 
 void LocoDatabase_Init(void);
+void LocoDatabase_SpeedChanged(uint32_t u32Address, int iSpeed);
+void LocoDatabase_FunctionToggled(uint32_t u32Address, uint8_t u8Function);
+bool LocoDatabase_GetState(uint32_t u32Address, int* piSpeed, uint32_t* pu32Functions);
 
 //@} // LocoDatabaseGroup
 
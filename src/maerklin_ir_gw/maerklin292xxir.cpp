@@ -23,76 +23,8 @@
  ** A detailed description is available at
  ** @link Maerklin292xxIrGroup file description @endlink
  **
- ** Protocols:
- **
- ** locomotives addresses A-B:
- ** ==========================
- **
- **  _____             ......... _____             .........
- ** |  S  | 1st 8-bits . delay .|  S  | 2nd 8-bits . delay .
- ** |     |____________.........|     |____________.........
- **  20ms    2.5ms*8      45ms    20ms    2.5ms*8    200ms
- **
- ** |<---- High ---->|   |<---- Low  ---->|
- **  _____                 __________
- ** |     |               |          | 
- ** |     |__________     |          |_____
- **  0.6ms    1.7ms           1.7ms   0.6ms
- **
- ** locomotives addresses C-D:
- ** ==========================
- **
- **  _____             .........
- ** |  S  |   8-bits   . delay .
- ** |     |____________.........
- **  5.4ms    2.5ms*8    50ms
- **
- **  bit   description
- **  7     toggle bit
- **  6..4  command
- **  3..0  address, C: 0b0101, D: 0b1010
- **
- ** |<---- High ---->|   |<---- Low  ---->|
- **  _____                 __________
- ** |     |               |          | 
- ** |     |__________     |          |_____
- **  0.6ms    1.7ms           1.7ms   0.6ms
- **
- ** locomotives addresses G-H:
- ** ==========================
- **  _____                              .........
- ** |  S  |   7-bits + 7-bits inverted  . delay .
- ** |     |_____________________________.........
- **  4.1ms              ...             min. 20ms
- **
- **  bit   description
- **  6     address 0 = G, 1 = H
- **  5..3  speed
- **  2..0  function
- **
- ** |<---- Low ---->|      |<---- High  ---->|
- **  ______                 __________
- ** |      |               |          | 
- ** |      |_______        |          |_____
- **  0.5ms   0.5ms           1.5ms    0.5ms
- **
- ** locomotives addresses I-J:
- ** ==========================
- **  _____ ___                               ___ .........
- ** |  S  | 1 |    7-bits + 7-bits inverted | 0 |. delay .
- ** |     |___|_____________________________|___|.........
- **  4.1ms  1             ...                 0  min. 20ms
- **
- **  bit   description
- **  6     address 0 = G, 1 = H
- **  5..3  speed
- **  2..0  function
- **
- ** |<---- Low ---->|      |<---- High  ---->|
- **  ______                 __________
- ** |      |               |          | 
- ** |      |_______        |          |_____
- **  0.5ms   0.5ms           1.5ms    0.5ms
+ ** Protocol encoding is done in maerklin292xxirframe.cpp, the IR LEDs are
+ ** driven by irtransmitter.cpp
  **
  ** History:
  ** - 2021-1-2  1.00  Manuel Schreiner
@@ -110,18 +42,8 @@
 
 #include <Arduino.h>
 #include "maerklin292xxir.h"
-#if defined(ARDUINO_ARCH_ESP8266)
-#include <IRremoteESP8266.h>
-#include <IRsend.h>
-#elif defined(ARDUINO_ARCH_ESP32)
-#include <IRremoteESP8266.h>
-#include <IRsend.h>
-#elif defined(ARDUINO_ARCH_RP2040)
-#include <IRremote.h>
-#else
-#error Not supported architecture
-#endif
-
+#include "maerklin292xxirframe.h"
+#include "irtransmitter.h"
 
 
 #include "../appconfig.h"
@@ -135,6 +57,14 @@
 
 #pragma GCC optimize ("-Os")
 
+#define TX_GAP_AD_MS 210        ///< pause after a frame for addresses A-D (10ms + 200ms)
+#define TX_GAP_GJ_MS 20         ///< minimum pause after a frame for addresses G-J
+#define REPEAT_RATE_DRIVE_MS 200    ///< repeat rate of driving commands (G-J)
+#define REPEAT_RATE_FUNCTION_MS 20  ///< repeat rate of sound / light commands (G-J)
+#define SPEED_RESYNC_COUNT 8            ///< A-D: speed changes sent as delta before the next one is sent as Stop + N steps
+#define SPEED_RESYNC_INTERVAL_MS 30000  ///< A-D: speed change is sent as Stop + N steps if the last resync is older
+
+
 /**
  *******************************************************************************
  ** Global variable definitions (declared in header file with 'extern') 
@@ -147,48 +77,84 @@
  *******************************************************************************
  */
 
+typedef struct stc_maerklin_292xx_ir_frame
+{
+  en_maerklin_292xx_ir_address_t enAddress;
+  uint8_t u8Function;
+  uint16_t u16DelayMs; //minimum pause before this frame is sent
+} stc_maerklin_292xx_ir_frame_t;
+
+typedef struct stc_maerklin_292xx_ir_emitter
+{
+  bool bEnabled;
+  stc_maerklin_292xx_ir_frame_t astcTxQueue[MAERKLIN292XXIR_TX_QUEUE_SIZE];
+  uint8_t u8TxQueueHead;
+  uint8_t u8TxQueueCount;
+  uint8_t u8RepeatSlot;
+  uint8_t u8MailboxSlot;
+  uint32_t u32LastTx;
+  uint32_t u32TxGap;
+} stc_maerklin_292xx_ir_emitter_t;
+
+typedef struct stc_maerklin_292xx_ir_speed
+{
+  bool bValid;               //i8Speed matches the locomotive
+  int8_t i8Speed;            //current speed step -3...3
+  uint8_t u8DeltaCount;      //delta speed changes since last resync
+  uint32_t u32LastResync;
+} stc_maerklin_292xx_ir_speed_t;
+
+typedef struct stc_maerklin_292xx_ir_mailbox
+{
+  bool bPending;             //i8Speed waits for transmission
+  int8_t i8Speed;            //latest requested speed -3...3
+  uint32_t u32Updates;       //speed updates received
+  uint32_t u32Coalesced;     //speed updates replaced by a newer one before transmission
+} stc_maerklin_292xx_ir_mailbox_t;
+
+typedef struct stc_maerklin_292xx_ir_repeat
+{
+  uint8_t u8Repeat;          //pending repeats
+  uint8_t u8State;           //command which is repeated
+  uint32_t u32LastUpdate;
+  uint32_t u32UpdateRate;
+  uint32_t u32RepeatsSent;
+  uint32_t u32RepeatsDropped;
+} stc_maerklin_292xx_ir_repeat_t;
+
 /**
  *******************************************************************************
  ** Local variable definitions ('static') 
  *******************************************************************************
  */
 
-static uint16_t codeCache[40];
-static IRsend irsend = IRsend(99);
-static const stc_maerklin_292xx_ir_channelset_t stcChannelSetA = {
-  {0x77,0x77}, //stop
-  {0x1e59,0xe9b3}, //backward
-  {0x95e1,0x315d}, //forward  
-  {0x55,0x55}, //light
-  {0xdd,0xdd}, //sound1
-  {0xbb,0xbb}, //sound2 
-  {0x33,0x33}  //sound3 
-};
-
-static const stc_maerklin_292xx_ir_channelset_t stcChannelSetB = {
-  {0xee,0xee}, //stop     
-  {0xd731,0x935d}, //backward 
-  {0x15bd,0x5e73}, //forward
-  {0xd1,0xd1}, //light 
-  {0x59,0x59}, //sound1 
-  {0x11,0x11}, //sound2 
-  {0x99,0x99}  //sound3 
-};
-
 static uint8_t au8LastStates[26];
 
-static en_maerklin_292xx_ir_address_t enLastAddress = enMaerklin292xxIrAddressA;
-static volatile uint8_t u8Repeat = 0;
-static volatile uint32_t u32LastUpdate = 0;
-static volatile uint32_t u32UpdateRate = 1000;
+static stc_maerklin_292xx_ir_repeat_t astcRepeat[MAERKLIN292XXIR_ADDRESS_COUNT];
+static uint8_t au8ToggleFunction[MAERKLIN292XXIR_ADDRESS_COUNT];
+static bool abToggle[MAERKLIN292XXIR_ADDRESS_COUNT];
+static stc_maerklin_292xx_ir_speed_t astcSpeed[MAERKLIN292XXIR_ADDRESS_COUNT]; //only used by A-D
+static stc_maerklin_292xx_ir_mailbox_t astcMailbox[MAERKLIN292XXIR_ADDRESS_COUNT];
 static bool debugMode = false;
 
+static stc_maerklin_292xx_ir_emitter_t astcEmitters[MAERKLIN292XXIR_MAX_EMITTERS];
+static uint8_t au8EmitterOfSlot[MAERKLIN292XXIR_ADDRESS_COUNT]; //IR LED used by a locomotive
+
 /**
  *******************************************************************************
  ** Local function prototypes ('static') 
  *******************************************************************************
  */
 
+static bool enqueue(en_maerklin_292xx_ir_address_t enAddress, uint8_t u8Function, uint16_t u16DelayMs);
+static void armRepeat(en_maerklin_292xx_ir_address_t enAddress, uint8_t u8Function);
+static bool sendRepeat(uint8_t u8Emitter);
+static void transmit(uint8_t u8Emitter, en_maerklin_292xx_ir_address_t enAddress, uint8_t enFunction);
+static void transmitDone(uint8_t u8Emitter);
+static void sendSpeed(en_maerklin_292xx_ir_address_t enAddress, int speed);
+static void flushMailbox(int slot);
+static bool serviceMailbox(uint8_t u8Emitter);
+
 /**
  *******************************************************************************
  ** Function implementation - global ('extern') and local ('static') 
@@ -200,9 +166,84 @@ static bool debugMode = false;
  */
 void Maerklin292xxIr_Init(void)
 {
-  //initiate IR library
-  irsend = IRsend(AppConfig_GetGpioIr());  // Set the GPIO to be used to sending the message.
-  irsend.begin(); 
+  int32_t ai32Gpio[MAERKLIN292XXIR_MAX_EMITTERS] = {
+    AppConfig_GetGpioIr(),
+    AppConfig_GetGpioIr2(),
+    AppConfig_GetGpioIr3(),
+    AppConfig_GetGpioIr4()
+  };
+  const char* pcMap = AppConfig_GetIrEmitterMap();
+  uint8_t u8Emitter;
+  int i;
+
+  for(i = 0; i < MAERKLIN292XXIR_MAX_EMITTERS; i++)
+  {
+    astcEmitters[i].bEnabled = IrTransmitter_Init(i,ai32Gpio[i]);
+  }
+  IrTransmitter_SetDoneCallback(transmitDone);
+
+  //
+  // Map locomotives to IR LEDs, "12341234" assigns A,G to LED 1, B,H to LED 2...
+  // Locomotives with an invalid or disabled LED are sent via LED 1
+  //
+  for(i = 0; i < MAERKLIN292XXIR_ADDRESS_COUNT; i++)
+  {
+    u8Emitter = 0;
+    if ((pcMap != NULL) && (strlen(pcMap) > (size_t)i) && (pcMap[i] >= '1') && (pcMap[i] < ('1' + MAERKLIN292XXIR_MAX_EMITTERS)))
+    {
+      u8Emitter = pcMap[i] - '1';
+    }
+    if (!astcEmitters[u8Emitter].bEnabled)
+    {
+      u8Emitter = 0;
+    }
+    au8EmitterOfSlot[i] = u8Emitter;
+  }
+  memset(au8ToggleFunction,0xff,sizeof(au8ToggleFunction));
+  Maerklin292xxIrFrame_Init();
+}
+
+/*
+ * Put a frame into the transmit queue of the IR LED assigned to the
+ * locomotive, it is sent from Maerklin292xxIr_Update()
+ * 
+ * \param enAddress  Address, can be enMaerklin292xxIrAddressA...H
+ * 
+ * \param u8Function Function, can be one of en_maerklin_292xx_ir_func_t defined in maerklin292xxir.h
+ * 
+ * \param u16DelayMs minimum pause in ms between the previous frame and this frame
+ * 
+ * \return false if the queue is full
+ */
+static bool enqueue(en_maerklin_292xx_ir_address_t enAddress, uint8_t u8Function, uint16_t u16DelayMs)
+{
+  stc_maerklin_292xx_ir_frame_t* pstcFrame;
+  stc_maerklin_292xx_ir_emitter_t* pstcEmitter;
+  int slot = Maerklin292xxIrFrame_GetSlot(enAddress);
+  if (slot < 0)
+  {
+    return false;
+  }
+  pstcEmitter = &astcEmitters[au8EmitterOfSlot[slot]];
+  if (pstcEmitter->u8TxQueueCount >= MAERKLIN292XXIR_TX_QUEUE_SIZE)
+  {
+    if (debugMode)
+    {
+      Serial.println("  *** TX QUEUE FULL ***");
+    }
+    return false;
+  }
+  pstcFrame = &pstcEmitter->astcTxQueue[(pstcEmitter->u8TxQueueHead + pstcEmitter->u8TxQueueCount) % MAERKLIN292XXIR_TX_QUEUE_SIZE];
+  pstcFrame->enAddress = enAddress;
+  pstcFrame->u8Function = u8Function;
+  pstcFrame->u16DelayMs = u16DelayMs;
+  pstcEmitter->u8TxQueueCount++;
+
+  //
+  // Keep the commanded state up to date, so following commands are based on it
+  //
+  au8LastStates[(uint8_t)enAddress] = u8Function;
+  return true;
 }
 
 /*
@@ -214,16 +255,57 @@ void Maerklin292xxIr_Init(void)
  */
 void Maerklin292xxIr_Send(en_maerklin_292xx_ir_address_t enAddress, uint8_t enFunction)
 {
-  static bool bToggle = false;
-  static uint8_t u8CommandLen = 0;
-  static uint8_t u8LastCommand = 0;
-  static uint8_t u8LastCommand2 = 0;
-  static uint16_t u16Tmp = 0;
-  uint8_t u8Command = 0;
-  uint8_t u8Command2 = 0;
-  uint8_t u8Offset = 0;
-  static stc_maerklin_292xx_ir_codeset_t* pLastCodeSet = 0;
-  int i;
+  int slot = Maerklin292xxIrFrame_GetSlot(enAddress);
+  flushMailbox(slot);
+  if ((slot >= 0) && (enAddress <= enMaerklin292xxIrAddressD))
+  {
+    //
+    // Single steps sent from outside are not tracked, Stop is a resync
+    //
+    if (enFunction == enMaerklin292xxIrFuncStop)
+    {
+      astcSpeed[slot].bValid = true;
+      astcSpeed[slot].i8Speed = 0;
+      astcSpeed[slot].u8DeltaCount = 0;
+      astcSpeed[slot].u32LastResync = millis();
+    } else if ((enFunction == enMaerklin292xxIrFuncForward) || (enFunction == enMaerklin292xxIrFuncBackward))
+    {
+      astcSpeed[slot].bValid = false;
+    }
+  }
+  enqueue(enAddress,enFunction,0);
+}
+
+/*
+ * Force the next speed change of a locomotive A-D to be sent as Stop + N steps
+ * 
+ * \param enAddress  Address, can be enMaerklin292xxIrAddressA...D
+ */
+void Maerklin292xxIr_ResyncSpeed(en_maerklin_292xx_ir_address_t enAddress)
+{
+  int slot = Maerklin292xxIrFrame_GetSlot(enAddress);
+  if (slot >= 0)
+  {
+    astcSpeed[slot].bValid = false;
+  }
+}
+
+/*
+ * Transmit a frame, called by the scheduler in Maerklin292xxIr_Update()
+ * 
+ * \param u8Emitter  IR LED 0...MAERKLIN292XXIR_MAX_EMITTERS-1
+ * 
+ * \param enAddress  Address, can be enMaerklin292xxIrAddressA...H
+ * 
+ * \param enFunction Function, can be one of en_maerklin_292xx_ir_func_t defined in maerklin292xxir.h
+ */
+static void transmit(uint8_t u8Emitter, en_maerklin_292xx_ir_address_t enAddress, uint8_t enFunction)
+{
+  stc_maerklin_292xx_ir_emitter_t* pstcEmitter = &astcEmitters[u8Emitter];
+  int slot = Maerklin292xxIrFrame_GetSlot(enAddress);
+  bool bToggle = false;
+  const uint16_t* pu16Timings;
+  uint8_t u8Len;
   if (debugMode)
   {
      Serial.println(">> Send:");
@@ -237,255 +319,47 @@ void Maerklin292xxIr_Send(en_maerklin_292xx_ir_address_t enAddress, uint8_t enFu
      Serial.println("");
   }
 
-  //
-  //  Handle Locos type address A & B
-  //
-  if ((enAddress == enMaerklin292xxIrAddressA) || (enAddress == enMaerklin292xxIrAddressB))
-  {
-      u8Repeat = 0;
-      codeCache[0] = 20000;
-      codeCache[17] = 45000;
-      codeCache[18] = 20000;
-      u8CommandLen = 8;
-      stc_maerklin_292xx_ir_channelset_t* pstcChannelSet = 0;
-      stc_maerklin_292xx_ir_codeset_t* pstcCodeSet = 0;
-
-      //
-      // Select address
-      //
-      if (enAddress == enMaerklin292xxIrAddressA)
-      {
-          pstcChannelSet = (stc_maerklin_292xx_ir_channelset_t*)&stcChannelSetA;
-      } else if (enAddress == enMaerklin292xxIrAddressB)
-      {
-          pstcChannelSet = (stc_maerklin_292xx_ir_channelset_t*)&stcChannelSetB;
-      } else
-      {
-          return;
-      }
-
-      //
-      // Check for command
-      //
-      switch(enFunction)
-      {
-        case enMaerklin292xxIrFuncStop:
-          pstcCodeSet = &pstcChannelSet->stop;
-          break;
-        case enMaerklin292xxIrFuncBackward:
-          pstcCodeSet = &pstcChannelSet->backward;
-          break;
-        case enMaerklin292xxIrFuncForward:
-          pstcCodeSet = &pstcChannelSet->forward;
-          break;
-        case enMaerklin292xxIrFuncLight:
-          pstcCodeSet = &pstcChannelSet->light;
-          break;
-        case enMaerklin292xxIrFuncSound1:
-          pstcCodeSet = &pstcChannelSet->sound1;
-          break;
-        case enMaerklin292xxIrFuncSound2:
-          pstcCodeSet = &pstcChannelSet->sound2;
-          break;
-        case enMaerklin292xxIrFuncSound3:
-          pstcCodeSet = &pstcChannelSet->sound3;
-          break;
-      }
-      if (pstcCodeSet == 0) return;
-
-      //
-      //  Handle toggling
-      //
-      if (pLastCodeSet != pstcCodeSet)
-      {
-         bToggle = false;
-         pLastCodeSet = pstcCodeSet;
-      }
-
-      //
-      //  Choose command depending on toggle bit
-      //
-      if (bToggle)
-      {
-        u8Command = pstcCodeSet->codes[1] & 0xff;
-        u8Command2 = (pstcCodeSet->codes[1] >> 8) & 0xff;
-      } else {
-        u8Command = pstcCodeSet->codes[0] & 0xff;
-        u8Command2 = (pstcCodeSet->codes[0] >> 8) & 0xff;
-      }
-  } 
-  
-  //
-  //  Handle Locos type address C & D
-  //
-  else if ((enAddress == enMaerklin292xxIrAddressC) || (enAddress == enMaerklin292xxIrAddressD))
+  if (enAddress <= enMaerklin292xxIrAddressD)
   {
-      u8Repeat = 0;
-      codeCache[0] = 5400;
-      codeCache[17] = 10000;
-      codeCache[18] = 5400;
-      u8CommandLen = 8;
-      u8Command = (((uint8_t)enFunction & 0x7) << 4);
-      if (enAddress == enMaerklin292xxIrAddressC)
-      {
-        u8Command |= 0x05; 
-      } else if (enAddress == enMaerklin292xxIrAddressD)
-      {
-        u8Command |= 0x0a; 
-      }
-      if (u8Command != u8LastCommand)
-      {
-        bToggle = false;
-      }
-      u8LastCommand = u8Command;
-      
-      if (bToggle)
-      {
-        u8Command |= 0x80;
-      }
-  } 
-
-  //
-  //  Handle Locos type address G & H
-  //
-  else if ((enAddress == enMaerklin292xxIrAddressG) || (enAddress == enMaerklin292xxIrAddressH) || (enAddress == enMaerklin292xxIrAddressI) || (enAddress == enMaerklin292xxIrAddressJ))
+    //
+    //  Handle toggling, the toggle bit changes with every repetition of the same command
+    //
+    if (au8ToggleFunction[slot] != enFunction)
+    {
+      abToggle[slot] = false;
+      au8ToggleFunction[slot] = enFunction;
+    }
+    bToggle = abToggle[slot];
+  } else if ((enFunction & 0x70) == 0)
   {
-      codeCache[0] = 4100;
-      codeCache[1] = 550;
-      codeCache[30] = 1700;
-      codeCache[31] = 550;
-      codeCache[32] = 550;
-      codeCache[33] = 550;
-      u8CommandLen = 15;
-      u16Tmp = 0;
-      if ((enAddress == enMaerklin292xxIrAddressI) || (enAddress == enMaerklin292xxIrAddressJ))
-      {
-        u8Offset = 2;
-        u8CommandLen = 16;
-        codeCache[2] = 1500;
-        codeCache[3] = 550;
-        codeCache[30] = 550;
-      }
-      if ((enAddress == enMaerklin292xxIrAddressH) || (enAddress == enMaerklin292xxIrAddressJ))
-      {
-        u16Tmp |= (1 << 6);
-      }
-      if ((enFunction & 0x70) == 0)
-      {
-        enFunction = (enFunction & ~0x70) | enMaerklin292xxIrFuncSpeedStop;
-      }
-      u16Tmp |= ((enFunction & 0x70) >> 1) & 0x38;
-      u32UpdateRate = 200;
-      if (enFunction & 0x0f)
-      {
-        if (u8Repeat == 0)
-         {
-           u8Repeat = 3;
-           u32UpdateRate = 20;
-         }
-      }
-      switch(enFunction & 0x0f)
-      {
-        case enMaerklin292xxIrFuncLight:
-           u16Tmp |= 0x4;
-           break; 
-        case enMaerklin292xxIrFuncSoundHorn:
-           u16Tmp |= 0x3;
-           break; 
-        case enMaerklin292xxIrFuncSoundAnnouncement:
-           u16Tmp |= 0x2;
-           break; 
-        case enMaerklin292xxIrFuncSound1:
-           u16Tmp |= 0x1;
-           break; 
-        default:
-           break;
-      }
-      if (u8Repeat == 0)
-      {
-        u8Repeat = 10;
-      }
-      u16Tmp = (u16Tmp << 7) | (~u16Tmp & 0x7f);
-      for(i = 0;i < 14;i++)
-      {
-        if ((u16Tmp & (1 << 13)) != 0) 
-        {
-          codeCache[i*2 + 2 + u8Offset] = 1500;
-          codeCache[i*2 + 3 + u8Offset] = 550;
-        } else {
-          codeCache[i*2 + 2 + u8Offset] = 550;
-          codeCache[i*2 + 3 + u8Offset] = 550;
-        }
-        u16Tmp = u16Tmp << 1;
-      }
+    enFunction = (enFunction & ~0x70) | enMaerklin292xxIrFuncSpeedStop;
   }
 
-  //
-  //  If command len == 8, handle 2 times 8 bits
-  //
-  if (u8CommandLen == 8)
-  {  
-    for(i = 0;i < 8;i++)
-    {
-      if ((u8Command & 0x80) != 0) 
-      {
-        codeCache[i*2 + 1] = 1700;
-        codeCache[i*2 + 2] = 600;
-        codeCache[i*2 + 19] = 1700;
-        codeCache[i*2 + 20] = 600;
-      } else {
-        codeCache[i*2 + 1] = 600;
-        codeCache[i*2 + 2] = 1700;
-        codeCache[i*2 + 19] = 600;
-        codeCache[i*2 + 20] = 1700;
-      }
-      u8Command = u8Command << 1;
-    }
-    if (u8Command2 != 0)
-    {
-      for(i = 0;i < 8;i++)
-      {
-        if ((u8Command2 & 0x80) != 0) 
-        {
-          codeCache[i*2 + 19] = 1700;
-          codeCache[i*2 + 20] = 600;
-        } else {
-          codeCache[i*2 + 19] = 600;
-          codeCache[i*2 + 20] = 1700;
-        }
-        u8Command2 = u8Command2 << 1;
-      }
-    }
+  pu16Timings = Maerklin292xxIrFrame_Get(enAddress,enFunction,bToggle,&u8Len);
+  if (u8Len > 0)
+  {
     UserLedButton_SetLed(true);
-    irsend.sendRaw(codeCache,35,38);
-    UserLedButton_SetLed(false);
-    delay(10);
+    IrTransmitter_Send(u8Emitter,pu16Timings,u8Len);
     if (enAddress <= enMaerklin292xxIrAddressD)
     {
-      delay(200);
+      abToggle[slot] = !abToggle[slot];
+      pstcEmitter->u32TxGap = TX_GAP_AD_MS;
+    } else
+    {
+      pstcEmitter->u32TxGap = TX_GAP_GJ_MS;
     }
-    bToggle = !bToggle;
-  } else if (u8CommandLen == 15)
-  {
-    UserLedButton_SetLed(true);
-    irsend.sendRaw(codeCache,29,38);
-    UserLedButton_SetLed(false);
-  } else if (u8CommandLen == 16)
-  {
-    UserLedButton_SetLed(true);
-    irsend.sendRaw(codeCache,33,38);
-    UserLedButton_SetLed(false);
   }
 
   //
-  // Saving last states
+  // The commanded state (au8LastStates) is kept by enqueue(), newer frames of
+  // the locomotive may already be queued
   //
-  au8LastStates[(uint8_t)enAddress] = enFunction;
-  enLastAddress = enAddress;
+  pstcEmitter->u32LastTx = millis();
 }
 
 /*
- * Set speed
+ * Set speed, the speed is put into the mailbox of the locomotive and
+ * replaces a speed which was not sent yet (latest wins)
  * 
  * \param enAddress  Address, can be enMaerklin292xxIrAddressA...H
  * 
@@ -493,7 +367,8 @@ void Maerklin292xxIr_Send(en_maerklin_292xx_ir_address_t enAddress, uint8_t enFu
  */
 void Maerklin292xxIr_SetSpeed(en_maerklin_292xx_ir_address_t enAddress, int speed)
 {
-  uint8_t u8Temp;
+  stc_maerklin_292xx_ir_mailbox_t* pstcMailbox;
+  int slot = Maerklin292xxIrFrame_GetSlot(enAddress);
   if (debugMode)
   {
      Serial.println("SetSpeed:");
@@ -507,33 +382,124 @@ void Maerklin292xxIr_SetSpeed(en_maerklin_292xx_ir_address_t enAddress, int spee
      Serial.println("");
   }
   
+  if (slot < 0)
+  {
+    return;
+  }
+
   if ((speed > 3) || (speed < -3))
   {
     speed = 0; //emergency stop, speed value was wrong
   }
-  
+
+  pstcMailbox = &astcMailbox[slot];
+  pstcMailbox->u32Updates++;
+  if (pstcMailbox->bPending)
+  {
+    pstcMailbox->u32Coalesced++;
+  }
+  pstcMailbox->i8Speed = speed;
+  pstcMailbox->bPending = true;
+}
+
+/*
+ * Put the frames of a pending speed into the transmit queue, so following
+ * commands of the locomotive are sent after it
+ * 
+ * \param slot  slot of the locomotive, see Maerklin292xxIrFrame_GetSlot()
+ */
+static void flushMailbox(int slot)
+{
+  if ((slot >= 0) && (astcMailbox[slot].bPending))
+  {
+    astcMailbox[slot].bPending = false;
+    sendSpeed(Maerklin292xxIrFrame_GetAddress(slot),astcMailbox[slot].i8Speed);
+  }
+}
+
+/*
+ * Send the pending speed of one locomotive of an IR LED, locomotives
+ * are served round robin
+ * 
+ * \param u8Emitter  IR LED 0...MAERKLIN292XXIR_MAX_EMITTERS-1
+ * 
+ * \return true if frames were queued
+ */
+static bool serviceMailbox(uint8_t u8Emitter)
+{
+  stc_maerklin_292xx_ir_emitter_t* pstcEmitter = &astcEmitters[u8Emitter];
+  uint8_t u8Slot;
+  int i;
+  for(i = 0; i < MAERKLIN292XXIR_ADDRESS_COUNT; i++)
+  {
+    u8Slot = (pstcEmitter->u8MailboxSlot + i) % MAERKLIN292XXIR_ADDRESS_COUNT;
+    if ((au8EmitterOfSlot[u8Slot] == u8Emitter) && (astcMailbox[u8Slot].bPending))
+    {
+      pstcEmitter->u8MailboxSlot = (u8Slot + 1) % MAERKLIN292XXIR_ADDRESS_COUNT;
+      flushMailbox(u8Slot);
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Put the frames of a speed change into the transmit queue
+ * 
+ * \param enAddress  Address, can be enMaerklin292xxIrAddressA...H
+ * 
+ * \param speed  can be -3,-2,-1,0,1,2,3
+ */
+static void sendSpeed(en_maerklin_292xx_ir_address_t enAddress, int speed)
+{
+  uint8_t u8Temp;
+  uint16_t u16Delay;
+  stc_maerklin_292xx_ir_speed_t* pstcSpeed;
+  int steps;
+  bool bOk = true;
+
   //
   //  Handle Locos type address A, B, C, D
   //     
   if (enAddress <= enMaerklin292xxIrAddressD)
   {
-    delay(200);
-    Maerklin292xxIr_Send(enAddress,enMaerklin292xxIrFuncStop);
-    if (speed > 0)
+    pstcSpeed = &astcSpeed[Maerklin292xxIrFrame_GetSlot(enAddress)];
+
+    //
+    // Speeding up in the same direction only needs the missing steps,
+    // everything else (slowing down, changing direction, unknown speed)
+    // and every SPEED_RESYNC_COUNT change is sent as Stop + N steps
+    //
+    if ((pstcSpeed->bValid) && 
+        (((speed > 0) && (pstcSpeed->i8Speed >= 0) && (speed >= pstcSpeed->i8Speed)) || 
+         ((speed < 0) && (pstcSpeed->i8Speed <= 0) && (speed <= pstcSpeed->i8Speed))) &&
+        (pstcSpeed->u8DeltaCount < SPEED_RESYNC_COUNT) && 
+        ((millis() - pstcSpeed->u32LastResync) < SPEED_RESYNC_INTERVAL_MS))
     {
-       while(speed != 0)
-       {
-          speed--;
-          Maerklin292xxIr_Send(enAddress,enMaerklin292xxIrFuncForward);
-       }
-    } else if (speed < 0)
+      steps = speed - pstcSpeed->i8Speed;
+      if (steps != 0)
+      {
+        pstcSpeed->u8DeltaCount++;
+      }
+    } else
     {
-       while(speed != 0)
-       {
-          speed++;
-          Maerklin292xxIr_Send(enAddress,enMaerklin292xxIrFuncBackward);
-       }
-    } 
+      bOk = enqueue(enAddress,enMaerklin292xxIrFuncStop,200);
+      steps = speed;
+      pstcSpeed->u8DeltaCount = 0;
+      pstcSpeed->u32LastResync = millis();
+    }
+    while((steps > 0) && bOk)
+    {
+      steps--;
+      bOk = enqueue(enAddress,enMaerklin292xxIrFuncForward,0);
+    }
+    while((steps < 0) && bOk)
+    {
+      steps++;
+      bOk = enqueue(enAddress,enMaerklin292xxIrFuncBackward,0);
+    }
+    pstcSpeed->i8Speed = speed;
+    pstcSpeed->bValid = bOk; //queue full, speed of the locomotive unknown
   } 
   //
   //  Handle Locos type address > D
@@ -552,12 +518,12 @@ void Maerklin292xxIr_SetSpeed(en_maerklin_292xx_ir_address_t enAddress, int spee
        speed = -speed;
        u8Temp = speed - 1 + (enMaerklin292xxIrFuncSpeedBackward1 >> 4);
     }
-    if (u8Repeat != 0)
+    u16Delay = 0;
+    if (astcRepeat[Maerklin292xxIrFrame_GetSlot(enAddress)].u8Repeat != 0)
     {
-      u8Repeat = 0;
-      delay(500);
+      u16Delay = 500;
     }
-    Maerklin292xxIr_Send(enAddress,(u8Temp << 4));
+    enqueue(enAddress,(u8Temp << 4),u16Delay);
   }
 }
 
@@ -571,10 +537,10 @@ void Maerklin292xxIr_SetSpeed(en_maerklin_292xx_ir_address_t enAddress, int spee
 void Maerklin292xxIr_ToggleSoundLight(en_maerklin_292xx_ir_address_t enAddress, en_maerklin_292xx_ir_func_t enFunction)
 {
     static uint8_t u8Tmp;
-    delay(300);
+    flushMailbox(Maerklin292xxIrFrame_GetSlot(enAddress));
     if (enAddress <= enMaerklin292xxIrAddressD)
     {
-       Maerklin292xxIr_Send(enAddress,(uint8_t)enFunction);
+       enqueue(enAddress,(uint8_t)enFunction,300);
     } else
     {
        if (debugMode)
@@ -613,49 +579,255 @@ void Maerklin292xxIr_ToggleSoundLight(en_maerklin_292xx_ir_address_t enAddress,
          Serial.println("");
        }
        
-       if (u8Repeat != 0)
-       {
-          u8Repeat = 0;
-          if (debugMode)
-          {
-            Serial.println("  *** DELAYING 10ms ***");
-          }
-          delay(10);
-       }
-       Maerklin292xxIr_Send(enAddress,u8Tmp);
+       enqueue(enAddress,u8Tmp,300);
     }
 }
 
 
 /*
- * Update IR sending in loop
+ * Start repeating the last command of a locomotive, called after a new
+ * command was sent. Repeats still pending from an older command are dropped.
+ * 
+ * \param enAddress  Address, only enMaerklin292xxIrAddressG...J are repeated
+ * 
+ * \param u8Function Function of the frame which was sent
  */
-void Maerklin292xxIr_Update(void)
+static void armRepeat(en_maerklin_292xx_ir_address_t enAddress, uint8_t u8Function)
 {
+    stc_maerklin_292xx_ir_repeat_t* pstcRepeat;
+
     //
     // Sending repeated commands is only supported by locomotives with addresses > D
     //
-    if ((u8Repeat > 0) && (enLastAddress > enMaerklin292xxIrAddressD) && ((millis() - u32LastUpdate) > u32UpdateRate))
+    if (enAddress <= enMaerklin292xxIrAddressD)
+    {
+      return;
+    }
+    pstcRepeat = &astcRepeat[Maerklin292xxIrFrame_GetSlot(enAddress)];
+    pstcRepeat->u32RepeatsDropped += pstcRepeat->u8Repeat;
+    pstcRepeat->u8State = u8Function;
+    pstcRepeat->u32LastUpdate = millis();
+    if (pstcRepeat->u8State & 0x0f)
+    {
+      pstcRepeat->u8Repeat = 3;
+      pstcRepeat->u32UpdateRate = REPEAT_RATE_FUNCTION_MS;
+    } else
     {
-      u32LastUpdate = millis();
-      Maerklin292xxIr_Send(enLastAddress,au8LastStates[(uint8_t)enLastAddress]);
-      u8Repeat--;
+      pstcRepeat->u8Repeat = 10;
+      pstcRepeat->u32UpdateRate = REPEAT_RATE_DRIVE_MS;
+    }
+}
+
+/*
+ * Send one pending repeat, locomotives assigned to the IR LED are served
+ * round robin
+ * 
+ * \param u8Emitter  IR LED 0...MAERKLIN292XXIR_MAX_EMITTERS-1
+ * 
+ * \return true if a frame was sent
+ */
+static bool sendRepeat(uint8_t u8Emitter)
+{
+    stc_maerklin_292xx_ir_emitter_t* pstcEmitter = &astcEmitters[u8Emitter];
+    stc_maerklin_292xx_ir_repeat_t* pstcRepeat;
+    en_maerklin_292xx_ir_address_t enAddress;
+    uint8_t u8Slot;
+    int i;
 
-      //
-      // was last repeated command?
-      //
-      if (u8Repeat == 0)
+    for(i = 0; i < MAERKLIN292XXIR_ADDRESS_COUNT; i++)
+    {
+      u8Slot = (pstcEmitter->u8RepeatSlot + i) % MAERKLIN292XXIR_ADDRESS_COUNT;
+      pstcRepeat = &astcRepeat[u8Slot];
+      if ((au8EmitterOfSlot[u8Slot] == u8Emitter) && (pstcRepeat->u8Repeat > 0) && ((millis() - pstcRepeat->u32LastUpdate) > pstcRepeat->u32UpdateRate))
       {
+        enAddress = Maerklin292xxIrFrame_GetAddress(u8Slot);
+        pstcEmitter->u8RepeatSlot = (u8Slot + 1) % MAERKLIN292XXIR_ADDRESS_COUNT;
+        transmit(u8Emitter,enAddress,pstcRepeat->u8State);
+        pstcRepeat->u32LastUpdate = millis();
+        pstcRepeat->u32RepeatsSent++;
+        pstcRepeat->u8Repeat--;
+
         //
         // if was a sound or light function, repeat 2 times the current driving command
         //
-        if (au8LastStates[(uint8_t)enLastAddress] & 0x0f)
+        if ((pstcRepeat->u8Repeat == 0) && (pstcRepeat->u8State & 0x0f))
         {
-           u8Repeat = 2;
-           au8LastStates[(uint8_t)enLastAddress] = au8LastStates[(uint8_t)enLastAddress] & 0xf0;
+          pstcRepeat->u8Repeat = 2;
+          pstcRepeat->u8State &= 0xf0;
+          pstcRepeat->u32UpdateRate = REPEAT_RATE_DRIVE_MS;
         }
+        return true;
+      }
+    }
+    return false;
+}
+
+/*
+ * Get number of frames waiting in the transmit queues of all IR LEDs
+ * 
+ * \return number of queued frames
+ */
+uint32_t Maerklin292xxIr_GetQueueCount(void)
+{
+    uint32_t u32Count = 0;
+    int i;
+    for(i = 0; i < MAERKLIN292XXIR_MAX_EMITTERS; i++)
+    {
+      u32Count += astcEmitters[i].u8TxQueueCount;
+    }
+    return u32Count;
+}
+
+/*
+ * Get IR LED used by a locomotive
+ * 
+ * \param enAddress  Address, can be enMaerklin292xxIrAddressA...J
+ * 
+ * \return IR LED 0...MAERKLIN292XXIR_MAX_EMITTERS-1 or -1 if the address is invalid
+ */
+int Maerklin292xxIr_GetEmitter(en_maerklin_292xx_ir_address_t enAddress)
+{
+    int slot = Maerklin292xxIrFrame_GetSlot(enAddress);
+    if (slot < 0)
+    {
+      return -1;
+    }
+    return au8EmitterOfSlot[slot];
+}
+
+/*
+ * Get speed mailbox counters of a locomotive
+ * 
+ * \param enAddress  Address, can be enMaerklin292xxIrAddressA...J
+ * 
+ * \param pu32Updates   returns number of speed updates received
+ * 
+ * \param pu32Coalesced returns number of speed updates replaced by a newer one before they were sent
+ * 
+ * \return false if the address is invalid
+ */
+bool Maerklin292xxIr_GetSpeedStats(en_maerklin_292xx_ir_address_t enAddress, uint32_t* pu32Updates, uint32_t* pu32Coalesced)
+{
+    int slot = Maerklin292xxIrFrame_GetSlot(enAddress);
+    if (slot < 0)
+    {
+      return false;
+    }
+    *pu32Updates = astcMailbox[slot].u32Updates;
+    *pu32Coalesced = astcMailbox[slot].u32Coalesced;
+    return true;
+}
+
+/*
+ * Get repeat counters of a locomotive
+ * 
+ * \param enAddress  Address, can be enMaerklin292xxIrAddressA...J
+ * 
+ * \param pu32Sent    returns number of repeated frames sent
+ * 
+ * \param pu32Dropped returns number of repeats dropped because a newer command superseded them
+ * 
+ * \return false if the address is invalid
+ */
+bool Maerklin292xxIr_GetRepeatStats(en_maerklin_292xx_ir_address_t enAddress, uint32_t* pu32Sent, uint32_t* pu32Dropped)
+{
+    int slot = Maerklin292xxIrFrame_GetSlot(enAddress);
+    if (slot < 0)
+    {
+      return false;
+    }
+    *pu32Sent = astcRepeat[slot].u32RepeatsSent;
+    *pu32Dropped = astcRepeat[slot].u32RepeatsDropped;
+    return true;
+}
+
+/*
+ * Called by IrTransmitter_Update() when a frame is completely sent
+ * 
+ * \param u8Emitter  IR LED 0...MAERKLIN292XXIR_MAX_EMITTERS-1
+ */
+static void transmitDone(uint8_t u8Emitter)
+{
+    if (u8Emitter < MAERKLIN292XXIR_MAX_EMITTERS)
+    {
+      astcEmitters[u8Emitter].u32LastTx = millis();
+    }
+}
+
+/*
+ * Update IR sending of one IR LED
+ * 
+ * \param u8Emitter  IR LED 0...MAERKLIN292XXIR_MAX_EMITTERS-1
+ * 
+ * \return true if the IR LED is still sending or waiting for a frame
+ */
+static bool updateEmitter(uint8_t u8Emitter)
+{
+    stc_maerklin_292xx_ir_emitter_t* pstcEmitter = &astcEmitters[u8Emitter];
+    stc_maerklin_292xx_ir_frame_t* pstcFrame;
+
+    //
+    // Frame still on the air, the pause starts when it is finished
+    //
+    if (IrTransmitter_IsBusy(u8Emitter))
+    {
+      return true;
+    }
+
+    //
+    // Pause between frames not elapsed yet
+    //
+    if ((millis() - pstcEmitter->u32LastTx) < pstcEmitter->u32TxGap)
+    {
+      return false;
+    }
+
+    //
+    // Queued commands have priority over pending speeds, pending speeds over repeated commands
+    //
+    if (pstcEmitter->u8TxQueueCount == 0)
+    {
+      serviceMailbox(u8Emitter);
+    }
+    if (pstcEmitter->u8TxQueueCount > 0)
+    {
+      pstcFrame = &pstcEmitter->astcTxQueue[pstcEmitter->u8TxQueueHead];
+      if ((millis() - pstcEmitter->u32LastTx) < pstcFrame->u16DelayMs)
+      {
+        return false;
+      }
+      pstcEmitter->u8TxQueueHead = (pstcEmitter->u8TxQueueHead + 1) % MAERKLIN292XXIR_TX_QUEUE_SIZE;
+      pstcEmitter->u8TxQueueCount--;
+      transmit(u8Emitter,pstcFrame->enAddress,pstcFrame->u8Function);
+      armRepeat(pstcFrame->enAddress,pstcFrame->u8Function);
+      return IrTransmitter_IsBusy(u8Emitter);
+    }
+
+    return (sendRepeat(u8Emitter) && IrTransmitter_IsBusy(u8Emitter));
+}
+
+/*
+ * Update IR sending in loop
+ * 
+ * Every IR LED sends at most one frame per call. With a non-blocking
+ * transmitter (ESP32 RMT, RP2040 PIO) the frames of all IR LEDs are on the air in
+ * parallel, otherwise the caller is blocked for the air time of one
+ * frame per IR LED.
+ */
+void Maerklin292xxIr_Update(void)
+{
+    bool bBusy = false;
+    int i;
+
+    IrTransmitter_Update();
+    for(i = 0; i < MAERKLIN292XXIR_MAX_EMITTERS; i++)
+    {
+      if (astcEmitters[i].bEnabled)
+      {
+        bBusy |= updateEmitter(i);
       }
     }
+    UserLedButton_SetLed(bBusy);
 }
 
 /**
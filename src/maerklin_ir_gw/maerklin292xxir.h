@@ -67,6 +67,7 @@ extern "C"
  */
 
 #include <stdint.h>
+#include "maerklin292xxirframe.h"
 
 /**
  *******************************************************************************
@@ -75,76 +76,15 @@ extern "C"
  */
 
 //#define MAERKLIN292XXIR_IR_PIN 4 //Moved to appconfig.h, INITIAL_GPIO_IR, use http://maerklin292xx-gateway.local/config/ to configure GPIO pin usage
+
+#define MAERKLIN292XXIR_TX_QUEUE_SIZE 32 //frames waiting for transmission, per IR LED
+#define MAERKLIN292XXIR_MAX_EMITTERS 4   //IR LEDs, GPIOs are configured via GpioIr...GpioIr4
 /**
  *******************************************************************************
  ** Global type definitions ('typedef') 
  *******************************************************************************
  */
 
-typedef enum en_maerklin_292xx_ir_address
-{
-  enMaerklin292xxIrAddressA = 0x1,
-  enMaerklin292xxIrAddressB = 0x2,
-  enMaerklin292xxIrAddressC = 0x3,
-  enMaerklin292xxIrAddressD = 0x4,
-  enMaerklin292xxIrAddressG = 0x7,
-  enMaerklin292xxIrAddressH = 0x8,
-  enMaerklin292xxIrAddressI = 0x9,
-  enMaerklin292xxIrAddressJ = 0xa,
-} en_maerklin_292xx_ir_address_t;
-
-
-typedef enum en_maerklin_292xx_ir_func
-{
-  enMaerklin292xxIrFuncStop = 0,
-  enMaerklin292xxIrFuncBackward = 1,
-  enMaerklin292xxIrFuncForward = 2,
-  enMaerklin292xxIrFuncSound1 = 3,
-  enMaerklin292xxIrFuncSoundDoorClose = 3,
-  enMaerklin292xxIrFuncSoundCoupler = 3,
-  enMaerklin292xxIrFuncSound2 = 4,
-  enMaerklin292xxIrFuncSoundHorn = 4,
-  enMaerklin292xxIrFuncSound3 = 5,
-  enMaerklin292xxIrFuncSoundMotor = 5,
-  enMaerklin292xxIrFuncSoundAnnouncement = 5,
-  enMaerklin292xxIrFuncLight = 6,
-  enMaerklin292xxIrFuncSpeedForward1 = 0x10,
-  enMaerklin292xxIrFuncSpeedForward2 = 0x20,
-  enMaerklin292xxIrFuncSpeedForward3 = 0x30,
-  enMaerklin292xxIrFuncSpeedBackward1 = 0x40,
-  enMaerklin292xxIrFuncSpeedBackward2 = 0x50,
-  enMaerklin292xxIrFuncSpeedBackward3 = 0x60,
-  enMaerklin292xxIrFuncSpeedStop = 0x70,
-} en_maerklin_292xx_ir_func_t;
-
-typedef uint16_t maerklin_292xx_ir_code_t;
-
-typedef struct stc_maerklin_292xx_ir_codeset
-{
-  maerklin_292xx_ir_code_t codes[2];
-} stc_maerklin_292xx_ir_codeset_t;
-
-typedef struct stc_maerklin_292xx_ir_channelset
-{
-  stc_maerklin_292xx_ir_codeset_t stop;
-  stc_maerklin_292xx_ir_codeset_t backward;
-  stc_maerklin_292xx_ir_codeset_t forward;
-  stc_maerklin_292xx_ir_codeset_t light;
-  union {
-    stc_maerklin_292xx_ir_codeset_t sound1;
-    stc_maerklin_292xx_ir_codeset_t soundDoorClose;
-    stc_maerklin_292xx_ir_codeset_t soundCoupler;
-  };
-  union {
-    stc_maerklin_292xx_ir_codeset_t sound2;
-    stc_maerklin_292xx_ir_codeset_t soundHorn;
-  };
-  union {  
-    stc_maerklin_292xx_ir_codeset_t sound3;
-    stc_maerklin_292xx_ir_codeset_t soundMotor;
-    stc_maerklin_292xx_ir_codeset_t soundAnnouncement;
-  };
-} stc_maerklin_292xx_ir_channelset_t;
 
 /**
  *******************************************************************************
@@ -161,8 +101,13 @@ typedef struct stc_maerklin_292xx_ir_channelset
 void Maerklin292xxIr_Init(void);
 void Maerklin292xxIr_Send(en_maerklin_292xx_ir_address_t enAddress, uint8_t enFunction);
 void Maerklin292xxIr_SetSpeed(en_maerklin_292xx_ir_address_t enAddress, int speed);
+void Maerklin292xxIr_ResyncSpeed(en_maerklin_292xx_ir_address_t enAddress);
 void Maerklin292xxIr_ToggleSoundLight(en_maerklin_292xx_ir_address_t enAddress, en_maerklin_292xx_ir_func_t enFunction);
 void Maerklin292xxIr_Update(void);
+uint32_t Maerklin292xxIr_GetQueueCount(void);
+int Maerklin292xxIr_GetEmitter(en_maerklin_292xx_ir_address_t enAddress);
+bool Maerklin292xxIr_GetSpeedStats(en_maerklin_292xx_ir_address_t enAddress, uint32_t* pu32Updates, uint32_t* pu32Coalesced);
+bool Maerklin292xxIr_GetRepeatStats(en_maerklin_292xx_ir_address_t enAddress, uint32_t* pu32Sent, uint32_t* pu32Dropped);
 
 //@} // Maerklin292xxIrGroup
 
@@ -0,0 +1,567 @@
+/**
+ *******************************************************************************
+ ** Copyright © 2021 io-expert.com. All rights reserved.
+ **
+ ** 1. Redistributions of source code must retain the above copyright notice,
+ **    this condition and the following disclaimer.
+ **
+ ** This software is provided by the copyright holder and contributors "AS IS"
+ ** and any warranties related to this software are DISCLAIMED.
+ ** The copyright owner or contributors be NOT LIABLE for any damages caused
+ ** by use of this software.
+
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ **\file maerklin292xxirframe.c
+ **
+ ** Maerklin292xx IR frame encoding
+ ** A detailed description is available at
+ ** @link Maerklin292xxIrFrameGroup file description @endlink
+ **
+ ** Protocols:
+ **
+ ** locomotives addresses A-B:
+ ** ==========================
+ **
+ **  _____             ......... _____             .........
+ ** |  S  | 1st 8-bits . delay .|  S  | 2nd 8-bits . delay .
+ ** |     |____________.........|     |____________.........
+ **  20ms    2.5ms*8      45ms    20ms    2.5ms*8    200ms
+ **
+ ** |<---- High ---->|   |<---- Low  ---->|
+ **  _____                 __________
+ ** |     |               |          | 
+ ** |     |__________     |          |_____
+ **  0.6ms    1.7ms           1.7ms   0.6ms
+ **
+ ** locomotives addresses C-D:
+ ** ==========================
+ **
+ **  _____             .........
+ ** |  S  |   8-bits   . delay .
+ ** |     |____________.........
+ **  5.4ms    2.5ms*8    50ms
+ **
+ **  bit   description
+ **  7     toggle bit
+ **  6..4  command
+ **  3..0  address, C: 0b0101, D: 0b1010
+ **
+ ** |<---- High ---->|   |<---- Low  ---->|
+ **  _____                 __________
+ ** |     |               |          | 
+ ** |     |__________     |          |_____
+ **  0.6ms    1.7ms           1.7ms   0.6ms
+ **
+ ** locomotives addresses G-H:
+ ** ==========================
+ **  _____                              .........
+ ** |  S  |   7-bits + 7-bits inverted  . delay .
+ ** |     |_____________________________.........
+ **  4.1ms              ...             min. 20ms
+ **
+ **  bit   description
+ **  6     address 0 = G, 1 = H
+ **  5..3  speed
+ **  2..0  function
+ **
+ ** |<---- Low ---->|      |<---- High  ---->|
+ **  ______                 __________
+ ** |      |               |          | 
+ ** |      |_______        |          |_____
+ **  0.5ms   0.5ms           1.5ms    0.5ms
+ **
+ ** locomotives addresses I-J:
+ ** ==========================
+ **  _____ ___                               ___ .........
+ ** |  S  | 1 |    7-bits + 7-bits inverted | 0 |. delay .
+ ** |     |___|_____________________________|___|.........
+ **  4.1ms  1             ...                 0  min. 20ms
+ **
+ **  bit   description
+ **  6     address 0 = G, 1 = H
+ **  5..3  speed
+ **  2..0  function
+ **
+ ** |<---- Low ---->|      |<---- High  ---->|
+ **  ______                 __________
+ ** |      |               |          | 
+ ** |      |_______        |          |_____
+ **  0.5ms   0.5ms           1.5ms    0.5ms
+ **
+ ** History:
+ ** - 2026-10-17  1.00  First version, IR frame encoding moved out of maerklin292xxir.cpp
+ *******************************************************************************
+ */
+
+#define __MAERKLIN292XXIRFRAME_C__
+
+/**
+ *******************************************************************************
+ ** Include files
+ *******************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "maerklin292xxirframe.h"
+
+/**
+ *******************************************************************************
+ ** Local pre-processor symbols/macros ('#define') 
+ *******************************************************************************
+ */
+
+#if !defined(ARDUINO_ARCH_ESP8266)
+  #define MAERKLIN292XXIRFRAME_USE_CACHE //~14kB RAM, too much for ESP8266
+#endif
+#define FRAME_CACHE_AD_COUNT (4 * 8 * 2)  ///< addresses A-D * functions * toggle bit
+#define FRAME_CACHE_GJ_COUNT (4 * 7 * 5)  ///< addresses G-J * speeds * functions
+
+/**
+ *******************************************************************************
+ ** Global variable definitions (declared in header file with 'extern') 
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** Local type definitions ('typedef') 
+ *******************************************************************************
+ */
+
+/**
+ *******************************************************************************
+ ** Local variable definitions ('static') 
+ *******************************************************************************
+ */
+
+static uint16_t au16Scratch[MAERKLIN292XXIR_FRAME_MAX_LEN];
+#if defined(MAERKLIN292XXIRFRAME_USE_CACHE)
+static uint16_t au16FrameCache[FRAME_CACHE_AD_COUNT + FRAME_CACHE_GJ_COUNT][MAERKLIN292XXIR_FRAME_MAX_LEN];
+static uint8_t au8FrameCacheLen[FRAME_CACHE_AD_COUNT + FRAME_CACHE_GJ_COUNT];
+#endif
+
+static const stc_maerklin_292xx_ir_channelset_t stcChannelSetA = {
+  {0x77,0x77}, //stop
+  {0x1e59,0xe9b3}, //backward
+  {0x95e1,0x315d}, //forward  
+  {0x55,0x55}, //light
+  {0xdd,0xdd}, //sound1
+  {0xbb,0xbb}, //sound2 
+  {0x33,0x33}  //sound3 
+};
+
+static const stc_maerklin_292xx_ir_channelset_t stcChannelSetB = {
+  {0xee,0xee}, //stop     
+  {0xd731,0x935d}, //backward 
+  {0x15bd,0x5e73}, //forward
+  {0xd1,0xd1}, //light 
+  {0x59,0x59}, //sound1 
+  {0x11,0x11}, //sound2 
+  {0x99,0x99}  //sound3 
+};
+
+static const en_maerklin_292xx_ir_address_t aenAddresses[MAERKLIN292XXIR_ADDRESS_COUNT] = {
+  enMaerklin292xxIrAddressA,
+  enMaerklin292xxIrAddressB,
+  enMaerklin292xxIrAddressC,
+  enMaerklin292xxIrAddressD,
+  enMaerklin292xxIrAddressG,
+  enMaerklin292xxIrAddressH,
+  enMaerklin292xxIrAddressI,
+  enMaerklin292xxIrAddressJ
+};
+
+/**
+ *******************************************************************************
+ ** Local function prototypes ('static') 
+ *******************************************************************************
+ */
+
+#if defined(MAERKLIN292XXIRFRAME_USE_CACHE)
+static int getFrameIndex(en_maerklin_292xx_ir_address_t enAddress, uint8_t u8Function, bool bToggle);
+static void buildFrameCache(void);
+#endif
+
+/**
+ *******************************************************************************
+ ** Function implementation - global ('extern') and local ('static') 
+ *******************************************************************************
+ */
+
+/*
+ * Init frame encoding, builds the frame cache if enabled
+ */
+void Maerklin292xxIrFrame_Init(void)
+{
+#if defined(MAERKLIN292XXIRFRAME_USE_CACHE)
+  buildFrameCache();
+#endif
+}
+
+/*
+ * Get index of an address in per-address tables
+ * 
+ * \param enAddress  Address, can be enMaerklin292xxIrAddressA...J
+ * 
+ * \return index 0...MAERKLIN292XXIR_ADDRESS_COUNT-1 or -1 if address is invalid
+ */
+int Maerklin292xxIrFrame_GetSlot(en_maerklin_292xx_ir_address_t enAddress)
+{
+  if ((enAddress >= enMaerklin292xxIrAddressA) && (enAddress <= enMaerklin292xxIrAddressD))
+  {
+    return (int)enAddress - (int)enMaerklin292xxIrAddressA;
+  }
+  if ((enAddress >= enMaerklin292xxIrAddressG) && (enAddress <= enMaerklin292xxIrAddressJ))
+  {
+    return (int)enAddress - (int)enMaerklin292xxIrAddressG + 4;
+  }
+  return -1;
+}
+
+/*
+ * Get address of an index in per-address tables
+ * 
+ * \param slot index 0...MAERKLIN292XXIR_ADDRESS_COUNT-1
+ * 
+ * \return address
+ */
+en_maerklin_292xx_ir_address_t Maerklin292xxIrFrame_GetAddress(int slot)
+{
+  return aenAddresses[slot];
+}
+
+/*
+ * Encode a frame into mark / space timings, as used by IRsend::sendRaw()
+ * 
+ * \param enAddress  Address, can be enMaerklin292xxIrAddressA...J
+ * 
+ * \param enFunction Function, can be one of en_maerklin_292xx_ir_func_t defined in maerklin292xxirframe.h
+ * 
+ * \param bToggle    state of the toggle bit (addresses A-D only)
+ * 
+ * \param pu16Timings buffer for at least MAERKLIN292XXIR_FRAME_MAX_LEN timings in us
+ * 
+ * \return number of timings, 0 if there is nothing to send
+ */
+uint8_t Maerklin292xxIrFrame_Encode(en_maerklin_292xx_ir_address_t enAddress, uint8_t enFunction, bool bToggle, uint16_t* pu16Timings)
+{
+  uint8_t u8Command = 0;
+  uint8_t u8Command2 = 0;
+  uint8_t u8Offset = 0;
+  uint16_t u16Tmp = 0;
+  int i;
+
+  //
+  //  Handle Locos type address A & B
+  //
+  if ((enAddress == enMaerklin292xxIrAddressA) || (enAddress == enMaerklin292xxIrAddressB))
+  {
+      const stc_maerklin_292xx_ir_channelset_t* pstcChannelSet = 0;
+      const stc_maerklin_292xx_ir_codeset_t* pstcCodeSet = 0;
+      pu16Timings[0] = 20000;
+      pu16Timings[17] = 45000;
+      pu16Timings[18] = 20000;
+
+      //
+      // Select address
+      //
+      if (enAddress == enMaerklin292xxIrAddressA)
+      {
+          pstcChannelSet = &stcChannelSetA;
+      } else
+      {
+          pstcChannelSet = &stcChannelSetB;
+      }
+
+      //
+      // Check for command
+      //
+      switch(enFunction)
+      {
+        case enMaerklin292xxIrFuncStop:
+          pstcCodeSet = &pstcChannelSet->stop;
+          break;
+        case enMaerklin292xxIrFuncBackward:
+          pstcCodeSet = &pstcChannelSet->backward;
+          break;
+        case enMaerklin292xxIrFuncForward:
+          pstcCodeSet = &pstcChannelSet->forward;
+          break;
+        case enMaerklin292xxIrFuncLight:
+          pstcCodeSet = &pstcChannelSet->light;
+          break;
+        case enMaerklin292xxIrFuncSound1:
+          pstcCodeSet = &pstcChannelSet->sound1;
+          break;
+        case enMaerklin292xxIrFuncSound2:
+          pstcCodeSet = &pstcChannelSet->sound2;
+          break;
+        case enMaerklin292xxIrFuncSound3:
+          pstcCodeSet = &pstcChannelSet->sound3;
+          break;
+      }
+      if (pstcCodeSet == 0) return 0;
+
+      //
+      //  Choose command depending on toggle bit
+      //
+      if (bToggle)
+      {
+        u8Command = pstcCodeSet->codes[1] & 0xff;
+        u8Command2 = (pstcCodeSet->codes[1] >> 8) & 0xff;
+      } else {
+        u8Command = pstcCodeSet->codes[0] & 0xff;
+        u8Command2 = (pstcCodeSet->codes[0] >> 8) & 0xff;
+      }
+  } 
+  
+  //
+  //  Handle Locos type address C & D
+  //
+  else if ((enAddress == enMaerklin292xxIrAddressC) || (enAddress == enMaerklin292xxIrAddressD))
+  {
+      pu16Timings[0] = 5400;
+      pu16Timings[17] = 10000;
+      pu16Timings[18] = 5400;
+      u8Command = (((uint8_t)enFunction & 0x7) << 4);
+      if (enAddress == enMaerklin292xxIrAddressC)
+      {
+        u8Command |= 0x05; 
+      } else
+      {
+        u8Command |= 0x0a; 
+      }
+      if (bToggle)
+      {
+        u8Command |= 0x80;
+      }
+  } 
+
+  //
+  //  Handle Locos type address G, H, I & J
+  //
+  else if ((enAddress == enMaerklin292xxIrAddressG) || (enAddress == enMaerklin292xxIrAddressH) || (enAddress == enMaerklin292xxIrAddressI) || (enAddress == enMaerklin292xxIrAddressJ))
+  {
+      pu16Timings[0] = 4100;
+      pu16Timings[1] = 550;
+      if ((enAddress == enMaerklin292xxIrAddressI) || (enAddress == enMaerklin292xxIrAddressJ))
+      {
+        u8Offset = 2;
+        pu16Timings[2] = 1500;
+        pu16Timings[3] = 550;
+        pu16Timings[32] = 550;
+      }
+      if ((enAddress == enMaerklin292xxIrAddressH) || (enAddress == enMaerklin292xxIrAddressJ))
+      {
+        u16Tmp |= (1 << 6);
+      }
+      if ((enFunction & 0x70) == 0)
+      {
+        enFunction = (enFunction & ~0x70) | enMaerklin292xxIrFuncSpeedStop;
+      }
+      u16Tmp |= ((enFunction & 0x70) >> 1) & 0x38;
+      switch(enFunction & 0x0f)
+      {
+        case enMaerklin292xxIrFuncLight:
+           u16Tmp |= 0x4;
+           break; 
+        case enMaerklin292xxIrFuncSoundHorn:
+           u16Tmp |= 0x3;
+           break; 
+        case enMaerklin292xxIrFuncSoundAnnouncement:
+           u16Tmp |= 0x2;
+           break; 
+        case enMaerklin292xxIrFuncSound1:
+           u16Tmp |= 0x1;
+           break; 
+        default:
+           break;
+      }
+      u16Tmp = (u16Tmp << 7) | (~u16Tmp & 0x7f);
+      for(i = 0;i < 14;i++)
+      {
+        if ((u16Tmp & (1 << 13)) != 0) 
+        {
+          pu16Timings[i*2 + 2 + u8Offset] = 1500;
+          pu16Timings[i*2 + 3 + u8Offset] = 550;
+        } else {
+          pu16Timings[i*2 + 2 + u8Offset] = 550;
+          pu16Timings[i*2 + 3 + u8Offset] = 550;
+        }
+        u16Tmp = u16Tmp << 1;
+      }
+      return 29 + 2 * u8Offset;
+  } else
+  {
+      return 0;
+  }
+
+  //
+  //  Addresses A-D, 2 times 8 bits
+  //
+  for(i = 0;i < 8;i++)
+  {
+    if ((u8Command & 0x80) != 0) 
+    {
+      pu16Timings[i*2 + 1] = 1700;
+      pu16Timings[i*2 + 2] = 600;
+      pu16Timings[i*2 + 19] = 1700;
+      pu16Timings[i*2 + 20] = 600;
+    } else {
+      pu16Timings[i*2 + 1] = 600;
+      pu16Timings[i*2 + 2] = 1700;
+      pu16Timings[i*2 + 19] = 600;
+      pu16Timings[i*2 + 20] = 1700;
+    }
+    u8Command = u8Command << 1;
+  }
+  if (u8Command2 != 0)
+  {
+    for(i = 0;i < 8;i++)
+    {
+      if ((u8Command2 & 0x80) != 0) 
+      {
+        pu16Timings[i*2 + 19] = 1700;
+        pu16Timings[i*2 + 20] = 600;
+      } else {
+        pu16Timings[i*2 + 19] = 600;
+        pu16Timings[i*2 + 20] = 1700;
+      }
+      u8Command2 = u8Command2 << 1;
+    }
+  }
+  return 35;
+}
+
+#if defined(MAERKLIN292XXIRFRAME_USE_CACHE)
+/*
+ * Get index of a frame in the frame cache
+ * 
+ * \param enAddress  Address, can be enMaerklin292xxIrAddressA...J
+ * 
+ * \param u8Function Function, can be one of en_maerklin_292xx_ir_func_t defined in maerklin292xxirframe.h
+ * 
+ * \param bToggle    state of the toggle bit (addresses A-D only)
+ * 
+ * \return index of the frame or -1 if there is no such frame
+ */
+static int getFrameIndex(en_maerklin_292xx_ir_address_t enAddress, uint8_t u8Function, bool bToggle)
+{
+  int slot = Maerklin292xxIrFrame_GetSlot(enAddress);
+  uint8_t u8Speed;
+  uint8_t u8Code;
+  if (slot < 0)
+  {
+    return -1;
+  }
+
+  //
+  // A-D: 8 functions with toggle bit
+  //
+  if (slot < 4)
+  {
+    if ((slot < 2) && (u8Function > 7))
+    {
+      return -1; //A-B: no such code
+    }
+    return ((slot * 8) + (u8Function & 0x7)) * 2 + (bToggle ? 1 : 0);
+  }
+
+  //
+  // G-J: 7 speeds (speed 0 is sent as stop) and 5 functions
+  //
+  u8Speed = (u8Function >> 4) & 0x7;
+  if (u8Speed == 0)
+  {
+    u8Speed = enMaerklin292xxIrFuncSpeedStop >> 4;
+  }
+  switch(u8Function & 0x0f)
+  {
+    case enMaerklin292xxIrFuncLight:
+       u8Code = 4;
+       break; 
+    case enMaerklin292xxIrFuncSoundHorn:
+       u8Code = 3;
+       break; 
+    case enMaerklin292xxIrFuncSoundAnnouncement:
+       u8Code = 2;
+       break; 
+    case enMaerklin292xxIrFuncSound1:
+       u8Code = 1;
+       break; 
+    default:
+       u8Code = 0;
+       break;
+  }
+  return FRAME_CACHE_AD_COUNT + (((slot - 4) * 7) + (u8Speed - 1)) * 5 + u8Code;
+}
+
+/*
+ * Build all frames once, so sending is a lookup only
+ */
+static void buildFrameCache(void)
+{
+  en_maerklin_292xx_ir_address_t enAddress;
+  int index;
+  int i;
+  int u8Function;
+  for(i = 0; i < MAERKLIN292XXIR_ADDRESS_COUNT; i++)
+  {
+    enAddress = aenAddresses[i];
+    for(u8Function = 0; u8Function < 0x80; u8Function++)
+    {
+      index = getFrameIndex(enAddress,u8Function,false);
+      if (index >= 0)
+      {
+        au8FrameCacheLen[index] = Maerklin292xxIrFrame_Encode(enAddress,u8Function,false,au16FrameCache[index]);
+      }
+      index = getFrameIndex(enAddress,u8Function,true);
+      if ((index >= 0) && (enAddress <= enMaerklin292xxIrAddressD))
+      {
+        au8FrameCacheLen[index] = Maerklin292xxIrFrame_Encode(enAddress,u8Function,true,au16FrameCache[index]);
+      }
+    }
+  }
+}
+#endif
+
+/*
+ * Get the mark / space timings of a frame, from the cache if available
+ * 
+ * \param enAddress  Address, can be enMaerklin292xxIrAddressA...J
+ * 
+ * \param u8Function Function, can be one of en_maerklin_292xx_ir_func_t defined in maerklin292xxirframe.h
+ * 
+ * \param bToggle    state of the toggle bit (addresses A-D only)
+ * 
+ * \param pu8Len     returns number of timings, 0 if there is nothing to send
+ * 
+ * \return pointer to the timings in us, valid until the next call
+ */
+const uint16_t* Maerklin292xxIrFrame_Get(en_maerklin_292xx_ir_address_t enAddress, uint8_t u8Function, bool bToggle, uint8_t* pu8Len)
+{
+#if defined(MAERKLIN292XXIRFRAME_USE_CACHE)
+  int index = getFrameIndex(enAddress,u8Function,bToggle);
+  if (index < 0)
+  {
+    *pu8Len = 0;
+    return au16Scratch;
+  }
+  *pu8Len = au8FrameCacheLen[index];
+  return au16FrameCache[index];
+#else
+  *pu8Len = Maerklin292xxIrFrame_Encode(enAddress,u8Function,bToggle,au16Scratch);
+  return au16Scratch;
+#endif
+}
+
+/**
+ *******************************************************************************
+ ** EOF (not truncated)
+ *******************************************************************************
+ */
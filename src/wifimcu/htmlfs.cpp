@@ -58,6 +58,11 @@ const PLACE_IROM char au8index_html[] = "<html>\r\n"
 "\r\n"
 " //fetch(cmdString); \r\n"
 "\r\n"
+" if (wsOpen) { \r\n"
+" ws.send(selectedAddress + '/' + cmd + (args ? '/' + args : '')); \r\n"
+" return; \r\n"
+" } \r\n"
+"\r\n"
 " fetch(\"/api/cmd\", \r\n"
 " { \r\n"
 " method: \"POST\", \r\n"
@@ -78,6 +83,37 @@ const PLACE_IROM char au8index_html[] = "<html>\r\n"
 " } \r\n"
 " } \r\n"
 " } \r\n"
+" var ws = null; \r\n"
+" var wsOpen = false; \r\n"
+" var locoStates = {}; \r\n"
+"\r\n"
+" function wsConnect() { \r\n"
+" ws = new WebSocket('ws://' + location.hostname + ':81/'); \r\n"
+" ws.onopen = function() { \r\n"
+" wsOpen = true; \r\n"
+" document.getElementById(\"overlay\").style.display = \"none\"; \r\n"
+" }; \r\n"
+" ws.onclose = function() { \r\n"
+" wsOpen = false; \r\n"
+" setTimeout(wsConnect, 5000); \r\n"
+" }; \r\n"
+" ws.onmessage = function(event) { \r\n"
+" let state = JSON.parse(event.data); \r\n"
+" locoStates[state.loco] = state; \r\n"
+" showState(); \r\n"
+" }; \r\n"
+" } \r\n"
+"\r\n"
+" function showState() { \r\n"
+" let selected = document.querySelector('input[name=\"tab-group-address\"]:checked'); \r\n"
+" let state = selected ? locoStates[selected.value] : undefined; \r\n"
+" for (let speed = -3; speed <= 3; speed++) { \r\n"
+" let button = document.getElementById('speed' + speed); \r\n"
+" button.style.borderColor = (state && state.speed == speed) ? '#1189DC' : ''; \r\n"
+" } \r\n"
+" document.getElementById('light').style.borderColor = (state && (state.functions & 1)) ? '#1189DC' : ''; \r\n"
+" } \r\n"
+"\r\n"
 " var tapedTwice = false; \r\n"
 "\r\n"
 " function tapHandler(event) { \r\n"
@@ -96,6 +132,9 @@ const PLACE_IROM char au8index_html[] = "<html>\r\n"
 " function handleKeepAlive() \r\n"
 " { \r\n"
 " let overlay = document.getElementById(\"overlay\"); \r\n"
+" if (wsOpen) { \r\n"
+" return; // the gateway pings the WebSocket \r\n"
+" } \r\n"
 " fetch('/cmd/keepalive') \r\n"
 " .then(data => { \r\n"
 " console.log('Success:', data); \r\n"
@@ -127,6 +166,14 @@ const PLACE_IROM char au8index_html[] = "<html>\r\n"
 " requestFullScreen(); \r\n"
 " },100); \r\n"
 "\r\n"
+" window.addEventListener('load', function() { \r\n"
+" wsConnect(); \r\n"
+" }); \r\n"
+"\r\n"
+" document.addEventListener('change', function() { \r\n"
+" showState(); \r\n"
+" }); \r\n"
+"\r\n"
 " window.addEventListener('resize', function() { \r\n"
 " let logo = document.getElementById(\"logo\"); \r\n"
 " let main = document.getElementById(\"main\"); \r\n"
@@ -198,7 +245,7 @@ const PLACE_IROM char au8index_html[] = "<html>\r\n"
 "</p>\r\n"
 "<br>\r\n"
 "<p>\r\n"
-"<button onclick=\"execcmd('light','')\" style=width:24%>\r\n"
+"<button id=light onclick=\"execcmd('light','')\" style=width:24%>\r\n"
 "\r\n"
 "<svg class=mdi-icon viewbox=\"0 0 24 24\">\r\n"
 "<path fill=currentColor d=\"M13,4.8C9,4.8 9,19.2 13,19.2C17,19.2 22,16.5 22,12C22,7.5 17,4.8 13,4.8M13.1,17.2C12.7,16.8 12,15 12,12C12,9 12.7,7.2 13.1,6.8C16,6.9 20,8.7 20,12C20,15.3 16,17.1 13.1,17.2M2,5H9.5C9.3,5.4 9,5.8 8.9,6.4C8.8,6.6 8.8,6.8 8.7,7H2V5M8,11H2V9H8.2C8.1,9.6 8.1,10.3 8,11M8.7,17C8.9,17.8 9.2,18.4 9.6,19H2.1V17H8.7M8.2,15H2V13H8C8.1,13.7 8.1,14.4 8.2,15Z\"/>\r\n"
@@ -224,37 +271,37 @@ const PLACE_IROM char au8index_html[] = "<html>\r\n"
 "</button>\r\n"
 "</p>\r\n"
 "<p>\r\n"
-"<button onclick=\"execcmd('speed','-3')\">\r\n"
+"<button id=speed-3 onclick=\"execcmd('speed','-3')\">\r\n"
 "\r\n"
 "<svg class=mdi-icon viewbox=\"0 0 24 24\">\r\n"
 "<path fill=currentColor d=M17,5H14V19H17V5M12,5L1,12L12,19V5M22,5H19V19H22V5Z />\r\n"
 "</svg>\r\n"
 "</button>\r\n"
-"<button onclick=\"execcmd('speed','-2')\">\r\n"
+"<button id=speed-2 onclick=\"execcmd('speed','-2')\">\r\n"
 "\r\n"
 "<svg class=mdi-icon viewbox=\"0 0 24 24\">\r\n"
 "<path fill=currentColor d=M19,5V19H16V5M14,5V19L3,12 />\r\n"
 "</svg>\r\n"
 "</button>\r\n"
-"<button onclick=\"execcmd('speed','-1')\">\r\n"
+"<button id=speed-1 onclick=\"execcmd('speed','-1')\">\r\n"
 "\r\n"
 "<svg class=mdi-icon style=\"transform: rotate(180deg);\" viewbox=\"0 0 -12 -12\">\r\n"
 "<path fill=currentColor d=M8,5.14V19.14L19,12.14L8,5.14Z />\r\n"
 "</svg>\r\n"
 "</button>\r\n"
-"<button onclick=\"execcmd('speed','1')\">\r\n"
+"<button id=speed1 onclick=\"execcmd('speed','1')\">\r\n"
 "\r\n"
 "<svg class=mdi-icon viewbox=\"0 0 -12 -12\">\r\n"
 "<path fill=currentColor d=M8,5.14V19.14L19,12.14L8,5.14Z />\r\n"
 "</svg>\r\n"
 "</button>\r\n"
-"<button onclick=\"execcmd('speed','2')\">\r\n"
+"<button id=speed2 onclick=\"execcmd('speed','2')\">\r\n"
 "\r\n"
 "<svg class=mdi-icon viewbox=\"0 0 24 24\">\r\n"
 "<path fill=currentColor d=M5,5V19H8V5M10,5V19L21,12 />\r\n"
 "</svg>\r\n"
 "</button>\r\n"
-"<button onclick=\"execcmd('speed','3')\">\r\n"
+"<button id=speed3 onclick=\"execcmd('speed','3')\">\r\n"
 "\r\n"
 "<svg class=mdi-icon viewbox=\"0 0 24 24\">\r\n"
 "<path fill=currentColor d=M7,5H10V19H7V5M12,5L23,12L12,19V5M2,5H5V19H2V5Z />\r\n"
@@ -262,7 +309,7 @@ const PLACE_IROM char au8index_html[] = "<html>\r\n"
 "</button>\r\n"
 "</p>\r\n"
 "<p>\r\n"
-"<button onclick=\"execcmd('speed','0')\" style=width:50%>\r\n"
+"<button id=speed0 onclick=\"execcmd('speed','0')\" style=width:50%>\r\n"
 "\r\n"
 "<svg class=mdi-icon viewbox=\"0 0 24 24\">\r\n"
 "<path fill=currentColor d=M18,18H6V6H18V18Z />\r\n"
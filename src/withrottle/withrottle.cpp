@@ -50,7 +50,12 @@
 #endif
 #include "withrottle.h"
 #include <stdarg.h>
+#include <new>
 #include "../wifimcu/wifimcuctrl.h"
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <errno.h>
+  #include "lwip/sockets.h"
+#endif
 
 /**
  *******************************************************************************
@@ -58,7 +63,26 @@
  *******************************************************************************
  */
 
-#define MAX_CLIENTS 3
+#define MAX_CLIENTS_LIMIT 8          //upper limit, lwIP sockets are shared with the webserver
+#define MIN_CLIENTS 3                //clients supported before the pool was configurable, not reduced by the heap estimate
+#define HEAP_RESERVE 24576           //free heap left for the rest of the application
+#define HEAP_PER_CLIENT 6144         //estimated TCP buffers of a connection
+#define EVICT_IDLE_MS 10000          //a client must be idle that long before it is replaced by a new one
+#define HEARTBEAT_TIMEOUT_MS 10000   //twice the heartbeat of 5 s sent as "*5"
+#define SHORT_ADDRESS_COUNT 128      //short addresses 0..127 are mapped directly
+#if (WITHROTTLE_MAX_LOCOS <= 64)
+  #define LONG_HASH_BITS 7
+#elif (WITHROTTLE_MAX_LOCOS <= 256)
+  #define LONG_HASH_BITS 9
+#elif (WITHROTTLE_MAX_LOCOS <= 1024)
+  #define LONG_HASH_BITS 11
+#else
+  #error WITHROTTLE_MAX_LOCOS too large
+#endif
+#define LONG_HASH_SIZE (1 << LONG_HASH_BITS) //at least twice WITHROTTLE_MAX_LOCOS, keeps the probe sequences short
+#define ROSTER_HEADER_SIZE 8         //room for "RL<count>" in front of the roster entries
+#define MAX_FUNCTION_LABELS 28
+#define ALL_FUNCTIONS 0x0FFFFFFFUL   //F0...F27
 
 /**
  *******************************************************************************
@@ -72,6 +96,55 @@
  *******************************************************************************
  */
 
+typedef enum en_withrottle_cmd
+{
+  enWiThrottleCmdUnknown = 0,
+  enWiThrottleCmdPower,       //PPA<0|1>
+  enWiThrottleCmdName,        //N<name>
+  enWiThrottleCmdHardwareId,  //HU<id>
+  enWiThrottleCmdHeartbeat,   //*, *+, *-
+  enWiThrottleCmdQuit,        //Q
+  enWiThrottleCmdAcquire,     //MT+<address><;><address>
+  enWiThrottleCmdRelease,     //MT-<address><;>r
+  enWiThrottleCmdAction       //MTA<address><;><action>
+} en_withrottle_cmd_t;
+
+typedef enum en_withrottle_close_reason
+{
+  enWiThrottleCloseQuit = 0,     //client sent Q
+  enWiThrottleCloseHeartbeat,    //no data within the heartbeat timeout
+  enWiThrottleCloseIdle,         //idle client replaced by a new client
+  enWiThrottleCloseDisconnected  //connection lost
+} en_withrottle_close_reason_t;
+
+typedef enum en_withrottle_parse_state
+{
+  enWiThrottleParseStart = 0,
+  enWiThrottleParsePower,
+  enWiThrottleParsePowerA,
+  enWiThrottleParsePowerValue,
+  enWiThrottleParseHardware,
+  enWiThrottleParseThrottle,
+  enWiThrottleParseOperation,
+  enWiThrottleParseAddress,
+  enWiThrottleParseDigits,
+  enWiThrottleParseSeparator,
+  enWiThrottleParseSeparatorEnd
+} en_withrottle_parse_state_t;
+
+typedef struct stc_withrottle_cmd
+{
+  en_withrottle_cmd_t enCmd;
+  char throttleChar;   //multi throttle commands
+  char addressChar;    //L, S or *
+  int32_t i32Address;  //-1 for *, 0 if missing
+  uint8_t* pu8Arg;     //rest of the line, points into the receive buffer
+  uint16_t u16ArgLen;
+  char action;         //MTA: V, R, F, q, X, I, Q
+  char modifier;       //MTA: F<0|1>, q<V|R>
+  int32_t i32Value;    //PPA: 0/1, MTA: speed, direction or function
+} stc_withrottle_cmd_t;
+
 /**
  *******************************************************************************
  ** Local variable definitions ('static') 
@@ -79,11 +152,29 @@
  */
 
 static WiFiServer server(2560);
-static stc_withrottle_client_t serverClients[MAX_CLIENTS];
+static stc_withrottle_client_t* serverClients = NULL;
+static uint32_t u32ClientCount = 0;
+static uint32_t u32ClientsEvicted = 0;
+static uint32_t u32ClientsHeartbeat = 0;
+static uint32_t u32ClientsDisconnected = 0;
+static uint32_t u32LocosStopped = 0;
+static bool bStopLocos = true;
+static uint32_t u32TxQueued = 0;
+static uint32_t u32TxDropped = 0;
+static uint32_t u32TxStalled = 0;
 static bool trackPower = false;
 static pfn_withrottle_trackpower_callback_t _cbTrackPower = NULL;
 static pfn_withrottle_createloco_callback_t _cbCreateLoco = NULL;
-static stc_withrottle_loco_listitem_t* pLocoList = NULL;
+static stc_withrottle_loco_listitem_t* apLocos[WITHROTTLE_MAX_LOCOS];           //dense, in order of registration
+static uint32_t u32LocoCount = 0;
+static stc_withrottle_loco_listitem_t* apShortLocos[SHORT_ADDRESS_COUNT];     //indexed by short address
+static stc_withrottle_loco_listitem_t* apLongLocos[LONG_HASH_SIZE];          //open addressing, linear probing
+static char acRoster[WITHROTTLE_ROSTER_BUFFER_SIZE];                         //RL line followed by the labels of all locos
+static uint16_t u16RosterStart = 0;
+static uint16_t u16RosterLen = 0;
+static uint16_t au16LabelStart[WITHROTTLE_MAX_LOCOS];                         //indexed by u16Index of the loco
+static uint16_t au16LabelLen[WITHROTTLE_MAX_LOCOS];
+static bool bRosterValid = false;
 static bool debugMode = false;
 
 /**
@@ -92,13 +183,32 @@ static bool debugMode = false;
  *******************************************************************************
  */
 
-static void send(stc_withrottle_client_t* pClient, uint8_t* data,uint32_t u32Len);
+static bool sendData(stc_withrottle_client_t* pClient, uint8_t* data,uint32_t u32Len);
+static int writeNonBlocking(stc_withrottle_client_t* pClient, uint8_t* data, uint32_t u32Len);
+static void sendLocoState(stc_withrottle_client_t* pClient, char throttleChar, char addressChar, stc_withrottle_loco_t* pLoco, char state, uint8_t u8Function);
+static bool sendPendingStates(stc_withrottle_client_t* pClient);
+static bool subscribe(stc_withrottle_client_t* pClient, char throttleChar, char addressChar, stc_withrottle_loco_t* pLoco);
+static void unsubscribe(stc_withrottle_client_t* pClient, char throttleChar, stc_withrottle_loco_t* pLoco);
+static bool isSubscribed(stc_withrottle_client_t* pClient, char throttleChar, stc_withrottle_loco_t* pLoco);
+static void publish(void);
+static void buildRoster(void);
+static uint32_t functionCapabilities(stc_withrottle_loco_t* pLoco);
+static void sendFunctionLabels(stc_withrottle_client_t* pClient, char throttleChar, char addressChar, stc_withrottle_loco_t* pLoco);
+static uint32_t getFreeHeap(void);
+static void flush(stc_withrottle_client_t* pClient);
+static void stopLocos(stc_withrottle_client_t* pClient);
+static void closeClient(stc_withrottle_client_t* pClient, en_withrottle_close_reason_t enReason);
+static void receive(stc_withrottle_client_t* pClient);
+static void frame(stc_withrottle_client_t* pClient);
+static bool parse(uint8_t* pu8Line, uint16_t u16Len, stc_withrottle_cmd_t* pCmd);
+static void parseAction(stc_withrottle_cmd_t* pCmd);
+static void decode(stc_withrottle_client_t* pClient, uint8_t* pu8Line, uint16_t u16Len);
 static void sendString(stc_withrottle_client_t* pClient, char* str);
-static void decode_multithrottle(stc_withrottle_client_t* pClient, uint8_t* cmd);
-static int getInt(uint8_t * cmd);
-static int getLocoId(uint8_t * cmd);
+static void decode_multithrottle(stc_withrottle_client_t* pClient, stc_withrottle_cmd_t* pCmd);
+static int getInt(uint8_t * cmd, uint16_t u16Len);
 static stc_withrottle_loco_listitem* getLoco(int locoid);
-static void decode_loco_action(stc_withrottle_client_t* pClient, stc_withrottle_loco_t* pLoco, uint8_t* aval, char throttleChar, int cab);
+static uint32_t hashAddress(uint32_t u32Address);
+static void decode_loco_action(stc_withrottle_client_t* pClient, stc_withrottle_loco_t* pLoco, stc_withrottle_cmd_t* pCmd);
 
 /**
  *******************************************************************************
@@ -107,7 +217,44 @@ static void decode_loco_action(stc_withrottle_client_t* pClient, stc_withrottle_
  */
 
 /*********************************************
- * Send data to a connected client
+ * Send data to a connected client, data is put into the
+ * transmit ring and written by flush()
+ * 
+ * pClient Client handle
+ *
+ * data    Data buffer
+ *
+ * u32Len  Data length
+ * 
+ * \return false if the data did not fit and was dropped
+ * 
+ ********************************************* 
+ */
+static bool sendData(stc_withrottle_client_t* pClient, uint8_t* data,uint32_t u32Len)
+{
+  uint16_t u16Pos;
+  uint32_t u32Chunk;
+  if ((uint32_t)(WITHROTTLE_TX_BUFFER_SIZE - pClient->u16TxLen) < u32Len)
+  {
+    u32TxDropped += u32Len;
+    return false;
+  }
+  u16Pos = (pClient->u16TxHead + pClient->u16TxLen) % WITHROTTLE_TX_BUFFER_SIZE;
+  u32Chunk = WITHROTTLE_TX_BUFFER_SIZE - u16Pos;
+  if (u32Chunk > u32Len)
+  {
+    u32Chunk = u32Len;
+  }
+  memcpy(&pClient->au8TxBuffer[u16Pos], data, u32Chunk);
+  memcpy(pClient->au8TxBuffer, &data[u32Chunk], u32Len - u32Chunk);
+  pClient->u16TxLen += u32Len;
+  u32TxQueued += u32Len;
+  return true;
+}
+
+/*********************************************
+ * Write as much data as the TCP stack accepts
+ * without blocking
  * 
  * pClient Client handle
  *
@@ -115,11 +262,235 @@ static void decode_loco_action(stc_withrottle_client_t* pClient, stc_withrottle_
  *
  * u32Len  Data length
  * 
+ * \return number of bytes written, -1 if the connection is broken
+ * 
+ ********************************************* 
+ */
+static int writeNonBlocking(stc_withrottle_client_t* pClient, uint8_t* data, uint32_t u32Len)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  //
+  // WiFiClient::write() of ESP32 waits up to seconds while the send buffer is full, use the socket directly
+  //
+  int res = lwip_send(pClient->client.fd(), data, u32Len, MSG_DONTWAIT);
+  if (res < 0)
+  {
+    return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : -1;
+  }
+  return res;
+#else
+  int free = pClient->client.availableForWrite();
+  if (free <= 0)
+  {
+    return 0;
+  }
+  if (u32Len > (uint32_t)free)
+  {
+    u32Len = free;
+  }
+  return pClient->client.write(data, u32Len);
+#endif
+}
+
+/*********************************************
+ * Write data of the transmit ring as far as the
+ * client accepts it, never blocks
+ * 
+ * pClient Client handle
+ * 
+ ********************************************* 
+ */
+static void flush(stc_withrottle_client_t* pClient)
+{
+  uint32_t u32Chunk;
+  int written;
+  while(pClient->u16TxLen > 0)
+  {
+    u32Chunk = WITHROTTLE_TX_BUFFER_SIZE - pClient->u16TxHead;
+    if (u32Chunk > pClient->u16TxLen)
+    {
+      u32Chunk = pClient->u16TxLen;
+    }
+    written = writeNonBlocking(pClient, &pClient->au8TxBuffer[pClient->u16TxHead], u32Chunk);
+    if (written < 0)
+    {
+      u32TxDropped += pClient->u16TxLen;
+      pClient->u16TxLen = 0;
+      break;
+    }
+    if (written == 0)
+    {
+      u32TxStalled++;
+      break;
+    }
+    pClient->u16TxHead = (pClient->u16TxHead + written) % WITHROTTLE_TX_BUFFER_SIZE;
+    pClient->u16TxLen -= written;
+  }
+  sendPendingStates(pClient);
+}
+
+/*********************************************
+ * Format a loco state line
+ * 
+ * buffer       Destination buffer
+ * 
+ * size         Size of the destination buffer
+ * 
+ * throttleChar throttle-char
+ * 
+ * addressChar  L / S
+ * 
+ * pLoco        Loco handle
+ * 
+ * state        'V' speed, 'R' direction, 'F' function
+ * 
+ * u8Function   Function number if state is 'F'
+ * 
+ * \return length of the line
+ * 
+ ********************************************* 
+ */
+static int formatLocoState(char* buffer, size_t size, char throttleChar, char addressChar, stc_withrottle_loco_t* pLoco, char state, uint8_t u8Function)
+{
+  switch(state)
+  {
+    case 'V':
+      return snprintf(buffer,size,"M%cA%c%d<;>V%d\n",throttleChar,addressChar,pLoco->u32Address,pLoco->speed);
+    case 'R':
+      return snprintf(buffer,size,"M%cA%c%d<;>R%d\n",throttleChar,addressChar,pLoco->u32Address,pLoco->bDir);
+    default:
+      return snprintf(buffer,size,"M%cA%c%d<;>F%d%d\n",throttleChar,addressChar,pLoco->u32Address,
+                      (pLoco->u32FunctionMask & (1UL << u8Function)) ? 1 : 0,u8Function);
+  }
+}
+
+/*********************************************
+ * Send the current state of a loco. If the transmit
+ * ring is full, only the newest state is sent later
+ * 
+ * pClient      Client handle
+ * 
+ * throttleChar throttle-char
+ * 
+ * addressChar  L / S
+ * 
+ * pLoco        Loco handle
+ * 
+ * state        'V' speed, 'R' direction, 'F' function
+ * 
+ * u8Function   Function number if state is 'F'
+ * 
+ ********************************************* 
+ */
+static void sendLocoState(stc_withrottle_client_t* pClient, char throttleChar, char addressChar, stc_withrottle_loco_t* pLoco, char state, uint8_t u8Function)
+{
+  stc_withrottle_tx_pending_t* pPending = NULL;
+  char line[48];
+  int len;
+  int i;
+
+  for(i = 0; i < WITHROTTLE_TX_PENDING_LOCOS; i++)
+  {
+    if ((pClient->astcTxPending[i].pLoco == pLoco) && (pClient->astcTxPending[i].throttleChar == throttleChar))
+    {
+      pPending = &pClient->astcTxPending[i];
+      break;
+    }
+  }
+
+  //
+  // Nothing pending for this loco, try to queue the line directly
+  //
+  if (pPending == NULL)
+  {
+    len = formatLocoState(line,sizeof(line),throttleChar,addressChar,pLoco,state,u8Function);
+    if (sendData(pClient,(uint8_t*)line,len))
+    {
+      return;
+    }
+  }
+
+  //
+  // Remember which state has to be sent, it is taken from the loco when there is space again
+  //
+  for(i = 0; (i < WITHROTTLE_TX_PENDING_LOCOS) && (pPending == NULL); i++)
+  {
+    if (pClient->astcTxPending[i].pLoco == NULL)
+    {
+      pPending = &pClient->astcTxPending[i];
+      pPending->pLoco = pLoco;
+      pPending->throttleChar = throttleChar;
+      pPending->addressChar = addressChar;
+    }
+  }
+  if (pPending == NULL)
+  {
+    return; //dropped, counted by sendData()
+  }
+  if (state == 'V')
+  {
+    pPending->bSpeed = true;
+  } else if (state == 'R')
+  {
+    pPending->bDir = true;
+  } else
+  {
+    pPending->u32Functions |= (1UL << u8Function);
+  }
+}
+
+/*********************************************
+ * Queue pending loco states as far as the transmit
+ * ring has space
+ * 
+ * pClient      Client handle
+ * 
+ * \return true if all pending states were queued
+ * 
  ********************************************* 
  */
-static void send(stc_withrottle_client_t* pClient, uint8_t* data,uint32_t u32Len)
+static bool sendPendingStates(stc_withrottle_client_t* pClient)
 {
-  pClient->client.write(data, u32Len);
+  stc_withrottle_tx_pending_t* pPending;
+  char line[48];
+  int len;
+  int i;
+  uint8_t u8Function;
+
+  for(i = 0; i < WITHROTTLE_TX_PENDING_LOCOS; i++)
+  {
+    pPending = &pClient->astcTxPending[i];
+    if (pPending->pLoco == NULL)
+    {
+      continue;
+    }
+    if (pPending->bSpeed)
+    {
+      len = formatLocoState(line,sizeof(line),pPending->throttleChar,pPending->addressChar,pPending->pLoco,'V',0);
+      if ((WITHROTTLE_TX_BUFFER_SIZE - pClient->u16TxLen) < len) return false;
+      sendData(pClient,(uint8_t*)line,len);
+      pPending->bSpeed = false;
+    }
+    if (pPending->bDir)
+    {
+      len = formatLocoState(line,sizeof(line),pPending->throttleChar,pPending->addressChar,pPending->pLoco,'R',0);
+      if ((WITHROTTLE_TX_BUFFER_SIZE - pClient->u16TxLen) < len) return false;
+      sendData(pClient,(uint8_t*)line,len);
+      pPending->bDir = false;
+    }
+    for(u8Function = 0; (u8Function < 32) && (pPending->u32Functions != 0); u8Function++)
+    {
+      if (pPending->u32Functions & (1UL << u8Function))
+      {
+        len = formatLocoState(line,sizeof(line),pPending->throttleChar,pPending->addressChar,pPending->pLoco,'F',u8Function);
+        if ((WITHROTTLE_TX_BUFFER_SIZE - pClient->u16TxLen) < len) return false;
+        sendData(pClient,(uint8_t*)line,len);
+        pPending->u32Functions &= ~(1UL << u8Function);
+      }
+    }
+    pPending->pLoco = NULL;
+  }
+  return true;
 }
 
 /*********************************************
@@ -133,7 +504,7 @@ static void send(stc_withrottle_client_t* pClient, uint8_t* data,uint32_t u32Len
  */
 static void sendString(stc_withrottle_client_t* pClient, char* str)
 {
-  pClient->client.write(str, strlen(str));
+  sendData(pClient, (uint8_t*)str, strlen(str));
 }
 
 /*********************************************
@@ -141,34 +512,22 @@ static void sendString(stc_withrottle_client_t* pClient, char* str)
  * 
  * cmd     current pointer where the number is expected
  * 
+ * u16Len  bytes left in the line
+ * 
  * \return return number
  * 
  ********************************************* 
  */
-static int getInt(uint8_t * cmd) {
+static int getInt(uint8_t * cmd, uint16_t u16Len) {
     int i=0;
-    while (cmd[0]>='0' && cmd[0]<='9') {
-      i=i*10 + (cmd[0]-'0');
+    while ((u16Len > 0) && (cmd[0]>='0' && cmd[0]<='9')) {
+      if (i < 100000) i=i*10 + (cmd[0]-'0');
       cmd++;
+      u16Len--;
     }
     return i;    
 }
 
-/*********************************************
- * Get loco id from a command value
- * 
- * cmd     current pointer where the loco id is expected
- * 
- * \return loco id / address
- * 
- ********************************************* 
- */
-static int getLocoId(uint8_t * cmd) {
-    if (cmd[0]=='*') return -1;  // match all locos 
-    if (cmd[0]!='L' && cmd[0]!='S') return 0; // should not match any locos
-    return getInt(cmd+1); 
-}
-
 /*********************************************
  * Get loco structure from loco id
  * 
@@ -180,22 +539,47 @@ static int getLocoId(uint8_t * cmd) {
  */
 static stc_withrottle_loco_listitem* getLoco(int locoid)
 {
-  stc_withrottle_loco_listitem_t* pCurrent = pLocoList;
+  stc_withrottle_loco_listitem_t* pCurrent;
+  uint32_t u32Index;
   if (locoid <= 0)
   {
     return NULL;
   }
-  while(pCurrent != NULL)
+  if ((locoid < SHORT_ADDRESS_COUNT) && (apShortLocos[locoid] != NULL))
   {
-    if (pCurrent->locoItem.u32Address == locoid)
+    return apShortLocos[locoid];
+  }
+  u32Index = hashAddress(locoid);
+  for(int i = 0; i < LONG_HASH_SIZE; i++)
+  {
+    pCurrent = apLongLocos[u32Index];
+    if (pCurrent == NULL)
+    {
+      return NULL;
+    }
+    if (pCurrent->locoItem.u32Address == (uint32_t)locoid)
     {
       return pCurrent;
     }
-    pCurrent = pCurrent->pNextItem;
+    u32Index = (u32Index + 1) & (LONG_HASH_SIZE - 1);
   }
   return NULL;
 }
 
+/*********************************************
+ * Home slot of a long address in the loco hash
+ * 
+ * u32Address  loco address
+ * 
+ * \return  index in apLongLocos
+ * 
+ ********************************************* 
+ */
+static uint32_t hashAddress(uint32_t u32Address)
+{
+  return (uint32_t)(u32Address * 2654435761u) >> (32 - LONG_HASH_BITS);
+}
+
 /*********************************************
  * Get L / S char (representing long/short)
  * 
@@ -219,239 +603,868 @@ static char LorS(stc_withrottle_loco_t* pLoco)
 }
 
 /*********************************************
- * Decode loco action
+ * Get the functions a loco has
  * 
- * pClient  Pointer of connected client handle
+ * pLoco    pointer to loco structure
  * 
- * pLoco    Loco handle of the current loco
+ * \return  bit n set if the loco has Fn
+ * 
+ ********************************************* 
+ */
+static uint32_t functionCapabilities(stc_withrottle_loco_t* pLoco)
+{
+  if (pLoco->u32FunctionCapabilities == 0)
+  {
+    return ALL_FUNCTIONS;
+  }
+  if (pLoco->u32FunctionCapabilities == WITHROTTLE_FUNCTIONS_NONE)
+  {
+    return 0;
+  }
+  return pLoco->u32FunctionCapabilities;
+}
+
+/*********************************************
+ * Subscribe a throttle of a client to the changes of a loco
+ * 
+ * pClient      Client handle
+ * 
+ * throttleChar throttle-char
+ * 
+ * addressChar  L / S
+ * 
+ * pLoco        Loco handle
+ * 
+ * \return false if the subscription list of the client is full
+ * 
+ ********************************************* 
+ */
+static bool subscribe(stc_withrottle_client_t* pClient, char throttleChar, char addressChar, stc_withrottle_loco_t* pLoco)
+{
+  stc_withrottle_subscription_t* pFree = NULL;
+  for(int i = 0; i < WITHROTTLE_MAX_SUBSCRIPTIONS; i++)
+  {
+    if (pClient->astcSubscriptions[i].pLoco == NULL)
+    {
+      if (pFree == NULL) pFree = &pClient->astcSubscriptions[i];
+    } else if ((pClient->astcSubscriptions[i].pLoco == pLoco) && (pClient->astcSubscriptions[i].throttleChar == throttleChar))
+    {
+      return true;
+    }
+  }
+  if (pFree == NULL)
+  {
+    return false;
+  }
+  pFree->pLoco = pLoco;
+  pFree->throttleChar = throttleChar;
+  pFree->addressChar = addressChar;
+  return true;
+}
+
+/*********************************************
+ * Unsubscribe a throttle of a client from a loco
+ * 
+ * pClient      Client handle
+ * 
+ * throttleChar throttle-char
+ * 
+ * pLoco        Loco handle
+ * 
+ ********************************************* 
+ */
+static void unsubscribe(stc_withrottle_client_t* pClient, char throttleChar, stc_withrottle_loco_t* pLoco)
+{
+  for(int i = 0; i < WITHROTTLE_MAX_SUBSCRIPTIONS; i++)
+  {
+    if ((pClient->astcSubscriptions[i].pLoco == pLoco) && (pClient->astcSubscriptions[i].throttleChar == throttleChar))
+    {
+      pClient->astcSubscriptions[i].pLoco = NULL;
+    }
+  }
+}
+
+/*********************************************
+ * Check if a throttle of a client is subscribed to a loco
+ * 
+ * pClient      Client handle
+ * 
+ * throttleChar throttle-char
+ * 
+ * pLoco        Loco handle
+ * 
+ * \return true if subscribed
+ * 
+ ********************************************* 
+ */
+static bool isSubscribed(stc_withrottle_client_t* pClient, char throttleChar, stc_withrottle_loco_t* pLoco)
+{
+  for(int i = 0; i < WITHROTTLE_MAX_SUBSCRIPTIONS; i++)
+  {
+    if ((pClient->astcSubscriptions[i].pLoco == pLoco) && (pClient->astcSubscriptions[i].throttleChar == throttleChar))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*********************************************
+ * Serialize the roster and the function labels
+ * of all locos into acRoster. Only done again
+ * after the roster has changed.
+ * 
+ ********************************************* 
+ */
+static void buildRoster(void)
+{
+  uint32_t u32Pos = ROSTER_HEADER_SIZE;
+  uint32_t u32Count = 0;
+  uint32_t u32Start;
+  stc_withrottle_loco_t* pLoco;
+  char acHeader[ROSTER_HEADER_SIZE + 1];
+  int len;
+
+  //
+  // Roster entries, the last byte is kept for '\n'
+  //
+  for(uint32_t i = 0; i < u32LocoCount; i++)
+  {
+    pLoco = &apLocos[i]->locoItem;
+    if (pLoco->pName == NULL)
+    {
+      continue;
+    }
+    len = snprintf(&acRoster[u32Pos], sizeof(acRoster) - u32Pos - 1, "]\\[%s}|{%u}|{%c", pLoco->pName, pLoco->u32Address, LorS(pLoco));
+    if ((len < 0) || (len >= (int)(sizeof(acRoster) - u32Pos - 1)))
+    {
+      break;
+    }
+    u32Pos += len;
+    u32Count++;
+  }
+  acRoster[u32Pos++] = '\n';
+
+  //
+  // "RL<count>" is written right in front of the entries
+  //
+  len = snprintf(acHeader, sizeof(acHeader), "RL%u", u32Count);
+  u16RosterStart = ROSTER_HEADER_SIZE - len;
+  memcpy(&acRoster[u16RosterStart], acHeader, len);
+  u16RosterLen = u32Pos - u16RosterStart;
+
+  //
+  // Function labels, "]\[label F0]\[label F1]\[..." per loco
+  //
+  for(uint32_t i = 0; i < u32LocoCount; i++)
+  {
+    pLoco = &apLocos[i]->locoItem;
+    u32Start = u32Pos;
+    au16LabelStart[i] = u32Start;
+    au16LabelLen[i] = 0;
+    if (pLoco->ppFunctionLabels == NULL)
+    {
+      continue;
+    }
+    for(int j = 0; (j < MAX_FUNCTION_LABELS) && (pLoco->ppFunctionLabels[j] != NULL); j++)
+    {
+      len = snprintf(&acRoster[u32Pos], sizeof(acRoster) - u32Pos, "]\\[%s", pLoco->ppFunctionLabels[j]);
+      if ((len < 0) || (len >= (int)(sizeof(acRoster) - u32Pos)))
+      {
+        //does not fit, the loco is sent without labels
+        u32Pos = u32Start;
+        break;
+      }
+      u32Pos += len;
+    }
+    au16LabelLen[i] = u32Pos - u32Start;
+  }
+  bRosterValid = true;
+}
+
+/*********************************************
+ * Send the cached function labels of a loco
  * 
- * aval     Value of the command
+ * pClient      Client handle
  * 
  * throttleChar throttle-char
  * 
- * cab      Loco ID / Address
+ * addressChar  L / S
+ * 
+ * pLoco        Loco handle
+ * 
+ ********************************************* 
+ */
+static void sendFunctionLabels(stc_withrottle_client_t* pClient, char throttleChar, char addressChar, stc_withrottle_loco_t* pLoco)
+{
+  char acPrefix[24];
+  int len;
+
+  if (!bRosterValid)
+  {
+    buildRoster();
+  }
+  if (au16LabelLen[pLoco->u16Index] == 0)
+  {
+    return;
+  }
+  len = snprintf(acPrefix, sizeof(acPrefix), "M%cL%c%u<;>", throttleChar, addressChar, pLoco->u32Address);
+  if ((WITHROTTLE_TX_BUFFER_SIZE - pClient->u16TxLen) < (len + au16LabelLen[pLoco->u16Index] + 1))
+  {
+    u32TxDropped += len + au16LabelLen[pLoco->u16Index] + 1;
+    return;
+  }
+  sendData(pClient, (uint8_t*)acPrefix, len);
+  sendData(pClient, (uint8_t*)&acRoster[au16LabelStart[pLoco->u16Index]], au16LabelLen[pLoco->u16Index]);
+  sendData(pClient, (uint8_t*)"\n", 1);
+}
+
+/*********************************************
+ * Send changes of all locos to the subscribed
+ * clients, called once per WiThrottle_Update(),
+ * so several changes of a loco result in one line
+ * 
+ ********************************************* 
+ */
+static void publish(void)
+{
+  stc_withrottle_loco_t* pLoco;
+  stc_withrottle_subscription_t* pSubscription;
+  uint8_t u8Function;
+
+  for(uint32_t l = 0; l < u32LocoCount; l++)
+  {
+    pLoco = &apLocos[l]->locoItem;
+    if ((pLoco->u8Changed == 0) && (pLoco->u32FunctionsChanged == 0))
+    {
+      continue;
+    }
+    for(uint32_t i = 0; i < u32ClientCount; i++)
+    {
+      if (!serverClients[i].client || !serverClients[i].client.connected())
+      {
+        continue;
+      }
+      for(int j = 0; j < WITHROTTLE_MAX_SUBSCRIPTIONS; j++)
+      {
+        pSubscription = &serverClients[i].astcSubscriptions[j];
+        if (pSubscription->pLoco != pLoco)
+        {
+          continue;
+        }
+        if (pLoco->u8Changed & WITHROTTLE_CHANGED_SPEED)
+        {
+          sendLocoState(&serverClients[i],pSubscription->throttleChar,pSubscription->addressChar,pLoco,'V',0);
+        }
+        if (pLoco->u8Changed & WITHROTTLE_CHANGED_DIR)
+        {
+          sendLocoState(&serverClients[i],pSubscription->throttleChar,pSubscription->addressChar,pLoco,'R',0);
+        }
+        for(u8Function = 0; u8Function < 32; u8Function++)
+        {
+          if (pLoco->u32FunctionsChanged & functionCapabilities(pLoco) & (1UL << u8Function))
+          {
+            sendLocoState(&serverClients[i],pSubscription->throttleChar,pSubscription->addressChar,pLoco,'F',u8Function);
+          }
+        }
+      }
+    }
+    pLoco->u8Changed = 0;
+    pLoco->u32FunctionsChanged = 0;
+  }
+}
+
+/*********************************************
+ * Decode loco action
+ * 
+ * pClient  Pointer of connected client handle
+ * 
+ * pLoco    Loco handle of the current loco
  * 
+ * pCmd     Parsed MTA command
  * 
  ********************************************* 
  */
-static void decode_loco_action(stc_withrottle_client_t* pClient, stc_withrottle_loco_t* pLoco, uint8_t* aval, char throttleChar, int cab)
+static void decode_loco_action(stc_withrottle_client_t* pClient, stc_withrottle_loco_t* pLoco, stc_withrottle_cmd_t* pCmd)
 {
+  char throttleChar = pCmd->throttleChar;
   uint8_t tmp;
-  uint32_t u32Tmp;
   
   if (pLoco == NULL)
   {
     return;
   }
-  switch (aval[0]) 
+  switch (pCmd->action) 
   {
     case 'V':
-      tmp=getInt(aval+1);
+      tmp=pCmd->i32Value;
       if (pLoco->cbSpeedUpdated)
       {
          pLoco->cbSpeedUpdated(pLoco,pLoco->bDir,tmp);
       }
       pLoco->speed = tmp;
-      WiThrottle_Printf(pClient,"M%cA%c%d<;>V%d\n",throttleChar,LorS(pLoco),pLoco->u32Address,pLoco->speed);
+      WiThrottle_PublishLoco(pLoco,WITHROTTLE_CHANGED_SPEED,0);
+      if (!isSubscribed(pClient,throttleChar,pLoco))
+      {
+        sendLocoState(pClient,throttleChar,LorS(pLoco),pLoco,'V',0);
+      }
       break;
     case 'R':
-      if (aval[1] == '1')
+      tmp = pCmd->i32Value;
+      if (pLoco->cbSpeedUpdated)
       {
-        tmp = 1;
-      } else
+         pLoco->cbSpeedUpdated(pLoco,tmp,pLoco->speed);
+      }
+      pLoco->bDir = tmp;
+      WiThrottle_PublishLoco(pLoco,WITHROTTLE_CHANGED_DIR,0);
+      if (!isSubscribed(pClient,throttleChar,pLoco))
       {
-        tmp = 0;
+        sendLocoState(pClient,throttleChar,LorS(pLoco),pLoco,'R',0);
       }
+      break;
+    case 'X':
+    case 'I':
+    case 'Q':
       if (pLoco->cbSpeedUpdated)
       {
-         pLoco->cbSpeedUpdated(pLoco,tmp,pLoco->speed);
+         pLoco->cbSpeedUpdated(pLoco,pLoco->bDir,0);
+         pLoco->speed = 0;
+      }
+      WiThrottle_PublishLoco(pLoco,WITHROTTLE_CHANGED_SPEED,0);
+      if (!isSubscribed(pClient,throttleChar,pLoco))
+      {
+        sendLocoState(pClient,throttleChar,LorS(pLoco),pLoco,'V',0);
+      }
+      break;
+    case 'F':
+      if ((pCmd->i32Value > 31) || ((functionCapabilities(pLoco) & (1UL << pCmd->i32Value)) == 0))
+      {
+        //function not available on this loco, e.g. MTA* to locos with less functions
+        break;
+      }
+      tmp=pCmd->i32Value;
+      if (pCmd->modifier == '1')
+      {
+        if (pLoco->cbFunctionUpdated)
+        {
+           pLoco->cbFunctionUpdated(pLoco,tmp);
+        }
+        pLoco->u32FunctionMask ^= (1 << tmp);
+      }
+      if ((pCmd->modifier == '1') || ((pLoco->u32FunctionMask & (1 << tmp)) == 0))
+      {
+        WiThrottle_PublishLoco(pLoco,0,(1UL << tmp));
+        if (!isSubscribed(pClient,throttleChar,pLoco))
+        {
+          sendLocoState(pClient,throttleChar,LorS(pLoco),pLoco,'F',tmp);
+        }
+      }
+      break;
+    case 'q':
+      if (pCmd->modifier=='V')  //qV
+      {  
+        sendLocoState(pClient,throttleChar,LorS(pLoco),pLoco,'V',0);
+      } else if (pCmd->modifier=='R')  //qR
+      {  
+        sendLocoState(pClient,throttleChar,LorS(pLoco),pLoco,'R',0);
+      }
+      break;
+  }
+}
+
+/*********************************************
+ * Decode multi throttle
+ * 
+ * pClient  Pointer of connected client handle
+ * 
+ * pCmd     Parsed MT+, MT- or MTA command
+ * 
+ ********************************************* 
+ */
+static void decode_multithrottle(stc_withrottle_client_t* pClient, stc_withrottle_cmd_t* pCmd)
+{
+  char throttleChar=pCmd->throttleChar;
+  char addressChar=pCmd->addressChar;
+  int locoid=pCmd->i32Address; // -1 for *
+  stc_withrottle_loco_listitem* pHandle = getLoco(locoid);
+  uint32_t u32Functions;
+
+   switch(pCmd->enCmd) {
+     case enWiThrottleCmdAcquire:
+       if (locoid==0) {
+         sendString(pClient,"HMAddress '0' not supported!\n");
+       }
+       if ((_cbCreateLoco) && (pHandle == NULL) && (locoid > 0))
+       {
+          pHandle = _cbCreateLoco(locoid,(addressChar == 'L'));
+          if (pHandle != NULL)
+          {
+            WiThrottle_AddLoco(pHandle);
+          }
+       }
+       if (pHandle != NULL)
+       {
+         subscribe(pClient,throttleChar,addressChar,&pHandle->locoItem);
+         WiThrottle_Printf(pClient,"M%c+%c%d<;>\n", throttleChar, addressChar ,locoid);
+         sendFunctionLabels(pClient,throttleChar,addressChar,&pHandle->locoItem);
+         u32Functions = functionCapabilities(&pHandle->locoItem);
+         for(int fKey=0; fKey<28; fKey++) { 
+            if (u32Functions & (1UL << fKey))
+            {
+              sendLocoState(pClient,throttleChar,addressChar,&pHandle->locoItem,'F',fKey);
+            }
+         }
+         sendLocoState(pClient,throttleChar,addressChar,&pHandle->locoItem,'V',0);
+         sendLocoState(pClient,throttleChar,addressChar,&pHandle->locoItem,'R',0);
+         WiThrottle_Printf(pClient,"M%cA%c%d<;>s1\n", throttleChar, addressChar, locoid); //default speed step 128
+       }
+       break;
+     case enWiThrottleCmdRelease:
+       if (addressChar == '*')
+       {
+          for(uint32_t i = 0; i < u32LocoCount; i++)
+          {
+            unsubscribe(pClient, throttleChar, &apLocos[i]->locoItem);
+          }
+       } else if (pHandle != NULL)
+       {
+          unsubscribe(pClient, throttleChar, &pHandle->locoItem);
+       }
+       break;
+     case enWiThrottleCmdAction:
+       if (addressChar == '*')
+       {
+          for(uint32_t i = 0; i < u32LocoCount; i++)
+          {
+            decode_loco_action(pClient, &apLocos[i]->locoItem, pCmd);
+          }
+       } else
+       {
+         if (pHandle != NULL)
+         {
+             decode_loco_action(pClient, &pHandle->locoItem, pCmd);
+         }
+       }
+       break;
+     default:
+       break;
+   }
+}
+
+/*********************************************
+ * Split the value of a MTA command into action,
+ * modifier and number
+ * 
+ * pCmd     Command with pu8Arg set
+ * 
+ ********************************************* 
+ */
+static void parseAction(stc_withrottle_cmd_t* pCmd)
+{
+  uint8_t* pu8Arg = pCmd->pu8Arg;
+  uint16_t u16Len = pCmd->u16ArgLen;
+
+  if (u16Len == 0)
+  {
+    return;
+  }
+  pCmd->action = pu8Arg[0];
+  switch(pCmd->action)
+  {
+    case 'V':
+      pCmd->i32Value = getInt(pu8Arg + 1, u16Len - 1);
+      break;
+    case 'R':
+      pCmd->i32Value = ((u16Len > 1) && (pu8Arg[1] == '1')) ? 1 : 0;
+      break;
+    case 'F':
+      if (u16Len > 1)
+      {
+        pCmd->modifier = pu8Arg[1];
+        pCmd->i32Value = getInt(pu8Arg + 2, u16Len - 2);
+      }
+      break;
+    case 'q':
+      if (u16Len > 1)
+      {
+        pCmd->modifier = pu8Arg[1];
+      }
+      break;
+  }
+}
+
+/*********************************************
+ * Tokenize a command line in place
+ * 
+ * The line is scanned once by a state machine,
+ * the command only points into the line, nothing
+ * is copied.
+ * 
+ * pu8Line  Start of the line, without line end
+ * 
+ * u16Len   Length of the line
+ * 
+ * pCmd     Command to fill
+ * 
+ * \return  true if the line is a known command
+ * 
+ ********************************************* 
+ */
+static bool parse(uint8_t* pu8Line, uint16_t u16Len, stc_withrottle_cmd_t* pCmd)
+{
+  en_withrottle_parse_state_t enState = enWiThrottleParseStart;
+  uint8_t c;
+  uint16_t i;
+
+  memset(pCmd,0,sizeof(stc_withrottle_cmd_t));
+  for(i = 0; i < u16Len; i++)
+  {
+    c = pu8Line[i];
+    switch(enState)
+    {
+      case enWiThrottleParseStart:
+        switch(c)
+        {
+          case 'P':
+            enState = enWiThrottleParsePower;
+            break;
+          case 'H':
+            enState = enWiThrottleParseHardware;
+            break;
+          case 'M':
+            enState = enWiThrottleParseThrottle;
+            break;
+          case 'N':
+            pCmd->enCmd = enWiThrottleCmdName;
+            pCmd->pu8Arg = &pu8Line[i + 1];
+            pCmd->u16ArgLen = u16Len - i - 1;
+            return true;
+          case '*':
+            pCmd->enCmd = enWiThrottleCmdHeartbeat;
+            pCmd->pu8Arg = &pu8Line[i + 1];
+            pCmd->u16ArgLen = u16Len - i - 1;
+            return true;
+          case 'Q':
+            pCmd->enCmd = enWiThrottleCmdQuit;
+            return true;
+          default:
+            return false;
+        }
+        break;
+      case enWiThrottleParsePower:
+        if (c != 'P') return false;
+        enState = enWiThrottleParsePowerA;
+        break;
+      case enWiThrottleParsePowerA:
+        if (c != 'A') return false;
+        pCmd->enCmd = enWiThrottleCmdPower;
+        enState = enWiThrottleParsePowerValue;
+        break;
+      case enWiThrottleParsePowerValue:
+        pCmd->i32Value = (c == '1') ? 1 : 0;
+        return true;
+      case enWiThrottleParseHardware:
+        if (c != 'U') return false;
+        pCmd->enCmd = enWiThrottleCmdHardwareId;
+        pCmd->pu8Arg = &pu8Line[i + 1];
+        pCmd->u16ArgLen = u16Len - i - 1;
+        return true;
+      case enWiThrottleParseThrottle:
+        pCmd->throttleChar = c;
+        enState = enWiThrottleParseOperation;
+        break;
+      case enWiThrottleParseOperation:
+        switch(c)
+        {
+          case '+':
+            pCmd->enCmd = enWiThrottleCmdAcquire;
+            break;
+          case '-':
+            pCmd->enCmd = enWiThrottleCmdRelease;
+            break;
+          case 'A':
+            pCmd->enCmd = enWiThrottleCmdAction;
+            break;
+          default:
+            return false;
+        }
+        enState = enWiThrottleParseAddress;
+        break;
+      case enWiThrottleParseAddress:
+        pCmd->addressChar = c;
+        if (c == '*')
+        {
+          pCmd->i32Address = -1;   // match all locos
+          enState = enWiThrottleParseSeparator;
+        } else if ((c == 'L') || (c == 'S'))
+        {
+          enState = enWiThrottleParseDigits;
+        } else
+        {
+          enState = (c == ';') ? enWiThrottleParseSeparatorEnd : enWiThrottleParseSeparator;
+        }
+        break;
+      case enWiThrottleParseDigits:
+        if ((c >= '0') && (c <= '9'))
+        {
+          if (pCmd->i32Address < 100000) pCmd->i32Address = pCmd->i32Address * 10 + (c - '0');
+          break;
+        }
+        enState = enWiThrottleParseSeparator;
+        [[fallthrough]]; //c may already be the separator
+      case enWiThrottleParseSeparator:
+        if (c == ';')
+        {
+          enState = enWiThrottleParseSeparatorEnd;
+        }
+        break;
+      case enWiThrottleParseSeparatorEnd:
+        // c is the '>' of <;>
+        pCmd->pu8Arg = &pu8Line[i + 1];
+        pCmd->u16ArgLen = u16Len - i - 1;
+        if (pCmd->enCmd == enWiThrottleCmdAction)
+        {
+          parseAction(pCmd);
+        }
+        return true;
+    }
+  }
+  return (pCmd->enCmd != enWiThrottleCmdUnknown);
+}
+
+/*********************************************
+ * Decode incoming data
+ * 
+ * pClient  Pointer of connected client handle
+ * 
+ * pu8Line  Command line in the receive buffer,
+ *          without '\n'
+ * 
+ * u16Len   Length of the line
+ * 
+ ********************************************* 
+ */
+static void decode(stc_withrottle_client_t* pClient, uint8_t* pu8Line, uint16_t u16Len)
+{
+  stc_withrottle_cmd_t stcCmd;
+
+  if ((u16Len > 0) && (pu8Line[u16Len - 1] == '\r'))
+  {
+    u16Len--;
+  }
+  if (debugMode)
+  {
+    Serial.print("New command: \"");
+    Serial.write(pu8Line,u16Len);
+    Serial.println("\"");
+  }
+  if (!parse(pu8Line,u16Len,&stcCmd))
+  {
+    return;
+  }
+  switch(stcCmd.enCmd)
+  {
+    case enWiThrottleCmdPower: 
+      if (stcCmd.i32Value == 1)
+      {
+        trackPower = true;
+        sendString(pClient,"PPA1\n");
+      } else
+      {
+        trackPower = false;
+        sendString(pClient,"PPA0\n");
       }
-      pLoco->bDir = tmp;
-      WiThrottle_Printf(pClient,"M%cA%c%d<;>R%d\n",throttleChar,LorS(pLoco),pLoco->u32Address,pLoco->bDir);
       break;
-    case 'X':
-    case 'I':
-    case 'Q':
-      if (pLoco->cbSpeedUpdated)
+    case enWiThrottleCmdHeartbeat:
+      if ((stcCmd.u16ArgLen > 0) && (stcCmd.pu8Arg[0] == '+'))
       {
-         pLoco->cbSpeedUpdated(pLoco,pLoco->bDir,0);
-         pLoco->speed = 0;
+        pClient->bHeartbeat = true;
+      } else if ((stcCmd.u16ArgLen > 0) && (stcCmd.pu8Arg[0] == '-'))
+      {
+        pClient->bHeartbeat = false;
       }
-      WiThrottle_Printf(pClient,"M%cA%c%d<;>V%d\n",throttleChar,LorS(pLoco),pLoco->u32Address,pLoco->speed);
       break;
-    case 'F':
-      tmp=getInt(aval+2);
-      if (aval[1] == '1')
+    case enWiThrottleCmdQuit:
+      closeClient(pClient,enWiThrottleCloseQuit);
+      break;
+    case enWiThrottleCmdName:
+      sendString(pClient,"*5\n");
+      break;
+    case enWiThrottleCmdHardwareId:
+      if (!bRosterValid)
       {
-        u32Tmp = pLoco->u32FunctionMask ^ (1 << tmp);
-        if (pLoco->cbFunctionUpdated)
-        {
-           pLoco->cbFunctionUpdated(pLoco,tmp);
-        }
-        pLoco->u32FunctionMask ^= (1 << tmp);
+        buildRoster();
       }
-      if (u32Tmp & (1 << tmp))
+      sendString(pClient,"VN2.0\nHTIR-TRAIN\n");
+      sendData(pClient,(uint8_t*)&acRoster[u16RosterStart],u16RosterLen);
+      sendString(pClient,"HtIR-TRAIN\n");
+      if (trackPower)
       {
-        WiThrottle_Printf(pClient,"M%cA%c%d<;>F%d%d\n",throttleChar,LorS(pLoco),pLoco->u32Address,1,tmp);
-      } 
-      if ((pLoco->u32FunctionMask & (1 << tmp)) == 0)
+        sendString(pClient,"PPA1\n*5\n");
+      } else
       {
-        WiThrottle_Printf(pClient,"M%cA%c%d<;>F%d%d\n",throttleChar,LorS(pLoco),pLoco->u32Address,0,tmp);
+        sendString(pClient,"PPA0\n*5\n");
       }
       break;
-    case 'q':
-      if (aval[1]=='V')  //qV
-      {  
-        WiThrottle_Printf(pClient,"M%cA%c%d<;>V%d\n",throttleChar,LorS(pLoco),pLoco->u32Address,pLoco->speed);
-      } else if (aval[1]=='R')  //qR
-      {  
-        WiThrottle_Printf(pClient,"M%cA%c%d<;>R%d\n",throttleChar,LorS(pLoco),pLoco->u32Address,pLoco->bDir);
-      }
+    case enWiThrottleCmdAcquire:
+    case enWiThrottleCmdRelease:
+    case enWiThrottleCmdAction:
+      decode_multithrottle(pClient,&stcCmd);
+      break;
+    default:
       break;
   }
 }
 
 /*********************************************
- * Decode multi throttle
- * 
- * pClient  Pointer of connected client handle
- * 
- * cmd      Command
+ * Stop the locos held by a lost client, unless
+ * another connected client holds them too
  * 
+ * pClient  Client handle
  * 
  ********************************************* 
  */
-static void decode_multithrottle(stc_withrottle_client_t* pClient, uint8_t* cmd)
+static void stopLocos(stc_withrottle_client_t* pClient)
 {
-  char throttleChar=cmd[1];
-  int locoid=getLocoId(cmd+3); // -1 for *
-  byte * aval=cmd;
-  stc_withrottle_loco_listitem* pHandle = getLoco(locoid);
-  
-  while(*aval !=';' && *aval !='\0') aval++;
-  if (*aval) aval+=2;  // skip ;>
+  stc_withrottle_loco_t* pLoco;
+  bool bHeld;
 
-   switch(cmd[2]) {
-     case '+':
-       if (locoid==0) {
-         sendString(pClient,"HMAddress '0' not supported!\n");
-       }
-       if ((_cbCreateLoco) && (pHandle == NULL))
-       {
-          if (cmd[0]!='L')
-          {
-            pHandle = _cbCreateLoco(locoid,true);
-          } else if (cmd[0]!='S')
-          {
-            pHandle = _cbCreateLoco(locoid,false);
-          }
-          if (pHandle != NULL)
-          {
-            WiThrottle_AddLoco(pHandle);
-          }
-       }
-       if (pHandle != NULL)
-       {
-         WiThrottle_Printf(pClient,"M%c+%c%d<;>\n", throttleChar, cmd[3] ,locoid);
-         for(int fKey=0; fKey<28; fKey++) { 
-            if (pHandle->locoItem.u32FunctionMask & (1 << fKey))
-            {
-              WiThrottle_Printf(pClient,"M%cA%c%d<;>F%d%d\n",throttleChar,cmd[3],locoid,1,fKey);
-            } else
-            {
-              WiThrottle_Printf(pClient,"M%cA%c%d<;>F%d%d\n",throttleChar,cmd[3],locoid,0,fKey);
-            }
-         }
-         WiThrottle_Printf(pClient,"M%cA%c%d<;>V%d\n", throttleChar, cmd[3], locoid, pHandle->locoItem.speed);
-         WiThrottle_Printf(pClient,"M%cA%c%d<;>R%d\n", throttleChar, cmd[3], locoid, pHandle->locoItem.bDir);
-         WiThrottle_Printf(pClient,"M%cA%c%d<;>s1\n", throttleChar, cmd[3], locoid); //default speed step 128
-       }
-       break;
-     case 'A':
-       if (cmd[3] == '*')
-       {
-          pHandle = pLocoList;
-          while(pHandle != NULL)
-          {
-            decode_loco_action(pClient, &pHandle->locoItem, aval, throttleChar, pHandle->locoItem.u32Address);
-            pHandle = pHandle->pNextItem;
-          }
-       } else
-       {
-         if (pHandle != NULL)
-         {
-             decode_loco_action(pClient, &pHandle->locoItem, aval, throttleChar, locoid);
-         }
-       }
-       break;
-   }
+  for(int j = 0; j < WITHROTTLE_MAX_SUBSCRIPTIONS; j++)
+  {
+    pLoco = pClient->astcSubscriptions[j].pLoco;
+    if ((pLoco == NULL) || (pLoco->speed == 0))
+    {
+      continue;
+    }
+    bHeld = false;
+    for(uint32_t i = 0; (i < u32ClientCount) && (!bHeld); i++)
+    {
+      if ((&serverClients[i] == pClient) || (!serverClients[i].bActive))
+      {
+        continue;
+      }
+      for(int k = 0; k < WITHROTTLE_MAX_SUBSCRIPTIONS; k++)
+      {
+        if (serverClients[i].astcSubscriptions[k].pLoco == pLoco)
+        {
+          bHeld = true;
+          break;
+        }
+      }
+    }
+    if (bHeld)
+    {
+      continue;
+    }
+    if (pLoco->cbSpeedUpdated)
+    {
+      pLoco->cbSpeedUpdated(pLoco,pLoco->bDir,0);
+    }
+    pLoco->speed = 0;
+    WiThrottle_PublishLoco(pLoco,WITHROTTLE_CHANGED_SPEED,0);
+    u32LocosStopped++;
+  }
 }
 
 /*********************************************
- * Decode incoming data
+ * Close a client and free its slot
  * 
- * pClient  Pointer of connected client handle
+ * pClient  Client handle
+ * 
+ * enReason Why the client is closed
  * 
  ********************************************* 
  */
-static void decode(stc_withrottle_client_t* pClient)
+static void closeClient(stc_withrottle_client_t* pClient, en_withrottle_close_reason_t enReason)
 {
-  uint8_t* cmd = (uint8_t*)pClient->buffer;
   if (debugMode)
   {
-    Serial.print("New command: \"");
-    Serial.print((char*)cmd);
-    Serial.println("\"");
+    Serial.print("Close client, reason: ");
+    Serial.println((int)enReason);
   }
-  switch(cmd[0])
+  switch(enReason)
   {
-    case 'P': 
-      if (cmd[1]=='P' && cmd[2]=='A' )
-      {
-        sendString(pClient,"PPA");
-        if (cmd[3]=='1')
-        {
-          trackPower = true;
-          sendString(pClient,"1");
-        } else
-        {
-          trackPower = false;
-          sendString(pClient,"0");
-        }
-        sendString(pClient,"\n");
-      }
+    case enWiThrottleCloseHeartbeat:
+      u32ClientsHeartbeat++;
       break;
-    case 'N':
-      sendString(pClient,"*5\n");
+    case enWiThrottleCloseIdle:
+      u32ClientsEvicted++;
       break;
-    case 'H':
-      if (cmd[1] == 'U') {
-        sendString(pClient,"VN2.0\nHTIR-TRAIN\nRL0\n");
-        sendString(pClient,"HtIR-TRAIN\n");
-        sendString(pClient,"PPA");
-        if (trackPower)
-        {
-          sendString(pClient,"1");
-        } else
-        {
-          sendString(pClient,"0");
-        }
-        sendString(pClient,"\n");
-        sendString(pClient,"*5\n");
-      }      
+    case enWiThrottleCloseDisconnected:
+      u32ClientsDisconnected++;
       break;
-    case 'M':
-      decode_multithrottle(pClient,cmd);
+    default:
+      break;
+  }
+  pClient->bActive = false;
+  if ((bStopLocos) && (enReason != enWiThrottleCloseQuit))
+  {
+    stopLocos(pClient);
   }
+  memset(pClient->astcSubscriptions,0,sizeof(pClient->astcSubscriptions));
+  memset(pClient->astcTxPending,0,sizeof(pClient->astcTxPending));
+  pClient->u16TxLen = 0;
+  pClient->u16RxLen = 0;
+  pClient->bRxDiscard = false;
+  pClient->bHeartbeat = false;
+  pClient->client.stop();
+}
+
+/*********************************************
+ * Get free heap
+ * 
+ * \return free heap in bytes
+ * 
+ ********************************************* 
+ */
+static uint32_t getFreeHeap(void)
+{
+#if defined(ARDUINO_ARCH_RP2040)
+  return rp2040.getFreeHeap();
+#else
+  return ESP.getFreeHeap();
+#endif
 }
 
 /*********************************************
  * Init Throttle
  * 
+ * u32MaxClients  Max. number of connected throttles,
+ *                reduced if the free heap is too small, but not below MIN_CLIENTS
+ * 
  ********************************************* 
  */
-void WiThrottle_Init(void)
+void WiThrottle_Init(uint32_t u32MaxClients)
 {
+  uint32_t u32Heap = getFreeHeap();
+  uint32_t u32HeapClients = 1;
+  if (u32Heap > HEAP_RESERVE)
+  {
+    u32HeapClients = (u32Heap - HEAP_RESERVE) / (sizeof(stc_withrottle_client_t) + HEAP_PER_CLIENT);
+  }
+  if (u32HeapClients < MIN_CLIENTS)
+  {
+    u32HeapClients = MIN_CLIENTS;
+  }
+  if (u32MaxClients > u32HeapClients)
+  {
+    u32MaxClients = u32HeapClients;
+  }
+  if (u32MaxClients > MAX_CLIENTS_LIMIT)
+  {
+    u32MaxClients = MAX_CLIENTS_LIMIT;
+  }
+  if (u32MaxClients < 1)
+  {
+    u32MaxClients = 1;
+  }
+  serverClients = new (std::nothrow) stc_withrottle_client_t[u32MaxClients](); //zeroed, unused slots are not active
+  u32ClientCount = (serverClients != NULL) ? u32MaxClients : 0;
+  if (debugMode)
+  {
+    Serial.print("WiThrottle clients: ");
+    Serial.println(u32ClientCount);
+  }
   server.begin();
   server.setNoDelay(true);
 }
@@ -466,7 +1479,7 @@ void WiThrottle_Disconnect(void)
   static uint32_t u32LastUpdate = millis();
   if ((millis() - u32LastUpdate) > 1000)
   {
-    for(int i = 0; i < MAX_CLIENTS; i++) {
+    for(uint32_t i = 0; i < u32ClientCount; i++) {
       if (serverClients[i].client) serverClients[i].client.stop();
     }
     u32LastUpdate = millis();
@@ -486,9 +1499,20 @@ void WiThrottle_Disconnect(void)
  */
 void WiThrottle_ReceivedBuffer(stc_withrottle_client_t* pClient, uint8_t* pu8Data,uint32_t u32DataLen)
 {
-  for(int i = 0;i < u32DataLen;i++)
+  uint32_t u32Len;
+  WifiMcuCtrl_KeepAlive();
+  while((u32DataLen > 0) && (pClient->bActive))
   {
-    WiThrottle_ReceivedChar(pClient,pu8Data[i]);
+    u32Len = WITHROTTLE_RX_BUFFER_SIZE - pClient->u16RxLen;
+    if (u32Len > u32DataLen)
+    {
+      u32Len = u32DataLen;
+    }
+    memcpy(&pClient->au8RxBuffer[pClient->u16RxLen],pu8Data,u32Len);
+    pClient->u16RxLen += u32Len;
+    frame(pClient);
+    pu8Data += u32Len;
+    u32DataLen -= u32Len;
   }
 }
 
@@ -503,18 +1527,85 @@ void WiThrottle_ReceivedBuffer(stc_withrottle_client_t* pClient, uint8_t* pu8Dat
  */
 void WiThrottle_ReceivedChar(stc_withrottle_client_t* pClient, uint8_t dataChar)
 {
-  WifiMcuCtrl_KeepAlive();
-  pClient->buffer[pClient->bufferPos] = dataChar;
-  pClient->bufferPos++;
-  pClient->buffer[pClient->bufferPos] = 0;
-  if ((dataChar == '\n') || (pClient->bufferPos > (WITHROTTLE_MAX_BUFFER_PER_LOCO-2)))
+  WiThrottle_ReceivedBuffer(pClient,&dataChar,1);
+}
+
+/*********************************************
+ * Decode all complete lines of the receive buffer
+ * in place and keep the incomplete rest. A line
+ * longer than the buffer is dropped up to its '\n'.
+ * Stops when a line closes the client.
+ * 
+ * pClient  Pointer of connected client handle
+ * 
+ ********************************************* 
+ */
+static void frame(stc_withrottle_client_t* pClient)
+{
+  uint8_t* pu8Buffer = pClient->au8RxBuffer;
+  uint8_t* pu8End;
+  uint16_t u16Pos = 0;
+
+  while((pu8End = (uint8_t*)memchr(&pu8Buffer[u16Pos], '\n', pClient->u16RxLen - u16Pos)) != NULL)
+  {
+    if (pClient->bRxDiscard)
+    {
+      //end of a line which did not fit into the buffer
+      pClient->bRxDiscard = false;
+    } else
+    {
+      decode(pClient,&pu8Buffer[u16Pos],pu8End - &pu8Buffer[u16Pos]);
+      if (!pClient->bActive)
+      {
+        //closed by Q, the lines behind it are not decoded, closeClient() emptied the buffer
+        return;
+      }
+    }
+    u16Pos = (pu8End - pu8Buffer) + 1;
+  }
+
+  if ((u16Pos == 0) && (pClient->u16RxLen >= WITHROTTLE_RX_BUFFER_SIZE))
+  {
+    if ((debugMode) && (!pClient->bRxDiscard))
+    {
+      Serial.println("Line too long, dropped");
+    }
+    pClient->bRxDiscard = true;
+    u16Pos = pClient->u16RxLen;
+  }
+
+  if (u16Pos > 0)
   {
-    decode(pClient);
-    pClient->bufferPos = 0;
-    pClient->buffer[0] = 0;
+    pClient->u16RxLen -= u16Pos;
+    memmove(pu8Buffer,&pu8Buffer[u16Pos],pClient->u16RxLen);
   }
 }
 
+/*********************************************
+ * Read available data of a client in chunks and
+ * decode all complete lines
+ * 
+ * pClient  Pointer of connected client handle
+ * 
+ ********************************************* 
+ */
+static void receive(stc_withrottle_client_t* pClient)
+{
+  int len;
+
+  while((pClient->bActive) && (pClient->client.available() > 0))
+  {
+    len = pClient->client.read(&pClient->au8RxBuffer[pClient->u16RxLen], WITHROTTLE_RX_BUFFER_SIZE - pClient->u16RxLen);
+    if (len <= 0)
+    {
+      break;
+    }
+    WifiMcuCtrl_KeepAlive();
+    pClient->u32LastActivity = millis();
+    pClient->u16RxLen += len;
+    frame(pClient);
+  }
+}
 
 /*********************************************
  * Update WiThrottle from loop()
@@ -523,48 +1614,186 @@ void WiThrottle_ReceivedChar(stc_withrottle_client_t* pClient, uint8_t dataChar)
  */
 void WiThrottle_Update(void)
 {
-  int i;
+  uint32_t i;
+  int iLru = -1;
   //check if there are any new clients
   if (server.hasClient()){
-    for(i = 0; i < MAX_CLIENTS; i++){
+    for(i = 0; i < u32ClientCount; i++){
       //find free/disconnected spot
       if (!serverClients[i].client || !serverClients[i].client.connected()){
-        if(serverClients[i].client) serverClients[i].client.stop();
-        serverClients[i].client = server.available();
-        if ((debugMode) && (!serverClients[i].client)) Serial.println("available broken");
-        if (debugMode)
-        {
-          Serial.print("New client: ");
-          Serial.print(i); Serial.print(' ');
-          Serial.println(serverClients[i].client.remoteIP());
-        }
         break;
       }
+      //remember least recently used spot
+      if ((iLru < 0) || ((millis() - serverClients[i].u32LastActivity) > (millis() - serverClients[iLru].u32LastActivity)))
+      {
+        iLru = i;
+      }
+    }
+    if ((i >= u32ClientCount) && (iLru >= 0) && ((millis() - serverClients[iLru].u32LastActivity) > EVICT_IDLE_MS)) {
+      //no free/disconnected spot, replace the least recently used idle client
+      if (debugMode)
+      {
+        Serial.print("Evict client: ");
+        Serial.println(iLru);
+      }
+      closeClient(&serverClients[iLru],enWiThrottleCloseIdle);
+      i = (uint32_t)iLru;
     }
-    if (i >= MAX_CLIENTS) {
+    if (i < u32ClientCount) {
+      if (serverClients[i].bActive) {
+        //lost client not yet found by the scan below, stop its locos before the slot is reused
+        closeClient(&serverClients[i],enWiThrottleCloseDisconnected);
+      }
+      if(serverClients[i].client) serverClients[i].client.stop();
+      serverClients[i].client = server.available();
+      serverClients[i].u16RxLen = 0;
+      serverClients[i].bRxDiscard = false;
+      serverClients[i].bActive = true;
+      serverClients[i].bHeartbeat = false;
+      serverClients[i].u16TxHead = 0;
+      serverClients[i].u16TxLen = 0;
+      memset(serverClients[i].astcTxPending,0,sizeof(serverClients[i].astcTxPending));
+      memset(serverClients[i].astcSubscriptions,0,sizeof(serverClients[i].astcSubscriptions));
+      serverClients[i].u32LastActivity = millis();
+      if ((debugMode) && (!serverClients[i].client)) Serial.println("available broken");
+      if (debugMode)
+      {
+        Serial.print("New client: ");
+        Serial.print(i); Serial.print(' ');
+        Serial.println(serverClients[i].client.remoteIP());
+      }
+    } else {
       //no free/disconnected spot so reject
       server.available().stop();
     }
   }
-  //check clients for data
-  for(i = 0; i < MAX_CLIENTS; i++){
+  //check clients for data, close lost clients
+  for(i = 0; i < u32ClientCount; i++){
     if (serverClients[i].client && serverClients[i].client.connected()){
-      if(serverClients[i].client.available()){
-        //get data from the telnet client and push it to the UART
-        while(serverClients[i].client.available())
-        {
-          WiThrottle_ReceivedChar(&serverClients[i],serverClients[i].client.read());
-        }
+      receive(&serverClients[i]);
+      if ((serverClients[i].bActive) && (serverClients[i].bHeartbeat) && ((millis() - serverClients[i].u32LastActivity) > HEARTBEAT_TIMEOUT_MS))
+      {
+        closeClient(&serverClients[i],enWiThrottleCloseHeartbeat);
       }
     }
+    else if (serverClients[i].bActive) {
+      closeClient(&serverClients[i],enWiThrottleCloseDisconnected);
+    }
     else {
       if (serverClients[i].client) {
         serverClients[i].client.stop();
       }
     }
   }
+  //send changed loco states, then write everything collected in this loop
+  publish();
+  for(i = 0; i < u32ClientCount; i++){
+    if (serverClients[i].client && serverClients[i].client.connected()){
+      flush(&serverClients[i]);
+    }
+  }
+}
+
+/*********************************************
+ * Publish a loco change to all clients which have
+ * acquired the loco. Can be called from any source
+ * (WiThrottle, REST, peer gateways), the change is
+ * sent once at the end of the next WiThrottle_Update()
+ * 
+ * pLoco        Loco handle
+ * 
+ * u8Changed    WITHROTTLE_CHANGED_SPEED, WITHROTTLE_CHANGED_DIR
+ * 
+ * u32Functions Mask of changed functions
+ * 
+ ********************************************* 
+ */
+void WiThrottle_PublishLoco(stc_withrottle_loco_t* pLoco, uint8_t u8Changed, uint32_t u32Functions)
+{
+  if (pLoco == NULL)
+  {
+    return;
+  }
+  pLoco->u8Changed |= u8Changed;
+  pLoco->u32FunctionsChanged |= u32Functions;
+}
+
+
+/*********************************************
+ * Get size of the client pool
+ * 
+ * \return max. number of connected throttles
+ * 
+ ********************************************* 
+ */
+uint32_t WiThrottle_GetMaxClients(void)
+{
+  return u32ClientCount;
+}
+
+/*********************************************
+ * Get number of clients replaced by a new client
+ * 
+ * \return number of evicted clients
+ * 
+ ********************************************* 
+ */
+uint32_t WiThrottle_GetEvictedClients(void)
+{
+  return u32ClientsEvicted;
+}
+
+/*********************************************
+ * Get counters of closed clients by reason
+ * 
+ * pu32Heartbeat     clients which missed the heartbeat
+ * 
+ * pu32Idle          idle clients replaced by a new client
+ * 
+ * pu32Disconnected  clients which lost the connection
+ * 
+ * pu32LocosStopped  locos stopped because their client was lost
+ * 
+ ********************************************* 
+ */
+void WiThrottle_GetCloseStats(uint32_t* pu32Heartbeat, uint32_t* pu32Idle, uint32_t* pu32Disconnected, uint32_t* pu32LocosStopped)
+{
+  *pu32Heartbeat = u32ClientsHeartbeat;
+  *pu32Idle = u32ClientsEvicted;
+  *pu32Disconnected = u32ClientsDisconnected;
+  *pu32LocosStopped = u32LocosStopped;
+}
+
+/*********************************************
+ * Stop the locos of a client which missed the
+ * heartbeat, lost the connection or was replaced
+ * 
+ * bStop  true to stop (default)
+ * 
+ ********************************************* 
+ */
+void WiThrottle_SetStopLocos(bool bStop)
+{
+  bStopLocos = bStop;
 }
 
+/*********************************************
+ * Get transmit counters of all clients
+ * 
+ * pu32Queued  returns bytes queued for transmission
+ * 
+ * pu32Dropped returns bytes dropped because the transmit ring was full
+ * 
+ * pu32Stalled returns number of times a client did not accept data
+ * 
+ ********************************************* 
+ */
+void WiThrottle_GetTxStats(uint32_t* pu32Queued, uint32_t* pu32Dropped, uint32_t* pu32Stalled)
+{
+  *pu32Queued = u32TxQueued;
+  *pu32Dropped = u32TxDropped;
+  *pu32Stalled = u32TxStalled;
+}
 
 /*********************************************
  * Printf to a connected client
@@ -612,27 +1841,64 @@ void WiThrottle_RegisterPowerCallback(pfn_withrottle_trackpower_callback_t cbTra
 }
 
 /*********************************************
- * Add new loco to the list of locos
+ * Add new loco to the registry of locos
+ * 
+ * Short addresses are mapped directly, long addresses
+ * go to a hash table. pNextItem is still chained in
+ * order of registration.
  * 
  * pLocoItem  List item
  * 
+ * \return  true if added, false if the registry is full
+ *          or the address is already registered
+ * 
  ********************************************* 
  */
-void WiThrottle_AddLoco(stc_withrottle_loco_listitem_t* pLocoItem)
+bool WiThrottle_AddLoco(stc_withrottle_loco_listitem_t* pLocoItem)
 {
-  stc_withrottle_loco_listitem_t* pCurrent = pLocoList;
-  if (pLocoList == NULL)
+  uint32_t u32Address = pLocoItem->locoItem.u32Address;
+  uint32_t u32Index;
+  if ((u32LocoCount >= WITHROTTLE_MAX_LOCOS) || (u32Address == 0) || (getLoco(u32Address) != NULL))
   {
-    pLocoList = pLocoItem;
-    pLocoList->pNextItem = NULL;
-    return;
+    if (debugMode)
+    {
+      Serial.print("Loco not added to registry: ");
+      Serial.println(u32Address);
+    }
+    return false;
   }
-  while(pCurrent->pNextItem != NULL)
+  if ((!pLocoItem->locoItem.bLongAddress) && (u32Address < SHORT_ADDRESS_COUNT))
   {
-    pCurrent = pCurrent->pNextItem;
+    apShortLocos[u32Address] = pLocoItem;
+  } else
+  {
+    u32Index = hashAddress(u32Address);
+    while(apLongLocos[u32Index] != NULL)
+    {
+      u32Index = (u32Index + 1) & (LONG_HASH_SIZE - 1);
+    }
+    apLongLocos[u32Index] = pLocoItem;
   }
-  pCurrent->pNextItem = pLocoItem;
   pLocoItem->pNextItem = NULL;
+  if (u32LocoCount > 0)
+  {
+    apLocos[u32LocoCount - 1]->pNextItem = pLocoItem;
+  }
+  pLocoItem->locoItem.u16Index = u32LocoCount;
+  apLocos[u32LocoCount++] = pLocoItem;
+  bRosterValid = false;
+  return true;
+}
+
+/*********************************************
+ * Roster names or function labels were changed,
+ * the cached roster is rebuilt on the next use
+ * 
+ ********************************************* 
+ */
+void WiThrottle_RosterChanged(void)
+{
+  bRosterValid = false;
 }
 
 
@@ -81,19 +81,58 @@
  *******************************************************************************
  */
 
-#define WITHROTTLE_MAX_BUFFER_PER_LOCO 64
+#define WITHROTTLE_RX_BUFFER_SIZE 128      //receive buffer per client, lines are decoded from here
+#define WITHROTTLE_TX_BUFFER_SIZE 1024     //transmit ring per client, fits the answer of an acquire (MT+)
+#define WITHROTTLE_TX_PENDING_LOCOS 4      //locos per client whose newest state is kept if the transmit ring is full
+#define WITHROTTLE_MAX_SUBSCRIPTIONS 8     //acquired locos per client, changes of these locos are pushed to the client
+#if !defined(WITHROTTLE_MAX_LOCOS)
+#define WITHROTTLE_MAX_LOCOS 64            //locos in the registry, see WiThrottle_AddLoco
+#endif
+#define WITHROTTLE_ROSTER_BUFFER_SIZE 1024 //serialized roster (RL) and function labels of all locos
+
+#define WITHROTTLE_CHANGED_SPEED 0x01
+#define WITHROTTLE_CHANGED_DIR   0x02
+
+#define WITHROTTLE_FUNCTIONS_NONE 0x80000000UL //u32FunctionCapabilities of a loco without functions
 /**
  *******************************************************************************
  ** Global type definitions ('typedef') 
  *******************************************************************************
  */
 
+struct stc_withrottle_loco;
+
+typedef struct stc_withrottle_tx_pending
+{
+  struct stc_withrottle_loco* pLoco;  //NULL if unused
+  char throttleChar;
+  char addressChar;
+  bool bSpeed;
+  bool bDir;
+  uint32_t u32Functions;
+} stc_withrottle_tx_pending_t;
+
+typedef struct stc_withrottle_subscription
+{
+  struct stc_withrottle_loco* pLoco;  //NULL if unused
+  char throttleChar;
+  char addressChar;
+} stc_withrottle_subscription_t;
+
 typedef struct stc_withrottle_client
 {
   WiFiClient client;
-  uint8_t buffer[WITHROTTLE_MAX_BUFFER_PER_LOCO];
-  uint8_t bufferPos;
-  
+  uint8_t au8RxBuffer[WITHROTTLE_RX_BUFFER_SIZE];
+  uint16_t u16RxLen;
+  bool bRxDiscard;           //line longer than the receive buffer, dropped up to the next '\n'
+  bool bActive;              //slot in use, cleared by closing the client
+  bool bHeartbeat;           //client enabled the heartbeat with *+
+  uint8_t au8TxBuffer[WITHROTTLE_TX_BUFFER_SIZE];
+  uint16_t u16TxHead;
+  uint16_t u16TxLen;
+  stc_withrottle_tx_pending_t astcTxPending[WITHROTTLE_TX_PENDING_LOCOS];
+  stc_withrottle_subscription_t astcSubscriptions[WITHROTTLE_MAX_SUBSCRIPTIONS];
+  uint32_t u32LastActivity;  //millis() of last received data, used for LRU eviction
 } stc_withrottle_client_t;
 
 struct stc_withrottle_loco;
@@ -111,6 +150,12 @@ typedef struct stc_withrottle_loco
    bool bDir;
    int speed;
    uint32_t u32FunctionMask;
+   uint32_t u32FunctionCapabilities;     //bit n set if the loco has Fn, 0 for all of F0...F27, WITHROTTLE_FUNCTIONS_NONE for none
+   uint8_t u8Changed;              //WITHROTTLE_CHANGED_... not published yet
+   uint32_t u32FunctionsChanged;   //functions not published yet
+   const char* pName;                    //roster name, NULL if the loco is not in the roster
+   const char* const* ppFunctionLabels;  //labels of F0, F1, ... NULL terminated, NULL for none
+   uint16_t u16Index;                    //position in the loco registry, set by WiThrottle_AddLoco()
 } stc_withrottle_loco_t;
 
 struct stc_withrottle_loco_listitem;
@@ -140,13 +185,20 @@ typedef stc_withrottle_loco_listitem_t* (*pfn_withrottle_createloco_callback_t)(
  */
 
 
-void WiThrottle_Init(void);
+void WiThrottle_Init(uint32_t u32MaxClients);
 void WiThrottle_Disconnect(void);
 void WiThrottle_Update(void);
+uint32_t WiThrottle_GetMaxClients(void);
+uint32_t WiThrottle_GetEvictedClients(void);
+void WiThrottle_GetCloseStats(uint32_t* pu32Heartbeat, uint32_t* pu32Idle, uint32_t* pu32Disconnected, uint32_t* pu32LocosStopped);
+void WiThrottle_SetStopLocos(bool bStop);
+void WiThrottle_GetTxStats(uint32_t* pu32Queued, uint32_t* pu32Dropped, uint32_t* pu32Stalled);
 void WiThrottle_Printf(stc_withrottle_client_t* pClient,char* format,...);
 void WiThrottle_ReceivedBuffer(stc_withrottle_client_t* pClient, uint8_t* pu8Data,uint32_t u32DataLen);
 void WiThrottle_ReceivedChar(stc_withrottle_client_t* pClient, uint8_t dataChar);
-void WiThrottle_AddLoco(stc_withrottle_loco_listitem_t* pLocoItem);
+bool WiThrottle_AddLoco(stc_withrottle_loco_listitem_t* pLocoItem);
+void WiThrottle_RosterChanged(void);
+void WiThrottle_PublishLoco(stc_withrottle_loco_t* pLoco, uint8_t u8Changed, uint32_t u32Functions);
 void WiThrottle_CreateLocoCallback(pfn_withrottle_createloco_callback_t cbCreateLoco);
 void WiThrottle_RegisterPowerCallback(pfn_withrottle_trackpower_callback_t cbTrackPower);
 
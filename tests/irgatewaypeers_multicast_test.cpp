@@ -0,0 +1,239 @@
+/**
+ *******************************************************************************
+ **\file irgatewaypeers_multicast_test.cpp
+ **
+ ** Test of the multicast replication between gateways: several gateway
+ ** processes on loopback multicast send batches to each other at the same
+ ** time. Every instance has to execute every batch of the others exactly
+ ** once and complete, drop the second copy of every datagram as duplicate
+ ** and never execute its own datagrams.
+ **
+ ** Usage: irgatewaypeers_multicast_test [instances] [batches per instance]
+ **
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include "hoststub.h"
+#include "irgatewaypeers.h"
+#include "irgatewaywebserver.h"
+#include "maerklin292xxir.h"
+#include "mdns/mdnsclientlist.h"
+
+#define MAX_INSTANCES 10    //channels A...J
+#define SETTLE_MS 1000      //receive after the last batch was sent
+#define SKIPPED 77          //ctest SKIP_RETURN_CODE
+
+typedef struct stc_instance_result
+{
+  uint32_t u32Sent;
+  uint32_t u32Received;
+  uint32_t u32Duplicates;
+  uint32_t au32Commands[MAX_INSTANCES];  //commands executed per sending instance
+  uint32_t u32Errors;                    //commands with wrong content
+} stc_instance_result_t;
+
+static stc_instance_result_t stcResult;
+
+/**
+ *******************************************************************************
+ ** Replaced modules
+ *******************************************************************************
+ */
+
+int MdnsClientList_Count(void)
+{
+  return 0;
+}
+
+const char* MdnsClientList_GetIPString(int i)
+{
+  (void)i;
+  return "";
+}
+
+uint32_t Maerklin292xxIr_GetQueueCount(void)
+{
+  return 0;
+}
+
+/*
+ * Command j of a batch is speed -j on the channel of the sender, j * 100 ms
+ * after the start of the batch
+ */
+bool IrGatewayWebServer_ExecuteBatch(const stc_irgateway_cmd_t* pastcCmds, uint8_t u8Count)
+{
+  int i;
+  for(i = 0; i < u8Count; i++)
+  {
+    int iInstance = pastcCmds[i].channel - 'A';
+    if ((iInstance < 0) || (iInstance >= MAX_INSTANCES) || (pastcCmds[i].u8Cmd != enIrGatewayCmdSpeed) ||
+        (pastcCmds[i].i8Arg != -(i % 4)) || (pastcCmds[i].u16OffsetMs != i * 100))
+    {
+      stcResult.u32Errors++;
+      continue;
+    }
+    stcResult.au32Commands[iInstance]++;
+  }
+  return true;
+}
+
+/**
+ *******************************************************************************
+ ** Gateway instance
+ *******************************************************************************
+ */
+
+static uint8_t batchSize(int iBatch)
+{
+  return 1 + (iBatch % IRGATEWAYPEERS_MAX_ENTRIES);
+}
+
+static void update(uint32_t u32Ms)
+{
+  uint32_t u32Start = millis();
+  do
+  {
+    IrGatewayPeers_Update();
+    usleep(1000);
+  } while((millis() - u32Start) < u32Ms);
+}
+
+/*
+ * Run one gateway, the result is written to the pipe
+ */
+static void runInstance(int iInstance, int iInstances, int iBatches, int fdReady, int fdGo, int fdResult)
+{
+  stc_irgateway_cmd_t astcBatch[IRGATEWAYPEERS_MAX_ENTRIES];
+  char c = 0;
+  int i, j;
+
+  HostStub_UseRealTime(true);
+  HostStub_SetLocalIp(IPAddress(10, 0, 0, iInstance + 1));
+  IrGatewayPeers_Init(true);
+  if ((write(fdReady, &c, 1) != 1) || (read(fdGo, &c, 1) != 1))
+  {
+    _exit(1);
+  }
+  for(i = 0; i < iBatches; i++)
+  {
+    for(j = 0; j < batchSize(i); j++)
+    {
+      astcBatch[j].channel = 'A' + iInstance;
+      astcBatch[j].u8Cmd = enIrGatewayCmdSpeed;
+      astcBatch[j].i8Arg = -(j % 4);
+      astcBatch[j].u16OffsetMs = j * 100;
+    }
+    IrGatewayPeers_Send(astcBatch, batchSize(i));
+    //all instances together send about 2 datagrams per ms, an update reads up to 8
+    update(iInstances);
+  }
+  update(SETTLE_MS);
+  IrGatewayPeers_GetMulticastStats(&stcResult.u32Sent, &stcResult.u32Received, &stcResult.u32Duplicates);
+  _exit((write(fdResult, &stcResult, sizeof(stcResult)) == sizeof(stcResult)) ? 0 : 1);
+}
+
+int main(int argc, char** argv)
+{
+  int iInstances = (argc > 1) ? atoi(argv[1]) : 3;
+  int iBatches = (argc > 2) ? atoi(argv[2]) : 50;
+  int afdReady[2], afdGo[2], afdResult[MAX_INSTANCES][2];
+  uint32_t u32Commands = 0;
+  int iErrors = 0;
+  int i, n;
+  char c = 0;
+
+  if ((iInstances < 2) || (iInstances > MAX_INSTANCES))
+  {
+    fprintf(stderr, "2...%d instances\n", MAX_INSTANCES);
+    return 2;
+  }
+  {
+    WiFiUDP probe;
+    if (probe.beginMulticast(IPAddress(IRGATEWAYPEERS_MULTICAST_GROUP), IRGATEWAYPEERS_MULTICAST_PORT) == 0)
+    {
+      printf("multicast on loopback not available, skipped\n");
+      return SKIPPED;
+    }
+  }
+  for(i = 0; i < iBatches; i++)
+  {
+    u32Commands += batchSize(i);
+  }
+
+  if ((pipe(afdReady) != 0) || (pipe(afdGo) != 0))
+  {
+    perror("pipe");
+    return 2;
+  }
+  for(i = 0; i < iInstances; i++)
+  {
+    if (pipe(afdResult[i]) != 0)
+    {
+      perror("pipe");
+      return 2;
+    }
+    if (fork() == 0)
+    {
+      runInstance(i, iInstances, iBatches, afdReady[1], afdGo[0], afdResult[i][1]);
+    }
+  }
+  //all instances joined the group before the first batch is sent
+  for(i = 0; i < iInstances; i++)
+  {
+    if (read(afdReady[0], &c, 1) != 1)
+    {
+      perror("read");
+      return 2;
+    }
+  }
+  for(i = 0; i < iInstances; i++)
+  {
+    if (write(afdGo[1], &c, 1) != 1)
+    {
+      perror("write");
+      return 2;
+    }
+  }
+
+  for(i = 0; i < iInstances; i++)
+  {
+    stc_instance_result_t stcInstance;
+    if (read(afdResult[i][0], &stcInstance, sizeof(stcInstance)) != sizeof(stcInstance))
+    {
+      printf("FAIL instance %d: no result\n", i);
+      iErrors++;
+      continue;
+    }
+    printf("instance %d: sent %u, received %u, duplicates %u, errors %u\n", i,
+           stcInstance.u32Sent, stcInstance.u32Received, stcInstance.u32Duplicates, stcInstance.u32Errors);
+    if ((stcInstance.u32Sent != (uint32_t)iBatches) || (stcInstance.u32Received != (uint32_t)(iBatches * (iInstances - 1))) ||
+        (stcInstance.u32Duplicates != stcInstance.u32Received) || (stcInstance.u32Errors != 0))
+    {
+      printf("FAIL instance %d: expected %d batches sent and %d received, one duplicate per batch\n", i, iBatches, iBatches * (iInstances - 1));
+      iErrors++;
+    }
+    for(n = 0; n < iInstances; n++)
+    {
+      uint32_t u32Expected = (n == i) ? 0 : u32Commands;
+      if (stcInstance.au32Commands[n] != u32Expected)
+      {
+        printf("FAIL instance %d: %u of %u commands of instance %d executed\n", i, stcInstance.au32Commands[n], u32Expected, n);
+        iErrors++;
+      }
+    }
+  }
+  for(i = 0; i < iInstances; i++)
+  {
+    int iStatus;
+    wait(&iStatus);
+  }
+  printf("%d errors\n", iErrors);
+  return (iErrors == 0) ? 0 : 1;
+}
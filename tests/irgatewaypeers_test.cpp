@@ -0,0 +1,335 @@
+/**
+ *******************************************************************************
+ **\file irgatewaypeers_test.cpp
+ **
+ ** Test of the HTTP replication to the peer gateways.
+ **
+ ** Two simulated peers answer POST /api/cmd 20 ms after the request, one
+ ** of them is offline at first. The test checks that sending returns at
+ ** once, that the offline peer gets retries with backoff while the other
+ ** one is served, that commands go over one keep-alive connection per
+ ** peer, that a batch of 16 commands is one POST, that no connect is done
+ ** while IR frames are waiting, and that peers closing the connection
+ ** after every response get all commands.
+ **
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <Arduino.h>
+#include <WiFi.h>
+#include "hoststub.h"
+#include "irgatewaypeers.h"
+#include "irgatewaywebserver.h"
+#include "maerklin292xxir.h"
+#include "mdns/mdnsclientlist.h"
+
+#define PEER_ONLINE "10.0.0.2"
+#define PEER_OFFLINE "10.0.0.3"
+#define RESPONSE_DELAY_MS 20
+#define CONNECT_BLOCK_MS 200  //connect to an offline peer runs into the timeout of the gateway
+#define LOOP_MS 10
+
+typedef struct stc_peer_conn
+{
+  HostConnectionPtr pConn;
+  std::string strIp;
+  size_t u32Parsed;                //bytes of strTx parsed as requests
+  std::deque<uint32_t> dueTimes;   //responses waiting to be sent
+  bool bClosing;                   //response with "Connection: close" sent
+} stc_peer_conn_t;
+
+static int iErrors = 0;
+static std::vector<const char*> peers = {PEER_ONLINE, PEER_OFFLINE};
+static std::map<std::string, bool> mapOnline;
+static std::map<std::string, int> mapPosts;
+static std::vector<stc_peer_conn_t> connections;
+static std::string strLastBody;
+static bool bCloseMode = false;
+static int iConnects = 0;
+static uint32_t u32IrQueue = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAIL line %d: ", __LINE__); printf(__VA_ARGS__); printf("\n"); iErrors++; } } while(0)
+
+/**
+ *******************************************************************************
+ ** Replaced modules
+ *******************************************************************************
+ */
+
+int MdnsClientList_Count(void)
+{
+  return (int)peers.size();
+}
+
+const char* MdnsClientList_GetIPString(int i)
+{
+  return peers[i];
+}
+
+uint32_t Maerklin292xxIr_GetQueueCount(void)
+{
+  return u32IrQueue;
+}
+
+bool IrGatewayWebServer_ExecuteBatch(const stc_irgateway_cmd_t* pastcCmds, uint8_t u8Count)
+{
+  (void)pastcCmds;
+  (void)u8Count;
+  return true;
+}
+
+/**
+ *******************************************************************************
+ ** Simulated peers
+ *******************************************************************************
+ */
+
+static std::string ipString(uint32_t u32Ip)
+{
+  char acIp[16];
+  snprintf(acIp, sizeof(acIp), "%u.%u.%u.%u", u32Ip & 0xff, (u32Ip >> 8) & 0xff, (u32Ip >> 16) & 0xff, u32Ip >> 24);
+  return acIp;
+}
+
+/*
+ * Parse the complete requests written by the gateway
+ */
+static void peerReceive(stc_peer_conn_t* pPeer)
+{
+  std::string& strTx = pPeer->pConn->strTx;
+  size_t u32HeaderEnd;
+  size_t u32Length;
+  while((!pPeer->bClosing) && ((u32HeaderEnd = strTx.find("\r\n\r\n", pPeer->u32Parsed)) != std::string::npos))
+  {
+    size_t u32Field = strTx.find("Content-Length: ", pPeer->u32Parsed);
+    if ((u32Field == std::string::npos) || (u32Field > u32HeaderEnd))
+    {
+      printf("FAIL: request without Content-Length\n");
+      iErrors++;
+      return;
+    }
+    u32Length = atoi(strTx.c_str() + u32Field + 16);
+    if (strTx.size() < (u32HeaderEnd + 4 + u32Length))
+    {
+      return;
+    }
+    CHECK(strTx.compare(pPeer->u32Parsed, 19, "POST /api/cmd HTTP/") == 0, "not a POST /api/cmd");
+    strLastBody = strTx.substr(u32HeaderEnd + 4, u32Length);
+    pPeer->u32Parsed = u32HeaderEnd + 4 + u32Length;
+    mapPosts[pPeer->strIp]++;
+    pPeer->dueTimes.push_back(millis() + RESPONSE_DELAY_MS);
+    //in close mode the pipelined requests after the first one are not read
+    pPeer->bClosing = bCloseMode;
+  }
+}
+
+static void peerRespond(void)
+{
+  size_t i;
+  for(i = 0; i < connections.size(); i++)
+  {
+    stc_peer_conn_t* pPeer = &connections[i];
+    while((!pPeer->dueTimes.empty()) && ((int32_t)(millis() - pPeer->dueTimes.front()) >= 0))
+    {
+      pPeer->dueTimes.pop_front();
+      if (pPeer->pConn->bConnected)
+      {
+        pPeer->pConn->strRx += bCloseMode ?
+          "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 2\r\nConnection: close\r\n\r\nOK" :
+          "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 2\r\nConnection: keep-alive\r\n\r\nOK";
+        if (bCloseMode)
+        {
+          pPeer->pConn->bConnected = false;
+        }
+      }
+    }
+  }
+}
+
+static HostConnectionPtr peerConnect(uint32_t u32Ip, uint16_t u16Port)
+{
+  stc_peer_conn_t stcPeer;
+  std::string strIp = ipString(u32Ip);
+  iConnects++;
+  CHECK(u16Port == 80, "connect to port %u", u16Port);
+  if (!mapOnline[strIp])
+  {
+    HostStub_AdvanceMillis(CONNECT_BLOCK_MS);
+    return NULL;
+  }
+  stcPeer.pConn = std::make_shared<HostConnection>();
+  stcPeer.pConn->u32RemoteIp = u32Ip;
+  stcPeer.pConn->u16Port = u16Port;
+  stcPeer.strIp = strIp;
+  stcPeer.u32Parsed = 0;
+  stcPeer.bClosing = false;
+  size_t u32Index = connections.size();
+  stcPeer.pConn->pfnOnWrite = [u32Index](HostConnection* pConn) { (void)pConn; peerReceive(&connections[u32Index]); };
+  connections.push_back(stcPeer);
+  return stcPeer.pConn;
+}
+
+/*
+ * Close all connections on the peer side
+ */
+static void peerCloseAll(void)
+{
+  size_t i;
+  for(i = 0; i < connections.size(); i++)
+  {
+    connections[i].pConn->bConnected = false;
+  }
+}
+
+/**
+ *******************************************************************************
+ ** Test
+ *******************************************************************************
+ */
+
+static void loop(int iCount)
+{
+  int i;
+  int iConnectsBefore;
+  for(i = 0; i < iCount; i++)
+  {
+    peerRespond();
+    iConnectsBefore = iConnects;
+    IrGatewayPeers_Update();
+    CHECK((iConnects - iConnectsBefore) <= 1, "%d connects in one update", iConnects - iConnectsBefore);
+    HostStub_AdvanceMillis(LOOP_MS);
+  }
+}
+
+static void send(char channel, en_irgateway_cmd_t enCmd, int8_t i8Arg)
+{
+  stc_irgateway_cmd_t stcCmd = {channel, (uint8_t)enCmd, i8Arg, 0};
+  int iConnectsBefore = iConnects;
+  uint32_t u32Before = millis();
+  IrGatewayPeers_Send(&stcCmd, 1);
+  CHECK((iConnects == iConnectsBefore) && (millis() == u32Before), "IrGatewayPeers_Send() did not return at once");
+}
+
+int main(void)
+{
+  uint32_t u32Sent, u32Retries, u32Dropped;
+  int iPostsOnline, iPostsOffline;
+  std::vector<stc_irgateway_cmd_t> batch;
+  int i;
+
+  HostStub_SetMillis(1000);
+  HostStub_SetConnectHandler(peerConnect);
+  mapOnline[PEER_ONLINE] = true;
+  mapOnline[PEER_OFFLINE] = false;
+  IrGatewayPeers_Init(false);
+
+  //
+  // offline peer: retries with backoff, the other peer is served
+  //
+  send('A', enIrGatewayCmdSpeed, 2);
+  send('B', enIrGatewayCmdLight, 0);
+  send('C', enIrGatewayCmdStop, 0);
+  loop(400);
+  IrGatewayPeers_GetStats(&u32Sent, &u32Retries, &u32Dropped);
+  printf("offline peer: posts %d/%d, sent %u, retries %u, dropped %u, connects %d\n",
+         mapPosts[PEER_ONLINE], mapPosts[PEER_OFFLINE], u32Sent, u32Retries, u32Dropped, iConnects);
+  CHECK(mapPosts[PEER_ONLINE] == 3, "online peer got %d of 3 commands", mapPosts[PEER_ONLINE]);
+  CHECK(mapPosts[PEER_OFFLINE] == 0, "offline peer got commands");
+  CHECK(u32Retries >= 3, "%u retries", u32Retries);
+  CHECK(u32Dropped >= 1, "nothing dropped for the offline peer");
+  //250 + 500 + 1000 ms backoff and the blocking connects, far less than one connect per loop
+  CHECK(iConnects < 20, "%d connects, no backoff", iConnects);
+
+  //
+  // keep-alive: the connections stay open for 20 commands
+  //
+  mapOnline[PEER_OFFLINE] = true;
+  loop(600);
+  CHECK(mapPosts[PEER_OFFLINE] > 0, "peer back online got no commands");
+  iPostsOnline = mapPosts[PEER_ONLINE];
+  iPostsOffline = mapPosts[PEER_OFFLINE];
+  iConnects = 0;
+  for(i = 0; i < 20; i++)
+  {
+    send('C', enIrGatewayCmdStop, 0);
+    loop(5);
+  }
+  loop(100);
+  printf("keep-alive: posts %d/%d, connects %d\n", mapPosts[PEER_ONLINE] - iPostsOnline, mapPosts[PEER_OFFLINE] - iPostsOffline, iConnects);
+  CHECK(mapPosts[PEER_ONLINE] - iPostsOnline == 20, "online peer got %d of 20 commands", mapPosts[PEER_ONLINE] - iPostsOnline);
+  CHECK(mapPosts[PEER_OFFLINE] - iPostsOffline == 20, "peer back online got %d of 20 commands", mapPosts[PEER_OFFLINE] - iPostsOffline);
+  CHECK(iConnects == 0, "%d connects for 20 commands, connections not kept open", iConnects);
+  CHECK(strLastBody == "{\"channel\":\"C\",\"cmd\":\"stop\",\"args\":\"\",\"repeated\":\"true\"}", "single command body %s", strLastBody.c_str());
+
+  //
+  // batch of 16 commands is one POST
+  //
+  batch.push_back({'A', enIrGatewayCmdLight, 0, 0});
+  batch.push_back({0, enIrGatewayCmdSound, 2, 0});
+  batch.push_back({'G', enIrGatewayCmdSpeed, -3, 500});
+  for(i = 0; i < 13; i++)
+  {
+    batch.push_back({'J', enIrGatewayCmdSpeed, 1, (uint16_t)(1000 + i * 400)});
+  }
+  iPostsOnline = mapPosts[PEER_ONLINE];
+  IrGatewayPeers_Send(batch.data(), batch.size());
+  loop(50);
+  printf("batch: posts %d, body %u bytes\n", mapPosts[PEER_ONLINE] - iPostsOnline, (unsigned)strLastBody.size());
+  CHECK(mapPosts[PEER_ONLINE] - iPostsOnline == 1, "batch sent as %d POSTs", mapPosts[PEER_ONLINE] - iPostsOnline);
+  CHECK(strLastBody.rfind("{\"repeated\":\"true\",\"commands\":[{", 0) == 0, "batch body %s", strLastBody.c_str());
+  {
+    int iCommands = 0;
+    size_t u32Pos = 0;
+    while((u32Pos = strLastBody.find("\"cmd\":", u32Pos)) != std::string::npos)
+    {
+      iCommands++;
+      u32Pos++;
+    }
+    CHECK(iCommands == 16, "%d commands in the batch body", iCommands);
+  }
+  CHECK(strLastBody.find("{\"channel\":\"G\",\"cmd\":\"speed\",\"args\":-3,\"delay\":500}") != std::string::npos, "delay of the batch %s", strLastBody.c_str());
+
+  //
+  // no connect while IR frames are waiting
+  //
+  peerCloseAll();
+  loop(10);
+  iConnects = 0;
+  iPostsOnline = mapPosts[PEER_ONLINE];
+  u32IrQueue = 3;
+  send('D', enIrGatewayCmdForward, 0);
+  loop(100);
+  CHECK(iConnects == 0, "%d connects while IR frames are waiting", iConnects);
+  u32IrQueue = 0;
+  loop(50);
+  CHECK(mapPosts[PEER_ONLINE] - iPostsOnline == 1, "command not sent after the IR queue was empty");
+
+  //
+  // peers closing the connection after every response
+  //
+  bCloseMode = true;
+  iConnects = 0;
+  iPostsOnline = mapPosts[PEER_ONLINE];
+  iPostsOffline = mapPosts[PEER_OFFLINE];
+  for(i = 0; i < 4; i++)
+  {
+    send('D', enIrGatewayCmdForward, 0);
+  }
+  loop(200);
+  printf("connection close: posts %d/%d, connects %d\n", mapPosts[PEER_ONLINE] - iPostsOnline, mapPosts[PEER_OFFLINE] - iPostsOffline, iConnects);
+  CHECK(mapPosts[PEER_ONLINE] - iPostsOnline == 4, "peer got %d of 4 commands", mapPosts[PEER_ONLINE] - iPostsOnline);
+  CHECK(mapPosts[PEER_OFFLINE] - iPostsOffline == 4, "peer got %d of 4 commands", mapPosts[PEER_OFFLINE] - iPostsOffline);
+  //the first command goes over the open keep-alive connection
+  CHECK(iConnects == 6, "%d connects for 4 commands to 2 peers", iConnects);
+
+  IrGatewayPeers_GetStats(&u32Sent, &u32Retries, &u32Dropped);
+  printf("sent %u, retries %u, dropped %u\n", u32Sent, u32Retries, u32Dropped);
+  printf("%d errors\n", iErrors);
+  return (iErrors == 0) ? 0 : 1;
+}
@@ -0,0 +1,357 @@
+/**
+ *******************************************************************************
+ **\file irgatewaywebserver_bench.cpp
+ **
+ ** Commands per second of the command dispatch of IrGatewayWebServer,
+ ** compared with the String dispatch it replaced (copied below as
+ ** reference, same IR and loco database calls):
+ **
+ ** - dispatch: IrGatewayWebServer_ProcessCommand() with the channel,
+ **   command and argument strings
+ ** - routes: GET /cmd/... through the WebServer stub, the reference
+ **   copies every path segment into a String like the old handlers
+ **
+ ** The IR scheduler, loco database and peers are replaced by counters,
+ ** only the dispatch is measured. Both must execute the same commands.
+ **
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <chrono>
+#include <Arduino.h>
+#include <WebServer.h>
+#include "irgatewaywebserver.h"
+#include "maerklin292xxir.h"
+#include "locodatabase.h"
+#include "irgatewaypeers.h"
+#include "withrottle/withrottle.h"
+#include "wifimcu/htmlfs.h"
+#include "wifimcu/wifimcuctrl.h"
+
+#define BENCH_COMMANDS 2000000
+
+static uint32_t u32Executed = 0;
+static uint32_t u32Checksum = 0;
+static uint32_t u32Forwarded = 0;
+
+static void executed(uint32_t u32Address, int iValue)
+{
+  u32Executed++;
+  u32Checksum = (u32Checksum * 31) + (u32Address * 16) + (uint32_t)(iValue + 8);
+}
+
+/**
+ *******************************************************************************
+ ** Replaced modules
+ *******************************************************************************
+ */
+
+void Maerklin292xxIr_Send(en_maerklin_292xx_ir_address_t enAddress, uint8_t enFunction)
+{
+  executed(enAddress, enFunction);
+}
+
+void Maerklin292xxIr_SetSpeed(en_maerklin_292xx_ir_address_t enAddress, int speed)
+{
+  executed(enAddress, speed);
+}
+
+void Maerklin292xxIr_ToggleSoundLight(en_maerklin_292xx_ir_address_t enAddress, en_maerklin_292xx_ir_func_t enFunction)
+{
+  executed(enAddress, enFunction);
+}
+
+uint32_t Maerklin292xxIr_GetQueueCount(void)
+{
+  return 0;
+}
+
+int Maerklin292xxIr_GetEmitter(en_maerklin_292xx_ir_address_t enAddress)
+{
+  (void)enAddress;
+  return 0;
+}
+
+bool Maerklin292xxIr_GetSpeedStats(en_maerklin_292xx_ir_address_t enAddress, uint32_t* pu32Updates, uint32_t* pu32Coalesced)
+{
+  (void)enAddress;
+  *pu32Updates = 0;
+  *pu32Coalesced = 0;
+  return false;
+}
+
+bool Maerklin292xxIr_GetRepeatStats(en_maerklin_292xx_ir_address_t enAddress, uint32_t* pu32Sent, uint32_t* pu32Dropped)
+{
+  (void)enAddress;
+  *pu32Sent = 0;
+  *pu32Dropped = 0;
+  return false;
+}
+
+void LocoDatabase_SpeedChanged(uint32_t u32Address, int iSpeed)
+{
+  executed(u32Address, iSpeed);
+}
+
+void LocoDatabase_FunctionToggled(uint32_t u32Address, uint8_t u8Function)
+{
+  executed(u32Address, u8Function);
+}
+
+void IrGatewayPeers_Send(const stc_irgateway_cmd_t* pastcCmds, uint8_t u8Count)
+{
+  (void)pastcCmds;
+  u32Forwarded += u8Count;
+}
+
+void IrGatewayPeers_GetStats(uint32_t* pu32Sent, uint32_t* pu32Retries, uint32_t* pu32Dropped)
+{
+  *pu32Sent = 0;
+  *pu32Retries = 0;
+  *pu32Dropped = 0;
+}
+
+void IrGatewayPeers_GetMulticastStats(uint32_t* pu32Sent, uint32_t* pu32Received, uint32_t* pu32Duplicates)
+{
+  *pu32Sent = 0;
+  *pu32Received = 0;
+  *pu32Duplicates = 0;
+}
+
+void WiThrottle_GetCloseStats(uint32_t* pu32Heartbeat, uint32_t* pu32Idle, uint32_t* pu32Disconnected, uint32_t* pu32LocosStopped)
+{
+  *pu32Heartbeat = 0;
+  *pu32Idle = 0;
+  *pu32Disconnected = 0;
+  *pu32LocosStopped = 0;
+}
+
+void HtmlFs_Init(WebServer* pServer)
+{
+  (void)pServer;
+}
+
+/**
+ *******************************************************************************
+ ** Reference: String dispatch before the perfect hash tables
+ *******************************************************************************
+ */
+
+static en_maerklin_292xx_ir_address_t enReferenceAddress = enMaerklin292xxIrAddressA;
+static WebServer* pReferenceServer;
+
+static void referenceProcessCommand(String channel, String command, String commandArg)
+{
+    WifiMcuCtrl_KeepAlive();
+    if (channel != "")
+    {
+        if (channel == "A")
+        {
+           enReferenceAddress = enMaerklin292xxIrAddressA;
+        } else if (channel == "B")
+        {
+           enReferenceAddress = enMaerklin292xxIrAddressB;
+        } else if (channel == "C")
+        {
+           enReferenceAddress = enMaerklin292xxIrAddressC;
+        } else if (channel == "D")
+        {
+           enReferenceAddress = enMaerklin292xxIrAddressD;
+        } else if (channel == "G")
+        {
+           enReferenceAddress = enMaerklin292xxIrAddressG;
+        } else if (channel == "H")
+        {
+           enReferenceAddress = enMaerklin292xxIrAddressH;
+        } else if (channel == "I")
+        {
+           enReferenceAddress = enMaerklin292xxIrAddressI;
+        } else if (channel == "J")
+        {
+           enReferenceAddress = enMaerklin292xxIrAddressJ;
+        }
+    }
+    if (command == "sound")
+    {
+        if ((commandArg == "motor") || (commandArg == "3"))
+        {
+            Maerklin292xxIr_ToggleSoundLight(enReferenceAddress,enMaerklin292xxIrFuncSound1);
+            LocoDatabase_FunctionToggled(enReferenceAddress,1);
+        } else if ((commandArg == "horn") || (commandArg == "2"))
+        {
+            Maerklin292xxIr_ToggleSoundLight(enReferenceAddress,enMaerklin292xxIrFuncSound2);
+            LocoDatabase_FunctionToggled(enReferenceAddress,2);
+        } else if ((commandArg == "coupler") || (commandArg == "1"))
+        {
+            Maerklin292xxIr_ToggleSoundLight(enReferenceAddress,enMaerklin292xxIrFuncSound3);
+            LocoDatabase_FunctionToggled(enReferenceAddress,3);
+        }
+    } else if (command == "speed")
+    {
+      int speed = commandArg.toInt();
+      Maerklin292xxIr_SetSpeed(enReferenceAddress,speed);
+      LocoDatabase_SpeedChanged(enReferenceAddress,speed);
+    } else if (command == "forward")
+    {
+        Maerklin292xxIr_Send(enReferenceAddress,enMaerklin292xxIrFuncForward);
+    } else if (command == "stop")
+    {
+        Maerklin292xxIr_Send(enReferenceAddress,enMaerklin292xxIrFuncStop);
+        LocoDatabase_SpeedChanged(enReferenceAddress,0);
+    }  else if (command == "backward")
+    {
+        Maerklin292xxIr_Send(enReferenceAddress,enMaerklin292xxIrFuncBackward);
+    } else if (command == "light")
+    {
+        Maerklin292xxIr_ToggleSoundLight(enReferenceAddress,enMaerklin292xxIrFuncLight);
+        LocoDatabase_FunctionToggled(enReferenceAddress,0);
+    }
+}
+
+static void referenceRoutes(WebServer* pServer)
+{
+  pReferenceServer = pServer;
+  pServer->on("/cmd/{}/{}/{}", []() {
+    String channel = pReferenceServer->pathArg(0);
+    String cmd = pReferenceServer->pathArg(1);
+    String cmdArgs = pReferenceServer->pathArg(2);
+    referenceProcessCommand(channel,cmd,cmdArgs);
+    pReferenceServer->send(200, "text/plain", "done");
+  });
+  pServer->on("/cmd/{}/{}", []() {
+    String channel = pReferenceServer->pathArg(0);
+    String cmd = pReferenceServer->pathArg(1);
+    String cmdArgs = "";
+    if (!((channel.charAt(0) >= 'A') && (channel.charAt(0) <= 'Z')))
+    {
+       channel = "";
+       cmd = pReferenceServer->pathArg(0);
+       cmdArgs = pReferenceServer->pathArg(1);
+    }
+    referenceProcessCommand(channel,cmd,cmdArgs);
+    pReferenceServer->send(200, "text/plain", "done");
+  });
+  pServer->on("/cmd/{}", []() {
+    String cmd = pReferenceServer->pathArg(0);
+    WifiMcuCtrl_KeepAlive();
+    if (cmd == "keepalive")
+    {
+        pReferenceServer->send(200, "text/plain", "keep alive accepted");
+    } else
+    {
+        referenceProcessCommand("",cmd,"");
+        pReferenceServer->send(200, "text/plain", "done");
+    }
+  });
+}
+
+/**
+ *******************************************************************************
+ ** Benchmark
+ *******************************************************************************
+ */
+
+static const char* aapcCommands[][3] = {
+  {"A", "speed", "2"},
+  {"J", "light", ""},
+  {"G", "sound", "horn"},
+  {"C", "stop", ""},
+  {"H", "backward", ""},
+  {"", "keepalive", ""},
+  {"D", "sound", "3"},
+  {"I", "forward", ""},
+  {"B", "speed", "-3"},
+  {"", "light", ""},
+  {"X", "speed", "1"},
+  {"A", "whistle", ""},
+};
+#define COMMAND_COUNT (sizeof(aapcCommands) / sizeof(aapcCommands[0]))
+
+static const char* apcUris[] = {
+  "/cmd/A/speed/2",
+  "/cmd/J/light",
+  "/cmd/G/sound/horn",
+  "/cmd/C/stop",
+  "/cmd/H/backward",
+  "/cmd/keepalive",
+  "/cmd/D/sound/3",
+  "/cmd/I/forward",
+  "/cmd/speed/-3",
+  "/cmd/light",
+  "/cmd/X/speed/1",
+  "/cmd/A/whistle",
+};
+#define URI_COUNT (sizeof(apcUris) / sizeof(apcUris[0]))
+
+typedef struct stc_result
+{
+  double dCommandsPerSecond;
+  uint32_t u32Executed;
+  uint32_t u32Checksum;
+} stc_result_t;
+
+template<typename F> static stc_result_t measure(uint32_t u32Commands, F fn)
+{
+  stc_result_t stcResult;
+  uint32_t i;
+  u32Executed = 0;
+  u32Checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for(i = 0; i < u32Commands; i++)
+  {
+    fn(i);
+  }
+  stcResult.dCommandsPerSecond = u32Commands / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  stcResult.u32Executed = u32Executed;
+  stcResult.u32Checksum = u32Checksum;
+  return stcResult;
+}
+
+static bool report(const char* pcName, const stc_result_t& stcReference, const stc_result_t& stcDispatch)
+{
+  bool bSame = (stcReference.u32Executed == stcDispatch.u32Executed) && (stcReference.u32Checksum == stcDispatch.u32Checksum);
+  printf("%-9s String: %7.2f M commands/s  tables: %7.2f M commands/s  x%.1f%s\n", pcName,
+         stcReference.dCommandsPerSecond / 1e6, stcDispatch.dCommandsPerSecond / 1e6,
+         stcDispatch.dCommandsPerSecond / stcReference.dCommandsPerSecond,
+         bSame ? "" : "  FAIL: different commands executed");
+  return bSame;
+}
+
+int main(int argc, char** argv)
+{
+  uint32_t u32Commands = (argc > 1) ? (uint32_t)atoi(argv[1]) : BENCH_COMMANDS;
+  WebServer server(80);
+  WebServer referenceServer(80);
+  bool bOk = true;
+  stc_result_t stcReference;
+  stc_result_t stcDispatch;
+
+  IrGatewayWebServer_Init(&server, enMaerklin292xxIrAddressA);
+  referenceRoutes(&referenceServer);
+
+  stcReference = measure(u32Commands, [](uint32_t i) {
+    const char** apcCmd = aapcCommands[i % COMMAND_COUNT];
+    referenceProcessCommand(apcCmd[0], apcCmd[1], apcCmd[2]);
+  });
+  stcDispatch = measure(u32Commands, [](uint32_t i) {
+    const char** apcCmd = aapcCommands[i % COMMAND_COUNT];
+    IrGatewayWebServer_ProcessCommand(apcCmd[0], apcCmd[1], apcCmd[2]);
+  });
+  bOk &= report("dispatch", stcReference, stcDispatch);
+  if (u32Forwarded != u32Commands)
+  {
+    printf("FAIL: %u of %u commands forwarded to the peers\n", (unsigned)u32Forwarded, (unsigned)u32Commands);
+    bOk = false;
+  }
+
+  stcReference = measure(u32Commands, [&referenceServer](uint32_t i) {
+    referenceServer.request(HTTP_GET, apcUris[i % URI_COUNT]);
+  });
+  stcDispatch = measure(u32Commands, [&server](uint32_t i) {
+    server.request(HTTP_GET, apcUris[i % URI_COUNT]);
+  });
+  bOk &= report("routes", stcReference, stcDispatch);
+
+  return bOk ? 0 : 1;
+}
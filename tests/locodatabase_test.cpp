@@ -0,0 +1,102 @@
+/**
+ *******************************************************************************
+ **\file locodatabase_test.cpp
+ **
+ ** Test of the locos the database offers to WiThrottle: the roster (RL)
+ ** has only the IR addresses A-D and G-J, these locos have F0-F3, the
+ ** addresses E and F have no functions.
+ **
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <string>
+#include <Arduino.h>
+#include <WiFi.h>
+#include "hoststub.h"
+#include "withrottle/withrottle.h"
+#include "maerklin_ir_gw/locodatabase.h"
+#include "maerklin_ir_gw/maerklin292xxir.h"
+
+#define WITHROTTLE_PORT 2560
+
+static int iErrors = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAIL line %d: ", __LINE__); printf(__VA_ARGS__); printf("\n"); iErrors++; } } while(0)
+
+static void loop(int iCount)
+{
+  int i;
+  for(i = 0; i < iCount; i++)
+  {
+    WiThrottle_Update();
+    Maerklin292xxIr_Update();
+    HostStub_AdvanceMillis(1);
+  }
+}
+
+/*
+ * Get the line starting with pcPrefix
+ */
+static int countFunctions(const std::string& strData, const char* pcLoco)
+{
+  std::string strPrefix = std::string("MTA") + pcLoco + "<;>F";
+  int iCount = 0;
+  size_t u32Pos = 0;
+  while((u32Pos = strData.find(strPrefix, u32Pos)) != std::string::npos)
+  {
+    iCount++;
+    u32Pos++;
+  }
+  return iCount;
+}
+
+static std::string line(const std::string& strData, const char* pcPrefix)
+{
+  size_t u32Start = (strData.compare(0, strlen(pcPrefix), pcPrefix) == 0) ? 0 : strData.find(std::string("\n") + pcPrefix);
+  size_t u32End;
+  if (u32Start == std::string::npos)
+  {
+    return "";
+  }
+  if (strData[u32Start] == '\n')
+  {
+    u32Start++;
+  }
+  u32End = strData.find('\n', u32Start);
+  return strData.substr(u32Start, u32End - u32Start);
+}
+
+int main(void)
+{
+  HostConnectionPtr pConn;
+  std::string strRoster;
+
+  HostStub_SetMillis(1000);
+  Maerklin292xxIr_Init();
+  LocoDatabase_Init();
+  WiThrottle_Init(3);
+
+  pConn = HostStub_Connect(WITHROTTLE_PORT, IPAddress(192,168,4,100));
+  pConn->strRx = "NTest\nHUtest\n";
+  loop(5);
+  strRoster = line(pConn->strTx, "RL");
+  printf("%s\n", strRoster.c_str());
+  CHECK(strRoster == "RL8]\\[Loco A}|{1}|{S]\\[Loco B}|{2}|{S]\\[Loco C}|{3}|{S]\\[Loco D}|{4}|{S"
+                     "]\\[Loco G}|{7}|{S]\\[Loco H}|{8}|{S]\\[Loco I}|{9}|{S]\\[Loco J}|{10}|{S",
+        "roster %s", strRoster.c_str());
+
+  //
+  // F0-F3 with labels for A, nothing for E
+  //
+  pConn->strTx.clear();
+  pConn->strRx = "MT+S1<;>S1\nMT+S5<;>S5\n";
+  loop(5);
+  CHECK(countFunctions(pConn->strTx, "S1") == 4, "%d function states of S1", countFunctions(pConn->strTx, "S1"));
+  CHECK(line(pConn->strTx, "MTLS1<;>") == "MTLS1<;>]\\[Light]\\[Sound 1]\\[Sound 2]\\[Sound 3", "labels of S1 %s", line(pConn->strTx, "MTLS1<;>").c_str());
+  CHECK(countFunctions(pConn->strTx, "S5") == 0, "%d function states of S5", countFunctions(pConn->strTx, "S5"));
+  CHECK(line(pConn->strTx, "MTLS5<;>") == "", "labels of S5 %s", line(pConn->strTx, "MTLS5<;>").c_str());
+
+  printf("%d errors\n", iErrors);
+  return (iErrors == 0) ? 0 : 1;
+}
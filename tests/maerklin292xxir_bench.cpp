@@ -0,0 +1,144 @@
+/**
+ *******************************************************************************
+ **\file maerklin292xxir_bench.cpp
+ **
+ ** Throttle sweep benchmark of the Maerklin292xx IR scheduler.
+ **
+ ** A throttle steps a locomotive A through typical sweeps, every step is sent
+ ** when the frames of the step before are on the air. Reported are speed
+ ** commands per second of IR air time, once with the missing steps only and
+ ** once with Stop + N steps for every change (Maerklin292xxIr_ResyncSpeed()
+ ** before every command, as the gateway did before).
+ **
+ ** Usage: maerklin292xxir_bench [random steps]
+ **
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Arduino.h>
+#include "hoststub.h"
+#include "irtransmitter.h"
+#include "maerklin292xxir.h"
+
+#define UPDATE_STEP_MS 1
+#define COMMAND_TIMEOUT_MS 10000
+
+typedef struct stc_sweep
+{
+  const char* pcName;
+  const int* paiSpeeds;
+  int iCount;
+} stc_sweep_t;
+
+static const int aiRampUp[] = {1, 2, 3, 0};
+static const int aiRampUpDown[] = {1, 2, 3, 2, 1, 0};
+static const int aiReverse[] = {1, 2, 3, 0, -1, -2, -3, 0};
+static const int aiCreep[] = {1, 0, 1, 0, -1, 0, -1, 0};
+
+static const stc_sweep_t astcSweeps[] = {
+  {"ramp up, stop", aiRampUp, sizeof(aiRampUp) / sizeof(aiRampUp[0])},
+  {"ramp up and down", aiRampUpDown, sizeof(aiRampUpDown) / sizeof(aiRampUpDown[0])},
+  {"reverse", aiReverse, sizeof(aiReverse) / sizeof(aiReverse[0])},
+  {"creep", aiCreep, sizeof(aiCreep) / sizeof(aiCreep[0])},
+};
+
+/*
+ * Send one speed command and run the scheduler until its frames are on the air
+ *
+ * \return air time of the command in ms, 0 on timeout
+ */
+static uint32_t runCommand(int iSpeed, bool bResync)
+{
+  uint32_t u32Start = millis();
+  uint32_t u32Frames = HostStub_GetIrFrameCount();
+  if (bResync)
+  {
+    Maerklin292xxIr_ResyncSpeed(enMaerklin292xxIrAddressA);
+  }
+  Maerklin292xxIr_SetSpeed(enMaerklin292xxIrAddressA, iSpeed);
+  while((millis() - u32Start) < COMMAND_TIMEOUT_MS)
+  {
+    Maerklin292xxIr_Update();
+    if ((HostStub_GetIrFrameCount() != u32Frames) && (Maerklin292xxIr_GetQueueCount() == 0) && (!IrTransmitter_IsBusy(0)))
+    {
+      return millis() - u32Start;
+    }
+    HostStub_AdvanceMillis(UPDATE_STEP_MS);
+  }
+  return 0;
+}
+
+/*
+ * Run a sweep, starting and ending with the locomotive stopped
+ *
+ * \return false on timeout
+ */
+static bool runSweep(const char* pcName, const int* paiSpeeds, int iCount, bool bResync)
+{
+  uint32_t u32Frames = HostStub_GetIrFrameCount();
+  uint32_t u32AirTime = 0;
+  uint32_t u32Command;
+  int i;
+  for(i = 0; i < iCount; i++)
+  {
+    u32Command = runCommand(paiSpeeds[i], bResync);
+    if (u32Command == 0)
+    {
+      printf("%s: command %d timed out\n", pcName, i);
+      return false;
+    }
+    u32AirTime += u32Command;
+  }
+  u32Frames = HostStub_GetIrFrameCount() - u32Frames;
+  printf("  %-18s %-13s %3d commands %4u frames %6u ms  %5.2f commands/s\n",
+         pcName, bResync ? "Stop + N" : "missing steps", iCount, u32Frames, u32AirTime, iCount * 1000.0 / u32AirTime);
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  int iRandomSteps = (argc > 1) ? atoi(argv[1]) : 500;
+  int* paiRandom = (int*)malloc(sizeof(int) * (iRandomSteps + 1));
+  int iSpeed = 0;
+  int iMode;
+  int i;
+  unsigned int u32Sweep;
+  bool bOk = true;
+
+  //
+  // random throttle: the slider moves one or two steps, never to the same speed
+  //
+  srand(29200);
+  for(i = 0; i < iRandomSteps; i++)
+  {
+    int iNext;
+    do
+    {
+      iNext = iSpeed + (rand() % 5) - 2;
+    } while((iNext == iSpeed) || (iNext > 3) || (iNext < -3));
+    paiRandom[i] = iNext;
+    iSpeed = iNext;
+  }
+  paiRandom[iRandomSteps] = 0;
+
+  HostStub_SetMillis(1000);
+  Maerklin292xxIr_Init();
+
+  for(iMode = 0; iMode < 2; iMode++)
+  {
+    bool bResync = (iMode == 1);
+    uint32_t u32Start = HostStub_GetIrFrameCount();
+    printf("%s:\n", bResync ? "Stop + N steps for every change" : "missing steps only");
+    for(u32Sweep = 0; u32Sweep < sizeof(astcSweeps) / sizeof(astcSweeps[0]); u32Sweep++)
+    {
+      bOk &= runSweep(astcSweeps[u32Sweep].pcName, astcSweeps[u32Sweep].paiSpeeds, astcSweeps[u32Sweep].iCount, bResync);
+    }
+    bOk &= runSweep("random throttle", paiRandom, iRandomSteps + 1, bResync);
+    printf("  %u frames\n", HostStub_GetIrFrameCount() - u32Start);
+  }
+
+  free(paiRandom);
+  return bOk ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+/**
+ *******************************************************************************
+ **\file maerklin292xxirframe_bench.cpp
+ **
+ ** Encodes per second of the Maerklin292xx IR frame encoding, and frames per
+ ** second taken from the frame cache.
+ **
+ ** Usage: irframe_bench [rounds]
+ **
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "maerklin292xxirframe.h"
+
+int main(int argc, char** argv)
+{
+  uint16_t au16Timings[MAERKLIN292XXIR_FRAME_MAX_LEN];
+  long lRounds = (argc > 1) ? atol(argv[1]) : 2000;
+  unsigned long u32Encodes = 0;
+  unsigned long u32Gets = 0;
+  unsigned long u32Sum = 0;
+  double dSeconds;
+  long round;
+  int slot;
+  int fn;
+
+  Maerklin292xxIrFrame_Init();
+
+  auto start = std::chrono::steady_clock::now();
+  for(round = 0; round < lRounds; round++)
+  {
+    for(slot = 0; slot < MAERKLIN292XXIR_ADDRESS_COUNT; slot++)
+    {
+      en_maerklin_292xx_ir_address_t enAddress = Maerklin292xxIrFrame_GetAddress(slot);
+      for(fn = 0; fn < 0x80; fn++)
+      {
+        uint8_t u8Len = Maerklin292xxIrFrame_Encode(enAddress, (uint8_t)fn, (round & 1) != 0, au16Timings);
+        u32Sum += u8Len ? au16Timings[u8Len - 1] : 0;
+        u32Encodes++;
+      }
+    }
+  }
+  dSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%lu encodes in %.3f s: %.0f encodes/s (checksum %lu)\n", u32Encodes, dSeconds, u32Encodes / dSeconds, u32Sum);
+
+  u32Sum = 0;
+  start = std::chrono::steady_clock::now();
+  for(round = 0; round < lRounds; round++)
+  {
+    for(slot = 0; slot < MAERKLIN292XXIR_ADDRESS_COUNT; slot++)
+    {
+      en_maerklin_292xx_ir_address_t enAddress = Maerklin292xxIrFrame_GetAddress(slot);
+      for(fn = 0; fn < 0x80; fn++)
+      {
+        uint8_t u8Len;
+        const uint16_t* pu16Frame = Maerklin292xxIrFrame_Get(enAddress, (uint8_t)fn, (round & 1) != 0, &u8Len);
+        u32Sum += u8Len ? pu16Frame[u8Len - 1] : 0;
+        u32Gets++;
+      }
+    }
+  }
+  dSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%lu cached frames in %.3f s: %.0f frames/s (checksum %lu)\n", u32Gets, dSeconds, u32Gets / dSeconds, u32Sum);
+  return ((u32Encodes > 0) && (u32Gets > 0)) ? 0 : 1;
+}
@@ -0,0 +1,56 @@
+/**
+ *******************************************************************************
+ **\file maerklin292xxirframe_cache_test.cpp
+ **
+ ** Frame cache test of the Maerklin292xx IR frame encoding.
+ **
+ ** Every frame returned by Maerklin292xxIrFrame_Get() has to be the same,
+ ** byte for byte, as the one Maerklin292xxIrFrame_Encode() builds.
+ **
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "maerklin292xxirframe.h"
+
+int main(void)
+{
+  uint16_t au16Timings[MAERKLIN292XXIR_FRAME_MAX_LEN];
+  const uint16_t* pu16Frame;
+  int iFrames = 0;
+  int iErrors = 0;
+  int slot;
+  int fn;
+  int toggle;
+
+  Maerklin292xxIrFrame_Init();
+
+  for(slot = 0; slot < MAERKLIN292XXIR_ADDRESS_COUNT; slot++)
+  {
+    en_maerklin_292xx_ir_address_t enAddress = Maerklin292xxIrFrame_GetAddress(slot);
+    for(fn = 0; fn < 0x80; fn++)
+    {
+      for(toggle = 0; toggle < 2; toggle++)
+      {
+        uint8_t u8Len;
+        uint8_t u8EncodedLen;
+        memset(au16Timings, 0xff, sizeof(au16Timings));
+        u8EncodedLen = Maerklin292xxIrFrame_Encode(enAddress, (uint8_t)fn, toggle != 0, au16Timings);
+        pu16Frame = Maerklin292xxIrFrame_Get(enAddress, (uint8_t)fn, toggle != 0, &u8Len);
+        if ((u8Len != u8EncodedLen) || (memcmp(pu16Frame, au16Timings, u8Len * sizeof(uint16_t)) != 0))
+        {
+          if (iErrors < 20)
+          {
+            printf("mismatch slot %d function %02x toggle %d: cached %u timings, encoded %u\n", slot, fn, toggle, u8Len, u8EncodedLen);
+          }
+          iErrors++;
+        }
+        iFrames++;
+      }
+    }
+  }
+
+  printf("%d frames, %d errors\n", iFrames, iErrors);
+  return (iErrors == 0) ? 0 : 1;
+}
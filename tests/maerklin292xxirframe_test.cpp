@@ -0,0 +1,149 @@
+/**
+ *******************************************************************************
+ **\file maerklin292xxirframe_test.cpp
+ **
+ ** Golden vector test of the Maerklin292xx IR frame encoding.
+ **
+ ** Every address, function and toggle bit is encoded and compared
+ ** timing by timing with the frames recorded from the original encoder.
+ **
+ ** Usage: irframe_test <golden file>
+ **
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "maerklin292xxirframe.h"
+
+#define MAX_ERRORS_PRINTED 20
+
+static en_maerklin_292xx_ir_address_t addressFromLetter(char c)
+{
+  if ((c >= 'A') && (c <= 'D'))
+  {
+    return (en_maerklin_292xx_ir_address_t)(enMaerklin292xxIrAddressA + (c - 'A'));
+  }
+  return (en_maerklin_292xx_ir_address_t)(enMaerklin292xxIrAddressG + (c - 'G'));
+}
+
+static void printFrame(const char* pcName, const uint16_t* pu16Timings, int len)
+{
+  int i;
+  printf("  %s (%d):", pcName, len);
+  for(i = 0; i < len; i++)
+  {
+    printf(" %u", pu16Timings[i]);
+  }
+  printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+  FILE* pFile;
+  char acLine[1024];
+  bool abSeen[MAERKLIN292XXIR_ADDRESS_COUNT][0x80][2];
+  int iVectors = 0;
+  int iErrors = 0;
+  int slot;
+  int fn;
+  int toggle;
+
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s <golden file>\n", argv[0]);
+    return 2;
+  }
+  pFile = fopen(argv[1], "r");
+  if (pFile == NULL)
+  {
+    fprintf(stderr, "cannot open %s\n", argv[1]);
+    return 2;
+  }
+
+  Maerklin292xxIrFrame_Init();
+  memset(abSeen, 0, sizeof(abSeen));
+
+  while(fgets(acLine, sizeof(acLine), pFile) != NULL)
+  {
+    uint16_t au16Expected[MAERKLIN292XXIR_FRAME_MAX_LEN];
+    uint16_t au16Timings[MAERKLIN292XXIR_FRAME_MAX_LEN];
+    en_maerklin_292xx_ir_address_t enAddress;
+    char cAddress;
+    unsigned int u32Function;
+    int iToggle;
+    int iCount;
+    int iLen;
+    int i;
+    char* pcPos;
+
+    if ((acLine[0] == '#') || (acLine[0] == '\n'))
+    {
+      continue;
+    }
+    if (sscanf(acLine, " %c %x %d %d", &cAddress, &u32Function, &iToggle, &iCount) != 4)
+    {
+      fprintf(stderr, "malformed line: %s", acLine);
+      return 2;
+    }
+    enAddress = addressFromLetter(cAddress);
+    slot = Maerklin292xxIrFrame_GetSlot(enAddress);
+    if ((slot < 0) || (u32Function >= 0x80) || (iCount > MAERKLIN292XXIR_FRAME_MAX_LEN))
+    {
+      fprintf(stderr, "invalid vector: %s", acLine);
+      return 2;
+    }
+
+    //
+    // skip the four header fields, then read the timings
+    //
+    pcPos = acLine;
+    for(i = 0; i < 4; i++)
+    {
+      while(*pcPos == ' ') pcPos++;
+      while((*pcPos != ' ') && (*pcPos != '\n') && (*pcPos != '\0')) pcPos++;
+    }
+    for(i = 0; i < iCount; i++)
+    {
+      au16Expected[i] = (uint16_t)strtoul(pcPos, &pcPos, 10);
+    }
+
+    memset(au16Timings, 0xff, sizeof(au16Timings));
+    iLen = Maerklin292xxIrFrame_Encode(enAddress, (uint8_t)u32Function, iToggle != 0, au16Timings);
+    if ((iLen != iCount) || (memcmp(au16Timings, au16Expected, iCount * sizeof(uint16_t)) != 0))
+    {
+      if (iErrors < MAX_ERRORS_PRINTED)
+      {
+        printf("mismatch %c %02x toggle %d\n", cAddress, u32Function, iToggle);
+        printFrame("expected", au16Expected, iCount);
+        printFrame("encoded ", au16Timings, iLen);
+      }
+      iErrors++;
+    }
+    abSeen[slot][u32Function][iToggle != 0] = true;
+    iVectors++;
+  }
+  fclose(pFile);
+
+  //
+  // the golden file has to cover the whole input space
+  //
+  for(slot = 0; slot < MAERKLIN292XXIR_ADDRESS_COUNT; slot++)
+  {
+    for(fn = 0; fn < 0x80; fn++)
+    {
+      for(toggle = 0; toggle < 2; toggle++)
+      {
+        if (!abSeen[slot][fn][toggle])
+        {
+          printf("no golden vector for slot %d function %02x toggle %d\n", slot, fn, toggle);
+          iErrors++;
+        }
+      }
+    }
+  }
+
+  printf("%d vectors, %d errors\n", iVectors, iErrors);
+  return (iErrors == 0) ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+/**
+ *******************************************************************************
+ **\file Arduino.h
+ **
+ ** Host stub of the Arduino core, just enough to build the gateway modules
+ ** on Linux. Time and network are controlled by the tests, see hoststub.h
+ **
+ *******************************************************************************
+ */
+
+#if !defined(__HOSTSTUB_ARDUINO_H__)
+#define __HOSTSTUB_ARDUINO_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string>
+
+typedef uint8_t byte;
+
+#define HEX 16
+#define DEC 10
+#define INPUT 0
+#define OUTPUT 1
+#define LOW 0
+#define HIGH 1
+#define PROGMEM
+#define IRAM_ATTR
+#define memcpy_P memcpy
+
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t u32Ms);
+void yield(void);
+void pinMode(uint8_t u8Pin, uint8_t u8Mode);
+void digitalWrite(uint8_t u8Pin, uint8_t u8Value);
+
+/**
+ * Arduino String, every copy owns its own buffer like the cores
+ */
+class String
+{
+public:
+  String(const char* pcText = "") : str(pcText ? pcText : "") {}
+  const char* c_str(void) const { return str.c_str(); }
+  unsigned int length(void) const { return (unsigned int)str.size(); }
+  char charAt(unsigned int index) const { return (index < str.size()) ? str[index] : 0; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  long toInt(void) const { return atol(str.c_str()); }
+  bool operator==(const char* pcText) const { return str == (pcText ? pcText : ""); }
+  bool operator!=(const char* pcText) const { return !(*this == pcText); }
+  bool operator==(const String& other) const { return str == other.str; }
+  bool operator!=(const String& other) const { return str != other.str; }
+  String& operator+=(const char* pcText) { str += pcText; return *this; }
+private:
+  std::string str;
+};
+
+class Print;
+
+class Printable
+{
+public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t u8Data);
+  virtual size_t write(const uint8_t* pu8Data, size_t n);
+  size_t write(const char* pcData, size_t n) { return write((const uint8_t*)pcData, n); }
+  size_t print(const char* pcText);
+  size_t print(char c);
+  size_t print(int i, int base = DEC);
+  size_t print(unsigned int u, int base = DEC);
+  size_t print(long l, int base = DEC);
+  size_t print(unsigned long u, int base = DEC);
+  size_t print(const Printable& printable);
+  size_t print(const String& text) { return print(text.c_str()); }
+  size_t println(void);
+  size_t println(const char* pcText);
+  size_t println(char c);
+  size_t println(int i, int base = DEC);
+  size_t println(unsigned int u, int base = DEC);
+  size_t println(long l, int base = DEC);
+  size_t println(unsigned long u, int base = DEC);
+  size_t println(const Printable& printable);
+  size_t println(const String& text) { return println(text.c_str()); }
+  size_t printf(const char* format, ...);
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available(void) { return 0; }
+  virtual int read(void) { return -1; }
+};
+
+class HardwareSerial : public Stream
+{
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  size_t write(uint8_t u8Data) override;
+  size_t write(const uint8_t* pu8Data, size_t n) override;
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+/**
+ * IPv4 address, stored in network order like the Arduino cores:
+ * the first octet is the lowest byte of the uint32_t
+ */
+class IPAddress : public Printable
+{
+public:
+  IPAddress(void) : u32Address(0) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : u32Address((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24)) {}
+  IPAddress(uint32_t u32Raw) : u32Address(u32Raw) {}
+  bool fromString(const char* pcAddress);
+  operator uint32_t() const { return u32Address; }
+  uint8_t operator[](int index) const { return (uint8_t)(u32Address >> (8 * index)); }
+  size_t printTo(Print& p) const override;
+private:
+  uint32_t u32Address;
+};
+
+class ESPClass
+{
+public:
+  uint32_t getFreeHeap(void);
+};
+
+extern ESPClass ESP;
+
+class RP2040Class
+{
+public:
+  uint32_t getFreeHeap(void);
+  uint32_t hwrand32(void);
+};
+
+extern RP2040Class rp2040;
+
+uint32_t esp_random(void);
+
+#endif /* __HOSTSTUB_ARDUINO_H__ */
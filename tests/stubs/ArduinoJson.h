@@ -0,0 +1,61 @@
+/**
+ *******************************************************************************
+ **\file ArduinoJson.h
+ **
+ ** Host stub of ArduinoJson, only lets irgatewaywebserver.cpp build:
+ ** documents stay empty, POST /api/cmd is not covered on the host
+ **
+ *******************************************************************************
+ */
+
+#if !defined(__HOSTSTUB_ARDUINOJSON_H__)
+#define __HOSTSTUB_ARDUINOJSON_H__
+
+#include <Arduino.h>
+
+class JsonArray;
+
+class JsonVariant
+{
+public:
+  template<typename T> T as(void) const { return T(); }
+  template<typename T> bool is(void) const { return false; }
+  operator const char*() const { return NULL; }
+  operator int() const { return 0; }
+  JsonVariant operator[](const char* pcKey) const { (void)pcKey; return JsonVariant(); }
+  bool containsKey(const char* pcKey) const { (void)pcKey; return false; }
+  bool isNull(void) const { return true; }
+  template<typename T> bool operator==(const T& value) const { (void)value; return false; }
+};
+
+class JsonArray : public JsonVariant
+{
+public:
+  size_t size(void) const { return 0; }
+  const JsonVariant* begin(void) const { return NULL; }
+  const JsonVariant* end(void) const { return NULL; }
+};
+
+class JsonDocument : public JsonVariant
+{
+public:
+  JsonVariant operator[](const char* pcKey) { (void)pcKey; return JsonVariant(); }
+};
+
+template<size_t N> class StaticJsonDocument : public JsonDocument
+{
+};
+
+struct DeserializationError
+{
+  operator bool() const { return false; }
+};
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const String& json)
+{
+  (void)doc;
+  (void)json;
+  return DeserializationError();
+}
+
+#endif /* __HOSTSTUB_ARDUINOJSON_H__ */
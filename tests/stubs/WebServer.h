@@ -0,0 +1,74 @@
+/**
+ *******************************************************************************
+ **\file WebServer.h
+ **
+ ** Host stub of the WebServer of the ESP32 and RP2040 cores. There is no
+ ** socket, requests are passed in by HostStub_HttpRequest()
+ **
+ *******************************************************************************
+ */
+
+#if !defined(__HOSTSTUB_WEBSERVER_H__)
+#define __HOSTSTUB_WEBSERVER_H__
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+typedef enum
+{
+  HTTP_ANY,
+  HTTP_GET,
+  HTTP_POST,
+} HTTPMethod;
+
+class WebServer
+{
+public:
+  typedef std::function<void(void)> THandlerFunction;
+
+  WebServer(int port = 80) { (void)port; }
+  void begin(void) {}
+  void handleClient(void) {}
+
+  /**
+   * Register a handler, "{}" matches one path segment like UriBraces
+   */
+  void on(const char* pcUri, THandlerFunction fn) { on(pcUri, HTTP_ANY, fn); }
+  void on(const char* pcUri, HTTPMethod method, THandlerFunction fn);
+
+  HTTPMethod method(void) { return enMethod; }
+  bool hasArg(const char* pcName);
+  String arg(const char* pcName);
+  String arg(int index);
+  int args(void) { return 0; }
+  String pathArg(unsigned int index) { return String((index < pathArgs.size()) ? pathArgs[index].c_str() : ""); }
+  void send(int code, const char* pcContentType, const char* pcContent);
+  void send(int code, const char* pcContentType, const String& content) { send(code, pcContentType, content.c_str()); }
+
+  /**
+   * Host side: execute a request, returns the status code, 404 without
+   * matching handler
+   */
+  int request(HTTPMethod method, const char* pcUri, const char* pcBody = "", std::string* pstrResponse = NULL);
+
+private:
+  struct Route
+  {
+    std::string strUri;
+    HTTPMethod method;
+    THandlerFunction fn;
+  };
+  bool match(const std::string& strRoute, const char* pcUri);
+
+  std::vector<Route> routes;
+  std::vector<std::string> pathArgs;
+  HTTPMethod enMethod = HTTP_GET;
+  std::string strBody;
+  int iCode = 0;
+  std::string* pstrResponse = NULL;
+};
+
+#endif /* __HOSTSTUB_WEBSERVER_H__ */
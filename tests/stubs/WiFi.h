@@ -0,0 +1,70 @@
+/**
+ *******************************************************************************
+ **\file WiFi.h
+ **
+ ** Host stub of the WiFi library, TCP connections are HostConnection pipes
+ ** controlled by the tests, see hoststub.h
+ **
+ *******************************************************************************
+ */
+
+#if !defined(__HOSTSTUB_WIFI_H__)
+#define __HOSTSTUB_WIFI_H__
+
+#include <Arduino.h>
+#include "hoststub.h"
+
+#define WL_CONNECTED 3
+
+class WiFiClient : public Stream
+{
+public:
+  WiFiClient(void) {}
+  WiFiClient(HostConnectionPtr pConn) : pConnection(pConn) {}
+  operator bool(void) const { return (pConnection != NULL); }
+  int connect(IPAddress ip, uint16_t u16Port);
+  int connect(IPAddress ip, uint16_t u16Port, int32_t i32TimeoutMs);
+  int connect(const char* pcHost, uint16_t u16Port);
+  uint8_t connected(void);
+  void stop(void);
+  int available(void) override;
+  int read(void) override;
+  int read(uint8_t* pu8Buffer, size_t n);
+  size_t write(uint8_t u8Data) override;
+  size_t write(const uint8_t* pu8Data, size_t n) override;
+  using Print::write;
+  int availableForWrite(void);
+  void flush(void) {}
+  void setNoDelay(bool bNoDelay) { (void)bNoDelay; }
+  void setTimeout(uint32_t u32TimeoutMs) { (void)u32TimeoutMs; }
+  IPAddress remoteIP(void) const;
+  uint16_t remotePort(void) const;
+  int fd(void) const { return -1; }
+private:
+  HostConnectionPtr pConnection;
+};
+
+class WiFiServer
+{
+public:
+  WiFiServer(uint16_t u16Port) : u16Port(u16Port) {}
+  void begin(void) {}
+  void setNoDelay(bool bNoDelay) { (void)bNoDelay; }
+  bool hasClient(void);
+  WiFiClient available(void);
+  WiFiClient accept(void) { return available(); }
+private:
+  uint16_t u16Port;
+};
+
+class WiFiClass
+{
+public:
+  IPAddress localIP(void);
+  int status(void) { return WL_CONNECTED; }
+  void setHostname(const char* pcName) { (void)pcName; }
+};
+
+extern WiFiClass WiFi;
+
+#endif /* __HOSTSTUB_WIFI_H__ */
@@ -0,0 +1,10 @@
+/**
+ *******************************************************************************
+ **\file WiFiClient.h
+ **
+ ** Host stub, WiFiClient is declared in WiFi.h
+ **
+ *******************************************************************************
+ */
+
+#include <WiFi.h>
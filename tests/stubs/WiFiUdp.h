@@ -0,0 +1,52 @@
+/**
+ *******************************************************************************
+ **\file WiFiUdp.h
+ **
+ ** Host stub of WiFiUDP on POSIX sockets. Multicast groups are joined and
+ ** sent on the loopback interface, several gateway processes on one host
+ ** receive each other
+ **
+ *******************************************************************************
+ */
+
+#if !defined(__HOSTSTUB_WIFIUDP_H__)
+#define __HOSTSTUB_WIFIUDP_H__
+
+#include <Arduino.h>
+
+#define HOSTSTUB_UDP_PACKET_SIZE 1500
+
+class WiFiUDP
+{
+public:
+  ~WiFiUDP() { stop(); }
+  uint8_t begin(uint16_t u16Port);
+  uint8_t beginMulticast(IPAddress group, uint16_t u16Port);
+  uint8_t beginMulticast(IPAddress interfaceAddr, IPAddress group, uint16_t u16Port) { (void)interfaceAddr; return beginMulticast(group, u16Port); }
+  void stop(void);
+  int beginPacket(IPAddress ip, uint16_t u16Port);
+  size_t write(uint8_t u8Data) { return write(&u8Data, 1); }
+  size_t write(const uint8_t* pu8Data, size_t n);
+  int endPacket(void);
+  int parsePacket(void);
+  int available(void) { return i32RxLen - i32RxPos; }
+  int read(void);
+  int read(uint8_t* pu8Buffer, size_t n);
+  IPAddress remoteIP(void) { return IPAddress(u32RemoteIp); }
+  uint16_t remotePort(void) { return u16RemotePort; }
+private:
+  bool open(uint16_t u16Port);
+
+  int fd = -1;
+  uint8_t au8Rx[HOSTSTUB_UDP_PACKET_SIZE];
+  int i32RxLen = 0;
+  int i32RxPos = 0;
+  uint32_t u32RemoteIp = 0;
+  uint16_t u16RemotePort = 0;
+  uint8_t au8Tx[HOSTSTUB_UDP_PACKET_SIZE];
+  int i32TxLen = 0;
+  uint32_t u32TxIp = 0;
+  uint16_t u16TxPort = 0;
+};
+
+#endif /* __HOSTSTUB_WIFIUDP_H__ */
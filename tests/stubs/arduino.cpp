@@ -0,0 +1,285 @@
+/**
+ *******************************************************************************
+ **\file arduino.cpp
+ **
+ ** Host stub of the Arduino core
+ **
+ *******************************************************************************
+ */
+
+#include <Arduino.h>
+#include <time.h>
+#include "hoststub.h"
+
+HardwareSerial Serial;
+ESPClass ESP;
+RP2040Class rp2040;
+
+static bool bRealTime = false;
+static uint32_t u32TestMillis = 0;
+static bool bSerialOutput = false;
+static uint32_t u32FreeHeap = 200000;
+
+void HostStub_UseRealTime(bool bEnable)
+{
+  bRealTime = bEnable;
+}
+
+void HostStub_SetMillis(uint32_t u32Ms)
+{
+  u32TestMillis = u32Ms;
+}
+
+void HostStub_AdvanceMillis(uint32_t u32Ms)
+{
+  u32TestMillis += u32Ms;
+}
+
+void HostStub_SetSerialOutput(bool bEnable)
+{
+  bSerialOutput = bEnable;
+}
+
+void HostStub_SetFreeHeap(uint32_t u32Bytes)
+{
+  u32FreeHeap = u32Bytes;
+}
+
+static uint64_t monotonicUs(void)
+{
+  struct timespec stcNow;
+  clock_gettime(CLOCK_MONOTONIC, &stcNow);
+  return (uint64_t)stcNow.tv_sec * 1000000ull + (uint64_t)(stcNow.tv_nsec / 1000);
+}
+
+uint32_t millis(void)
+{
+  if (bRealTime)
+  {
+    return (uint32_t)(monotonicUs() / 1000);
+  }
+  return u32TestMillis;
+}
+
+uint32_t micros(void)
+{
+  if (bRealTime)
+  {
+    return (uint32_t)monotonicUs();
+  }
+  return u32TestMillis * 1000;
+}
+
+void delay(uint32_t u32Ms)
+{
+  if (bRealTime)
+  {
+    struct timespec stcDelay = { (time_t)(u32Ms / 1000), (long)(u32Ms % 1000) * 1000000L };
+    nanosleep(&stcDelay, NULL);
+  } else
+  {
+    u32TestMillis += u32Ms;
+  }
+}
+
+void yield(void)
+{
+}
+
+void pinMode(uint8_t u8Pin, uint8_t u8Mode)
+{
+  (void)u8Pin;
+  (void)u8Mode;
+}
+
+void digitalWrite(uint8_t u8Pin, uint8_t u8Value)
+{
+  (void)u8Pin;
+  (void)u8Value;
+}
+
+uint32_t ESPClass::getFreeHeap(void)
+{
+  return u32FreeHeap;
+}
+
+uint32_t RP2040Class::getFreeHeap(void)
+{
+  return u32FreeHeap;
+}
+
+uint32_t RP2040Class::hwrand32(void)
+{
+  return esp_random();
+}
+
+uint32_t esp_random(void)
+{
+  static uint32_t u32State = 0;
+  if (u32State == 0)
+  {
+    u32State = (uint32_t)monotonicUs() | 1;
+  }
+  u32State ^= u32State << 13;
+  u32State ^= u32State >> 17;
+  u32State ^= u32State << 5;
+  return u32State;
+}
+
+/**
+ *******************************************************************************
+ ** Print
+ *******************************************************************************
+ */
+
+size_t Print::write(uint8_t u8Data)
+{
+  return write(&u8Data, 1);
+}
+
+size_t Print::write(const uint8_t* pu8Data, size_t n)
+{
+  (void)pu8Data;
+  return n;
+}
+
+size_t Print::print(const char* pcText)
+{
+  return write((const uint8_t*)pcText, strlen(pcText));
+}
+
+size_t Print::print(char c)
+{
+  return write((uint8_t)c);
+}
+
+size_t Print::print(long l, int base)
+{
+  char acText[24];
+  if (base == HEX)
+  {
+    snprintf(acText, sizeof(acText), "%lX", (unsigned long)l);
+  } else
+  {
+    snprintf(acText, sizeof(acText), "%ld", l);
+  }
+  return print(acText);
+}
+
+size_t Print::print(unsigned long u, int base)
+{
+  char acText[24];
+  snprintf(acText, sizeof(acText), (base == HEX) ? "%lX" : "%lu", u);
+  return print(acText);
+}
+
+size_t Print::print(int i, int base)
+{
+  return print((long)i, base);
+}
+
+size_t Print::print(unsigned int u, int base)
+{
+  return print((unsigned long)u, base);
+}
+
+size_t Print::print(const Printable& printable)
+{
+  return printable.printTo(*this);
+}
+
+size_t Print::println(void)
+{
+  return print("\r\n");
+}
+
+size_t Print::println(const char* pcText)
+{
+  return print(pcText) + println();
+}
+
+size_t Print::println(char c)
+{
+  return print(c) + println();
+}
+
+size_t Print::println(int i, int base)
+{
+  return print(i, base) + println();
+}
+
+size_t Print::println(unsigned int u, int base)
+{
+  return print(u, base) + println();
+}
+
+size_t Print::println(long l, int base)
+{
+  return print(l, base) + println();
+}
+
+size_t Print::println(unsigned long u, int base)
+{
+  return print(u, base) + println();
+}
+
+size_t Print::println(const Printable& printable)
+{
+  return print(printable) + println();
+}
+
+size_t Print::printf(const char* format, ...)
+{
+  char acText[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(acText, sizeof(acText), format, args);
+  va_end(args);
+  return print(acText);
+}
+
+size_t HardwareSerial::write(uint8_t u8Data)
+{
+  return write(&u8Data, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* pu8Data, size_t n)
+{
+  if (bSerialOutput)
+  {
+    fwrite(pu8Data, 1, n, stdout);
+  }
+  return n;
+}
+
+/**
+ *******************************************************************************
+ ** IPAddress
+ *******************************************************************************
+ */
+
+bool IPAddress::fromString(const char* pcAddress)
+{
+  unsigned int au32Octets[4];
+  char cEnd;
+  int i;
+  if (sscanf(pcAddress, "%u.%u.%u.%u%c", &au32Octets[0], &au32Octets[1], &au32Octets[2], &au32Octets[3], &cEnd) != 4)
+  {
+    return false;
+  }
+  u32Address = 0;
+  for(i = 0; i < 4; i++)
+  {
+    if (au32Octets[i] > 255)
+    {
+      return false;
+    }
+    u32Address |= au32Octets[i] << (8 * i);
+  }
+  return true;
+}
+
+size_t IPAddress::printTo(Print& p) const
+{
+  return p.printf("%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+}
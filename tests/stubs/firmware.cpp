@@ -0,0 +1,99 @@
+/**
+ *******************************************************************************
+ **\file firmware.cpp
+ **
+ ** Host stubs of the gateway modules which are not built for the host
+ **
+ *******************************************************************************
+ */
+
+#include <Arduino.h>
+#include "hoststub.h"
+#include "appconfig.h"
+#include "userledbutton.h"
+#include "wifimcu/wifimcuctrl.h"
+#include "maerklin_ir_gw/irgatewaywebsocket.h"
+
+static char acIrEmitterMap[32] = "11111111";
+static uint32_t u32KeepAlives = 0;
+static uint32_t u32LocoChanges = 0;
+
+void HostStub_SetIrEmitterMap(const char* pcMap)
+{
+  strncpy(acIrEmitterMap, pcMap, sizeof(acIrEmitterMap) - 1);
+}
+
+/**
+ *******************************************************************************
+ ** AppConfig, IR LEDs 1-4 on GPIO 1-4
+ *******************************************************************************
+ */
+
+int32_t AppConfig_GetGpioIr(void)
+{
+  return 1;
+}
+
+int32_t AppConfig_GetGpioIr2(void)
+{
+  return 2;
+}
+
+int32_t AppConfig_GetGpioIr3(void)
+{
+  return 3;
+}
+
+int32_t AppConfig_GetGpioIr4(void)
+{
+  return 4;
+}
+
+const char* AppConfig_GetIrEmitterMap(void)
+{
+  return acIrEmitterMap;
+}
+
+/**
+ *******************************************************************************
+ ** UserLedButton
+ *******************************************************************************
+ */
+
+void UserLedButton_SetLed(bool onoff)
+{
+  (void)onoff;
+}
+
+/**
+ *******************************************************************************
+ ** WifiMcuCtrl
+ *******************************************************************************
+ */
+
+void WifiMcuCtrl_KeepAlive(void)
+{
+  u32KeepAlives++;
+}
+
+uint32_t HostStub_GetKeepAliveCount(void)
+{
+  return u32KeepAlives;
+}
+
+/**
+ *******************************************************************************
+ ** IrGatewayWebSocket
+ *******************************************************************************
+ */
+
+void IrGatewayWebSocket_LocoChanged(uint32_t u32Address)
+{
+  (void)u32Address;
+  u32LocoChanges++;
+}
+
+uint32_t HostStub_GetLocoChangedCount(void)
+{
+  return u32LocoChanges;
+}
@@ -0,0 +1,109 @@
+/**
+ *******************************************************************************
+ **\file hoststub.h
+ **
+ ** Control of the host stubs by the tests: time, heap, IR transmitter and
+ ** configuration of the gateway
+ **
+ *******************************************************************************
+ */
+
+#if !defined(__HOSTSTUB_H__)
+#define __HOSTSTUB_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <memory>
+#include <string>
+#include <functional>
+
+class IPAddress;
+
+/**
+ *******************************************************************************
+ ** Time
+ *******************************************************************************
+ */
+
+/**
+ * millis() follows the test clock by default, set and advanced by the test.
+ * With real time it follows the monotonic clock of the host.
+ */
+void HostStub_UseRealTime(bool bRealTime);
+void HostStub_SetMillis(uint32_t u32Ms);
+void HostStub_AdvanceMillis(uint32_t u32Ms);
+
+/**
+ *******************************************************************************
+ ** System
+ *******************************************************************************
+ */
+
+void HostStub_SetSerialOutput(bool bEnable);
+void HostStub_SetFreeHeap(uint32_t u32Bytes);
+
+/**
+ *******************************************************************************
+ ** IR transmitter, a frame is busy for its air time on the test clock
+ *******************************************************************************
+ */
+
+typedef void (*pfn_hoststub_ir_frame_callback_t)(uint8_t u8Channel, const uint16_t* pu16Timings, uint8_t u8Len);
+
+void HostStub_SetIrFrameCallback(pfn_hoststub_ir_frame_callback_t pfnCallback);
+uint32_t HostStub_GetIrFrameCount(void);
+
+/**
+ *******************************************************************************
+ ** Configuration
+ *******************************************************************************
+ */
+
+void HostStub_SetIrEmitterMap(const char* pcMap);
+
+/**
+ *******************************************************************************
+ ** Network, TCP connections are in-memory pipes between the gateway and the test
+ *******************************************************************************
+ */
+
+struct HostConnection
+{
+  uint32_t u32RemoteIp = 0;
+  uint16_t u16Port = 0;
+  std::string strRx;               ///< data waiting to be read by the gateway
+  std::string strTx;               ///< data written by the gateway
+  size_t u32ReadChunk = 1460;      ///< max. bytes returned by one read(), like one TCP segment
+  size_t u32TxWindow = 5744;       ///< returned by availableForWrite()
+  bool bConnected = true;          ///< cleared when one side closes the connection
+  bool bStopped = false;           ///< gateway called stop()
+  std::function<void(HostConnection*)> pfnOnWrite; ///< called after the gateway wrote data
+};
+
+typedef std::shared_ptr<HostConnection> HostConnectionPtr;
+
+/**
+ * Connect a client to a WiFiServer of the gateway, the connection is
+ * accepted by the next hasClient() / available() of the server
+ */
+HostConnectionPtr HostStub_Connect(uint16_t u16Port, uint32_t u32RemoteIp);
+
+/**
+ * Called by WiFiClient::connect() of the gateway, returns the connection
+ * or NULL if the connect fails
+ */
+void HostStub_SetConnectHandler(std::function<HostConnectionPtr(uint32_t u32Ip, uint16_t u16Port)> pfnHandler);
+
+void HostStub_SetLocalIp(uint32_t u32Ip);
+
+/**
+ *******************************************************************************
+ ** Gateway modules
+ *******************************************************************************
+ */
+
+uint32_t HostStub_GetKeepAliveCount(void);
+uint32_t HostStub_GetLocoChangedCount(void);
+
+#endif /* __HOSTSTUB_H__ */
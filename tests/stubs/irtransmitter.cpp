@@ -0,0 +1,100 @@
+/**
+ *******************************************************************************
+ **\file irtransmitter.cpp
+ **
+ ** Host stub of the IR transmitter, a frame is busy for its air time on the
+ ** clock of millis() like the non-blocking RMT / PIO transmitters
+ **
+ *******************************************************************************
+ */
+
+#include <Arduino.h>
+#include "irtransmitter.h"
+#include "maerklin292xxirframe.h"
+#include "hoststub.h"
+
+static bool abInitDone[IRTRANSMITTER_MAX_CHANNELS];
+static bool abPending[IRTRANSMITTER_MAX_CHANNELS];
+static uint32_t au32Start[IRTRANSMITTER_MAX_CHANNELS];
+static uint32_t au32AirTimeMs[IRTRANSMITTER_MAX_CHANNELS];
+static pfn_irtransmitter_done_callback_t pfnDoneCallback = NULL;
+static pfn_hoststub_ir_frame_callback_t pfnFrameCallback = NULL;
+static uint32_t u32Frames = 0;
+
+void HostStub_SetIrFrameCallback(pfn_hoststub_ir_frame_callback_t pfnCallback)
+{
+  pfnFrameCallback = pfnCallback;
+}
+
+uint32_t HostStub_GetIrFrameCount(void)
+{
+  return u32Frames;
+}
+
+bool IrTransmitter_Init(uint8_t u8Channel, int32_t i32Gpio)
+{
+  if ((u8Channel >= IRTRANSMITTER_MAX_CHANNELS) || (i32Gpio < 0))
+  {
+    return false;
+  }
+  abInitDone[u8Channel] = true;
+  abPending[u8Channel] = false;
+  return true;
+}
+
+bool IrTransmitter_Send(uint8_t u8Channel, const uint16_t* pu16Timings, uint8_t u8Len)
+{
+  uint32_t u32AirTimeUs = 0;
+  int i;
+  if ((u8Channel >= IRTRANSMITTER_MAX_CHANNELS) || (!abInitDone[u8Channel]) || (u8Len > MAERKLIN292XXIR_FRAME_MAX_LEN))
+  {
+    return false;
+  }
+  if (IrTransmitter_IsBusy(u8Channel))
+  {
+    return false;
+  }
+  for(i = 0; i < u8Len; i++)
+  {
+    u32AirTimeUs += pu16Timings[i];
+  }
+  abPending[u8Channel] = true;
+  au32Start[u8Channel] = millis();
+  au32AirTimeMs[u8Channel] = (u32AirTimeUs + 999) / 1000;
+  u32Frames++;
+  if (pfnFrameCallback != NULL)
+  {
+    pfnFrameCallback(u8Channel, pu16Timings, u8Len);
+  }
+  return true;
+}
+
+bool IrTransmitter_IsBusy(uint8_t u8Channel)
+{
+  if ((u8Channel >= IRTRANSMITTER_MAX_CHANNELS) || (!abInitDone[u8Channel]) || (!abPending[u8Channel]))
+  {
+    return false;
+  }
+  return ((millis() - au32Start[u8Channel]) < au32AirTimeMs[u8Channel]);
+}
+
+void IrTransmitter_SetDoneCallback(pfn_irtransmitter_done_callback_t pfnCallback)
+{
+  pfnDoneCallback = pfnCallback;
+}
+
+void IrTransmitter_Update(void)
+{
+  uint8_t u8Channel;
+  for(u8Channel = 0; u8Channel < IRTRANSMITTER_MAX_CHANNELS; u8Channel++)
+  {
+    if ((abPending[u8Channel]) && (!IrTransmitter_IsBusy(u8Channel)))
+    {
+      abPending[u8Channel] = false;
+      if (pfnDoneCallback != NULL)
+      {
+        pfnDoneCallback(u8Channel);
+      }
+    }
+  }
+}
@@ -0,0 +1,154 @@
+/**
+ *******************************************************************************
+ **\file udp.cpp
+ **
+ ** Host stub of WiFiUDP on POSIX sockets
+ **
+ *******************************************************************************
+ */
+
+#include <WiFiUdp.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+/**
+ * Non-blocking socket bound to the port, shared with other processes
+ */
+bool WiFiUDP::open(uint16_t u16Port)
+{
+  struct sockaddr_in stcAddr;
+  int iOne = 1;
+  stop();
+  fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0)
+  {
+    return false;
+  }
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &iOne, sizeof(iOne));
+  setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &iOne, sizeof(iOne));
+  memset(&stcAddr, 0, sizeof(stcAddr));
+  stcAddr.sin_family = AF_INET;
+  stcAddr.sin_port = htons(u16Port);
+  stcAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if ((bind(fd, (struct sockaddr*)&stcAddr, sizeof(stcAddr)) != 0) || (fcntl(fd, F_SETFL, O_NONBLOCK) != 0))
+  {
+    stop();
+    return false;
+  }
+  return true;
+}
+
+uint8_t WiFiUDP::begin(uint16_t u16Port)
+{
+  return open(u16Port) ? 1 : 0;
+}
+
+uint8_t WiFiUDP::beginMulticast(IPAddress group, uint16_t u16Port)
+{
+  struct ip_mreq stcGroup;
+  struct in_addr stcLoopback;
+  unsigned char u8Loop = 1;
+  if (!open(u16Port))
+  {
+    return 0;
+  }
+  stcLoopback.s_addr = htonl(INADDR_LOOPBACK);
+  stcGroup.imr_multiaddr.s_addr = (uint32_t)group; //IPAddress is in network order
+  stcGroup.imr_interface = stcLoopback;
+  if ((setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &stcGroup, sizeof(stcGroup)) != 0) ||
+      (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &stcLoopback, sizeof(stcLoopback)) != 0) ||
+      (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &u8Loop, sizeof(u8Loop)) != 0))
+  {
+    stop();
+    return 0;
+  }
+  return 1;
+}
+
+void WiFiUDP::stop(void)
+{
+  if (fd >= 0)
+  {
+    close(fd);
+    fd = -1;
+  }
+  i32RxLen = 0;
+  i32RxPos = 0;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t u16Port)
+{
+  u32TxIp = (uint32_t)ip;
+  u16TxPort = u16Port;
+  i32TxLen = 0;
+  return (fd >= 0) ? 1 : 0;
+}
+
+size_t WiFiUDP::write(const uint8_t* pu8Data, size_t n)
+{
+  if (n > (size_t)(sizeof(au8Tx) - i32TxLen))
+  {
+    n = sizeof(au8Tx) - i32TxLen;
+  }
+  memcpy(&au8Tx[i32TxLen], pu8Data, n);
+  i32TxLen += n;
+  return n;
+}
+
+int WiFiUDP::endPacket(void)
+{
+  struct sockaddr_in stcAddr;
+  if (fd < 0)
+  {
+    return 0;
+  }
+  memset(&stcAddr, 0, sizeof(stcAddr));
+  stcAddr.sin_family = AF_INET;
+  stcAddr.sin_port = htons(u16TxPort);
+  stcAddr.sin_addr.s_addr = u32TxIp;
+  return (sendto(fd, au8Tx, i32TxLen, 0, (struct sockaddr*)&stcAddr, sizeof(stcAddr)) == i32TxLen) ? 1 : 0;
+}
+
+int WiFiUDP::parsePacket(void)
+{
+  struct sockaddr_in stcAddr;
+  socklen_t len = sizeof(stcAddr);
+  i32RxLen = 0;
+  i32RxPos = 0;
+  if (fd >= 0)
+  {
+    int n = recvfrom(fd, au8Rx, sizeof(au8Rx), 0, (struct sockaddr*)&stcAddr, &len);
+    if (n > 0)
+    {
+      i32RxLen = n;
+      u32RemoteIp = stcAddr.sin_addr.s_addr;
+      u16RemotePort = ntohs(stcAddr.sin_port);
+    }
+  }
+  return i32RxLen;
+}
+
+int WiFiUDP::read(void)
+{
+  uint8_t u8Data;
+  return (read(&u8Data, 1) == 1) ? u8Data : -1;
+}
+
+int WiFiUDP::read(uint8_t* pu8Buffer, size_t n)
+{
+  int len = i32RxLen - i32RxPos;
+  if (len <= 0)
+  {
+    return -1;
+  }
+  if ((size_t)len > n)
+  {
+    len = n;
+  }
+  memcpy(pu8Buffer, &au8Rx[i32RxPos], len);
+  i32RxPos += len;
+  return len;
+}
@@ -0,0 +1,85 @@
+/**
+ *******************************************************************************
+ **\file webserver.cpp
+ **
+ ** Host stub of the WebServer
+ **
+ *******************************************************************************
+ */
+
+#include <WebServer.h>
+
+void WebServer::on(const char* pcUri, HTTPMethod method, THandlerFunction fn)
+{
+  routes.push_back(Route{pcUri, method, fn});
+}
+
+bool WebServer::hasArg(const char* pcName)
+{
+  return (strcmp(pcName, "plain") == 0) && (!strBody.empty());
+}
+
+String WebServer::arg(const char* pcName)
+{
+  return String(hasArg(pcName) ? strBody.c_str() : "");
+}
+
+String WebServer::arg(int index)
+{
+  (void)index;
+  return String("");
+}
+
+void WebServer::send(int code, const char* pcContentType, const char* pcContent)
+{
+  (void)pcContentType;
+  iCode = code;
+  if (pstrResponse != NULL)
+  {
+    *pstrResponse = pcContent;
+  }
+}
+
+bool WebServer::match(const std::string& strRoute, const char* pcUri)
+{
+  size_t u32Pos = 0;
+  pathArgs.clear();
+  while(u32Pos < strRoute.size())
+  {
+    if (strRoute.compare(u32Pos, 2, "{}") == 0)
+    {
+      const char* pcEnd = strchr(pcUri, '/');
+      size_t u32Len = (pcEnd != NULL) ? (size_t)(pcEnd - pcUri) : strlen(pcUri);
+      pathArgs.push_back(std::string(pcUri, u32Len));
+      pcUri += u32Len;
+      u32Pos += 2;
+    } else if (strRoute[u32Pos] == *pcUri)
+    {
+      pcUri++;
+      u32Pos++;
+    } else
+    {
+      return false;
+    }
+  }
+  return (*pcUri == 0);
+}
+
+int WebServer::request(HTTPMethod method, const char* pcUri, const char* pcBody, std::string* pstrResult)
+{
+  size_t i;
+  for(i = 0; i < routes.size(); i++)
+  {
+    if (((routes[i].method == HTTP_ANY) || (routes[i].method == method)) && match(routes[i].strUri, pcUri))
+    {
+      enMethod = method;
+      strBody = pcBody;
+      iCode = 500;
+      pstrResponse = pstrResult;
+      routes[i].fn();
+      pstrResponse = NULL;
+      return iCode;
+    }
+  }
+  return 404;
+}
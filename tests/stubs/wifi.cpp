@@ -0,0 +1,192 @@
+/**
+ *******************************************************************************
+ **\file wifi.cpp
+ **
+ ** Host stub of the WiFi library
+ **
+ *******************************************************************************
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <deque>
+#include <map>
+#include "hoststub.h"
+
+WiFiClass WiFi;
+
+static std::map<uint16_t, std::deque<HostConnectionPtr> > mapPending;
+static std::function<HostConnectionPtr(uint32_t, uint16_t)> pfnConnectHandler;
+static uint32_t u32LocalIp = IPAddress(192,168,4,1);
+
+HostConnectionPtr HostStub_Connect(uint16_t u16Port, uint32_t u32RemoteIp)
+{
+  HostConnectionPtr pConn = std::make_shared<HostConnection>();
+  pConn->u32RemoteIp = u32RemoteIp;
+  pConn->u16Port = u16Port;
+  mapPending[u16Port].push_back(pConn);
+  return pConn;
+}
+
+void HostStub_SetConnectHandler(std::function<HostConnectionPtr(uint32_t u32Ip, uint16_t u16Port)> pfnHandler)
+{
+  pfnConnectHandler = pfnHandler;
+}
+
+void HostStub_SetLocalIp(uint32_t u32Ip)
+{
+  u32LocalIp = u32Ip;
+}
+
+IPAddress WiFiClass::localIP(void)
+{
+  return IPAddress(u32LocalIp);
+}
+
+/**
+ *******************************************************************************
+ ** WiFiServer
+ *******************************************************************************
+ */
+
+bool WiFiServer::hasClient(void)
+{
+  return !mapPending[u16Port].empty();
+}
+
+WiFiClient WiFiServer::available(void)
+{
+  std::deque<HostConnectionPtr>& queue = mapPending[u16Port];
+  HostConnectionPtr pConn;
+  if (!queue.empty())
+  {
+    pConn = queue.front();
+    queue.pop_front();
+  }
+  return WiFiClient(pConn);
+}
+
+/**
+ *******************************************************************************
+ ** WiFiClient
+ *******************************************************************************
+ */
+
+int WiFiClient::connect(IPAddress ip, uint16_t u16Port)
+{
+  stop();
+  if (pfnConnectHandler)
+  {
+    pConnection = pfnConnectHandler((uint32_t)ip, u16Port);
+  }
+  return (pConnection != NULL) ? 1 : 0;
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t u16Port, int32_t i32TimeoutMs)
+{
+  (void)i32TimeoutMs;
+  return connect(ip, u16Port);
+}
+
+int WiFiClient::connect(const char* pcHost, uint16_t u16Port)
+{
+  IPAddress ip;
+  if (!ip.fromString(pcHost))
+  {
+    return 0;
+  }
+  return connect(ip, u16Port);
+}
+
+uint8_t WiFiClient::connected(void)
+{
+  if (pConnection == NULL)
+  {
+    return 0;
+  }
+  return (pConnection->bConnected || !pConnection->strRx.empty()) ? 1 : 0;
+}
+
+void WiFiClient::stop(void)
+{
+  if (pConnection != NULL)
+  {
+    pConnection->bConnected = false;
+    pConnection->bStopped = true;
+    pConnection.reset();
+  }
+}
+
+int WiFiClient::available(void)
+{
+  return (pConnection != NULL) ? (int)pConnection->strRx.size() : 0;
+}
+
+int WiFiClient::read(void)
+{
+  uint8_t u8Data;
+  return (read(&u8Data, 1) == 1) ? u8Data : -1;
+}
+
+int WiFiClient::read(uint8_t* pu8Buffer, size_t n)
+{
+  size_t u32Len;
+  if ((pConnection == NULL) || pConnection->strRx.empty())
+  {
+    return -1;
+  }
+  u32Len = pConnection->strRx.size();
+  if (u32Len > n)
+  {
+    u32Len = n;
+  }
+  if (u32Len > pConnection->u32ReadChunk)
+  {
+    u32Len = pConnection->u32ReadChunk;
+  }
+  memcpy(pu8Buffer, pConnection->strRx.data(), u32Len);
+  pConnection->strRx.erase(0, u32Len);
+  return (int)u32Len;
+}
+
+size_t WiFiClient::write(uint8_t u8Data)
+{
+  return write(&u8Data, 1);
+}
+
+size_t WiFiClient::write(const uint8_t* pu8Data, size_t n)
+{
+  if ((pConnection == NULL) || (!pConnection->bConnected))
+  {
+    return 0;
+  }
+  if (n > pConnection->u32TxWindow)
+  {
+    n = pConnection->u32TxWindow;
+  }
+  pConnection->strTx.append((const char*)pu8Data, n);
+  if (pConnection->pfnOnWrite)
+  {
+    pConnection->pfnOnWrite(pConnection.get());
+  }
+  return n;
+}
+
+int WiFiClient::availableForWrite(void)
+{
+  if ((pConnection == NULL) || (!pConnection->bConnected))
+  {
+    return 0;
+  }
+  return (int)pConnection->u32TxWindow;
+}
+
+IPAddress WiFiClient::remoteIP(void) const
+{
+  return IPAddress((pConnection != NULL) ? pConnection->u32RemoteIp : 0);
+}
+
+uint16_t WiFiClient::remotePort(void) const
+{
+  return (pConnection != NULL) ? pConnection->u16Port : 0;
+}
@@ -0,0 +1,178 @@
+/**
+ *******************************************************************************
+ **\file withrottle_loco_bench.cpp
+ **
+ ** Loco registry benchmark of the WiThrottle server with hundreds of locos.
+ **
+ ** The registry grows from 10 to 500 locos, short and long DCC addresses.
+ ** At every size a throttle acquires the 8 locos registered last and
+ ** drives them with speed commands, reported are commands per second,
+ ** which stay the same with an indexed registry. For reference the same
+ ** lookups are done by walking the loco list like getLoco() did before.
+ **
+ ** Built with WITHROTTLE_MAX_LOCOS 512, the firmware registers 64 locos.
+ **
+ ** Usage: withrottle_loco_bench [commands per size]
+ **
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <chrono>
+#include <Arduino.h>
+#include <WiFi.h>
+#include "hoststub.h"
+#include "withrottle/withrottle.h"
+
+#define WITHROTTLE_PORT 2560
+#define LOCO_COUNT 500
+#define SHORT_LOCOS 100            ///< addresses 1...100 are short, the others long
+#define DRIVEN_LOCOS 8
+#define LINES_PER_SEGMENT 8
+
+static stc_withrottle_loco_listitem_t astcLocos[LOCO_COUNT];
+static const uint32_t au32Sizes[] = {10, 100, 250, 500};
+
+static void locoSpeed(stc_withrottle_loco_t* pHandle, bool bForward, uint8_t speed)
+{
+  (void)pHandle;
+  (void)bForward;
+  (void)speed;
+}
+
+/*
+ * Lookup as done before the registry, walking the list from the first loco
+ */
+static stc_withrottle_loco_listitem_t* listLookup(uint32_t u32Address)
+{
+  stc_withrottle_loco_listitem_t* pCurrent = &astcLocos[0];
+  while(pCurrent != NULL)
+  {
+    if (pCurrent->locoItem.u32Address == u32Address)
+    {
+      return pCurrent;
+    }
+    pCurrent = pCurrent->pNextItem;
+  }
+  return NULL;
+}
+
+static void run(HostConnectionPtr pConn)
+{
+  while(!pConn->strRx.empty())
+  {
+    WiThrottle_Update();
+    pConn->strTx.clear();
+    HostStub_AdvanceMillis(1);
+  }
+  WiThrottle_Update();
+  pConn->strTx.clear();
+}
+
+int main(int argc, char** argv)
+{
+  uint32_t u32Commands = (argc > 1) ? (uint32_t)atoi(argv[1]) : 200000;
+  HostConnectionPtr pConn;
+  uint32_t u32Registered = 0;
+  uint32_t u32Size;
+  uint32_t i;
+  char acLine[48];
+  bool bOk = true;
+
+  srand(1435);
+  for(i = 0; i < LOCO_COUNT; i++)
+  {
+    uint32_t u32Address = i + 1;
+    if (i >= SHORT_LOCOS)
+    {
+      //long addresses, unique and spread over the DCC range
+      u32Address = 128 + (i - SHORT_LOCOS) * 24 + (rand() % 24);
+    }
+    astcLocos[i].locoItem.bLongAddress = (i >= SHORT_LOCOS);
+    astcLocos[i].locoItem.u32Address = u32Address;
+    astcLocos[i].locoItem.cbSpeedUpdated = locoSpeed;
+  }
+
+  HostStub_SetMillis(1000);
+  WiThrottle_Init(3);
+  pConn = HostStub_Connect(WITHROTTLE_PORT, IPAddress(192,168,4,100));
+  pConn->strRx = "NBench\nHUbench\n";
+  run(pConn);
+
+  for(u32Size = 0; u32Size < sizeof(au32Sizes) / sizeof(au32Sizes[0]); u32Size++)
+  {
+    uint32_t u32Count = au32Sizes[u32Size];
+    stc_withrottle_loco_t* apDriven[DRIVEN_LOCOS];
+    volatile uint32_t u32Found = 0;
+    double dRegister;
+    double dCommands;
+    double dList;
+
+    //
+    // register the next locos
+    //
+    auto start = std::chrono::steady_clock::now();
+    for(; u32Registered < u32Count; u32Registered++)
+    {
+      if (!WiThrottle_AddLoco(&astcLocos[u32Registered]))
+      {
+        printf("loco %u not registered\n", astcLocos[u32Registered].locoItem.u32Address);
+        return 1;
+      }
+    }
+    dRegister = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    //
+    // acquire the locos registered last, the end of the list
+    //
+    pConn->strRx = "MT-*<;>r\n";
+    for(i = 0; i < DRIVEN_LOCOS; i++)
+    {
+      apDriven[i] = &astcLocos[u32Count - 1 - i].locoItem;
+      snprintf(acLine, sizeof(acLine), "MT+%c%u<;>%c%u\n",
+               apDriven[i]->bLongAddress ? 'L' : 'S', apDriven[i]->u32Address,
+               apDriven[i]->bLongAddress ? 'L' : 'S', apDriven[i]->u32Address);
+      pConn->strRx += acLine;
+    }
+    run(pConn);
+
+    //
+    // drive them
+    //
+    start = std::chrono::steady_clock::now();
+    for(i = 0; i < u32Commands; i++)
+    {
+      stc_withrottle_loco_t* pLoco = apDriven[i % DRIVEN_LOCOS];
+      snprintf(acLine, sizeof(acLine), "MTA%c%u<;>V%u\n", pLoco->bLongAddress ? 'L' : 'S', pLoco->u32Address, i % 127);
+      pConn->strRx += acLine;
+      if ((i % LINES_PER_SEGMENT) == (LINES_PER_SEGMENT - 1))
+      {
+        run(pConn);
+      }
+    }
+    run(pConn);
+    dCommands = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (apDriven[(u32Commands - 1) % DRIVEN_LOCOS]->speed != (int)((u32Commands - 1) % 127))
+    {
+      printf("%u locos: commands not executed\n", u32Count);
+      bOk = false;
+    }
+
+    //
+    // the same lookups walking the list
+    //
+    start = std::chrono::steady_clock::now();
+    for(i = 0; i < u32Commands; i++)
+    {
+      u32Found += (listLookup(apDriven[i % DRIVEN_LOCOS]->u32Address) != NULL);
+    }
+    dList = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%4u locos: %8.0f registrations/s %10.0f commands/s, list walk %12.0f lookups/s (%u)\n",
+           u32Count, (u32Count - (u32Size ? au32Sizes[u32Size - 1] : 0)) / dRegister,
+           u32Commands / dCommands, u32Commands / dList, (uint32_t)u32Found);
+  }
+  return bOk ? 0 : 1;
+}
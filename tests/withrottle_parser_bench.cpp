@@ -0,0 +1,306 @@
+/**
+ *******************************************************************************
+ **\file withrottle_parser_bench.cpp
+ **
+ ** WiThrottle parser test and throughput benchmark over a corpus of traces.
+ **
+ ** - every trace is replayed whole, with 1 byte reads and with random
+ **   segments; the loco callbacks have to be the same every time
+ ** - lines longer than the receive buffer are dropped completely
+ **   (framing_session.txt drives loco S2 only with 10, 20, ... 60 and
+ **   toggles F1 once)
+ ** - fuzz: mutated traces (flipped bytes, cut and repeated ranges, extra
+ **   line ends) are replayed, afterwards a new throttle still has to be
+ **   served
+ ** - parsed lines per second of every trace
+ **
+ ** Usage: withrottle_parser_bench [-f fuzz rounds] <trace>...
+ **
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <Arduino.h>
+#include <WiFi.h>
+#include "hoststub.h"
+#include "withrottle/withrottle.h"
+
+#define WITHROTTLE_PORT 2560
+#define SHORT_LOCOS 10
+#define LONG_ADDRESS 1234
+#define REPLAY_TIMEOUT_MS 10000
+#define BENCH_ROUNDS 500
+
+typedef enum en_segmentation
+{
+  enSegmentWhole,
+  enSegmentBytes,
+  enSegmentRandom,
+} en_segmentation_t;
+
+static stc_withrottle_loco_listitem_t astcLocos[SHORT_LOCOS + 1];
+static std::string strLog;
+static int iErrors = 0;
+
+static void locoSpeed(stc_withrottle_loco_t* pHandle, bool bForward, uint8_t speed)
+{
+  char acEntry[32];
+  snprintf(acEntry, sizeof(acEntry), "%u %c%u\n", pHandle->u32Address, bForward ? 'V' : 'v', speed);
+  strLog += acEntry;
+}
+
+static bool locoFunction(stc_withrottle_loco_t* pHandle, uint8_t u8Function)
+{
+  char acEntry[32];
+  snprintf(acEntry, sizeof(acEntry), "%u F%u\n", pHandle->u32Address, u8Function);
+  strLog += acEntry;
+  return true;
+}
+
+static bool readFile(const char* pcFile, std::string* pstrData)
+{
+  FILE* pFile = fopen(pcFile, "rb");
+  char acBuffer[4096];
+  size_t n;
+  if (pFile == NULL)
+  {
+    return false;
+  }
+  while((n = fread(acBuffer, 1, sizeof(acBuffer), pFile)) > 0)
+  {
+    pstrData->append(acBuffer, n);
+  }
+  fclose(pFile);
+  return true;
+}
+
+static void loop(void)
+{
+  WiThrottle_Update();
+  HostStub_AdvanceMillis(1);
+}
+
+/*
+ * Replay a trace on a new connection
+ *
+ * \return loco callbacks of the trace
+ */
+static std::string replay(const std::string& strTrace, en_segmentation_t enSegmentation)
+{
+  HostConnectionPtr pConn = HostStub_Connect(WITHROTTLE_PORT, IPAddress(192,168,4,100));
+  uint32_t u32Start = millis();
+  size_t u32Pos = 0;
+  int i;
+  strLog.clear();
+  //every trace starts with the locos stopped and forward
+  for(i = 0; i <= SHORT_LOCOS; i++)
+  {
+    astcLocos[i].locoItem.bDir = true;
+    astcLocos[i].locoItem.speed = 0;
+  }
+  if (enSegmentation == enSegmentBytes)
+  {
+    pConn->u32ReadChunk = 1;
+  }
+  while((!pConn->bStopped) && ((millis() - u32Start) < REPLAY_TIMEOUT_MS))
+  {
+    if (u32Pos < strTrace.size())
+    {
+      size_t u32Len = strTrace.size() - u32Pos;
+      if (enSegmentation == enSegmentRandom)
+      {
+        u32Len = 1 + (rand() % 64);
+        pConn->u32ReadChunk = 1 + (rand() % 32);
+      }
+      pConn->strRx.append(strTrace, u32Pos, u32Len);
+      u32Pos += u32Len;
+    } else if (pConn->strRx.empty())
+    {
+      //trace without quit, the throttle goes away
+      pConn->bConnected = false;
+    }
+    loop();
+  }
+  if (!pConn->bStopped)
+  {
+    printf("FAIL: replay did not finish\n");
+    iErrors++;
+  }
+  return strLog;
+}
+
+/*
+ * A new throttle has to be served
+ */
+static bool probe(void)
+{
+  HostConnectionPtr pConn = HostStub_Connect(WITHROTTLE_PORT, IPAddress(192,168,4,200));
+  bool bServed;
+  int i;
+  pConn->strRx = "NProbe\nHUprobe\nMT+S1<;>S1\n";
+  for(i = 0; i < 3; i++)
+  {
+    loop();
+  }
+  bServed = (pConn->strTx.find("VN2.0") != std::string::npos) && (pConn->strTx.find("MT+S1<;>") != std::string::npos);
+  pConn->strRx = "Q\n";
+  loop();
+  return bServed;
+}
+
+static std::string mutate(const std::string& strTrace)
+{
+  std::string strMutated = strTrace;
+  int iMutations = 1 + (rand() % 8);
+  int i;
+  for(i = 0; (i < iMutations) && (!strMutated.empty()); i++)
+  {
+    size_t u32Pos = rand() % strMutated.size();
+    size_t u32Len = 1 + (rand() % 200);
+    switch(rand() % 5)
+    {
+      case 0:
+        strMutated[u32Pos] = (char)(rand() & 0xff);
+        break;
+      case 1:
+        strMutated.insert(u32Pos, 1, '\n');
+        break;
+      case 2:
+        strMutated.erase(u32Pos, u32Len);
+        break;
+      case 3:
+        strMutated.insert(u32Pos, strMutated.substr(u32Pos, u32Len));
+        break;
+      default:
+        strMutated.insert(u32Pos, std::string(u32Len, "<;>MTAVF0123456789*LS"[rand() % 21]));
+        break;
+    }
+  }
+  return strMutated;
+}
+
+static uint32_t countLines(const std::string& strTrace)
+{
+  uint32_t u32Lines = 0;
+  size_t i;
+  for(i = 0; i < strTrace.size(); i++)
+  {
+    u32Lines += (strTrace[i] == '\n') ? 1 : 0;
+  }
+  return u32Lines;
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<std::string> traces;
+  std::vector<const char*> names;
+  int iFuzzRounds = 2000;
+  int i;
+  size_t t;
+
+  for(i = 1; i < argc; i++)
+  {
+    if ((strcmp(argv[i], "-f") == 0) && ((i + 1) < argc))
+    {
+      iFuzzRounds = atoi(argv[++i]);
+      continue;
+    }
+    traces.push_back(std::string());
+    names.push_back(argv[i]);
+    if (!readFile(argv[i], &traces.back()))
+    {
+      fprintf(stderr, "cannot read %s\n", argv[i]);
+      return 2;
+    }
+  }
+  if (traces.empty())
+  {
+    fprintf(stderr, "usage: %s [-f fuzz rounds] <trace>...\n", argv[0]);
+    return 2;
+  }
+
+  for(i = 0; i <= SHORT_LOCOS; i++)
+  {
+    astcLocos[i].locoItem.bLongAddress = (i == SHORT_LOCOS);
+    astcLocos[i].locoItem.u32Address = (i == SHORT_LOCOS) ? LONG_ADDRESS : (i + 1);
+    astcLocos[i].locoItem.cbSpeedUpdated = locoSpeed;
+    astcLocos[i].locoItem.cbFunctionUpdated = locoFunction;
+    WiThrottle_AddLoco(&astcLocos[i]);
+  }
+  HostStub_SetMillis(1000);
+  WiThrottle_Init(3);
+  srand(15);
+
+  //
+  // segmentation must not change what is decoded
+  //
+  for(t = 0; t < traces.size(); t++)
+  {
+    std::string strWhole = replay(traces[t], enSegmentWhole);
+    std::string strBytes = replay(traces[t], enSegmentBytes);
+    std::string strRandom = replay(traces[t], enSegmentRandom);
+    if (strWhole.empty() || (strWhole != strBytes) || (strWhole != strRandom))
+    {
+      printf("FAIL %s: decoded differently depending on the segments\n", names[t]);
+      iErrors++;
+    }
+    if (strstr(names[t], "framing_session") != NULL)
+    {
+      std::string strLoco2;
+      size_t u32Pos = 0;
+      while(u32Pos < strWhole.size())
+      {
+        size_t u32End = strWhole.find('\n', u32Pos);
+        if (strWhole.compare(u32Pos, 2, "2 ") == 0)
+        {
+          strLoco2.append(strWhole, u32Pos + 2, u32End - u32Pos - 2);
+          strLoco2 += ' ';
+        }
+        u32Pos = u32End + 1;
+      }
+      if (strLoco2 != "V10 V20 V30 V40 F1 V50 V60 ")
+      {
+        printf("FAIL %s: loco 2 got \"%s\"\n", names[t], strLoco2.c_str());
+        iErrors++;
+      }
+    }
+  }
+
+  //
+  // fuzz
+  //
+  for(i = 0; i < iFuzzRounds; i++)
+  {
+    replay(mutate(traces[rand() % traces.size()]), (en_segmentation_t)(rand() % 3));
+    if (!probe())
+    {
+      printf("FAIL: fuzz round %d, throttle not served afterwards\n", i);
+      iErrors++;
+      break;
+    }
+  }
+  printf("%d fuzz rounds\n", iFuzzRounds);
+
+  //
+  // throughput, the whole trace is decoded by one WiThrottle_Update()
+  //
+  for(t = 0; t < traces.size(); t++)
+  {
+    uint32_t u32Lines = countLines(traces[t]) * BENCH_ROUNDS;
+    double dSeconds;
+    auto start = std::chrono::steady_clock::now();
+    for(i = 0; i < BENCH_ROUNDS; i++)
+    {
+      replay(traces[t], enSegmentWhole);
+    }
+    dSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-40s %8u lines in %.3f s: %10.0f lines/s\n", strrchr(names[t], '/') ? strrchr(names[t], '/') + 1 : names[t], u32Lines, dSeconds, u32Lines / dSeconds);
+  }
+
+  printf("%d errors\n", iErrors);
+  return (iErrors == 0) ? 0 : 1;
+}
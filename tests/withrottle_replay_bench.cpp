@@ -0,0 +1,153 @@
+/**
+ *******************************************************************************
+ **\file withrottle_replay_bench.cpp
+ **
+ ** Replay benchmark of the WiThrottle server.
+ **
+ ** An Engine Driver session (two throttles, slider drags, functions,
+ ** heartbeats, release and quit) is sent again and again through a client
+ ** connection, up to 8 commands per loop(), and the gateway decodes it with
+ ** WiThrottle_Update(). The
+ ** speed and function changes go through the loco database into the IR
+ ** scheduler. Reported are parsed commands per second for segment sized
+ ** reads and for reads of one byte, like the gateway did before.
+ **
+ ** Usage: withrottle_replay_bench <session file> [rounds]
+ **
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <chrono>
+#include <Arduino.h>
+#include <WiFi.h>
+#include "hoststub.h"
+#include "withrottle/withrottle.h"
+#include "maerklin_ir_gw/locodatabase.h"
+#include "maerklin_ir_gw/maerklin292xxir.h"
+
+#define WITHROTTLE_PORT 2560
+#define SESSION_TIMEOUT_MS 10000
+#define LINES_PER_SEGMENT 8    ///< commands arriving between two loops, e.g. while a slider is dragged
+
+static std::string strSession;
+static uint32_t u32Lines = 0;
+
+static bool readSession(const char* pcFile)
+{
+  FILE* pFile = fopen(pcFile, "rb");
+  char acBuffer[4096];
+  size_t n;
+  if (pFile == NULL)
+  {
+    return false;
+  }
+  while((n = fread(acBuffer, 1, sizeof(acBuffer), pFile)) > 0)
+  {
+    strSession.append(acBuffer, n);
+  }
+  fclose(pFile);
+  for(n = 0; n < strSession.size(); n++)
+  {
+    if (strSession[n] == '\n')
+    {
+      u32Lines++;
+    }
+  }
+  return (u32Lines > 0);
+}
+
+/*
+ * Deliver the next commands of the session to the connection
+ *
+ * \return position of the following commands in the session
+ */
+static size_t nextSegment(HostConnectionPtr pConn, size_t u32Pos)
+{
+  size_t u32End = u32Pos;
+  int i;
+  for(i = 0; (i < LINES_PER_SEGMENT) && (u32End < strSession.size()); i++)
+  {
+    u32End = strSession.find('\n', u32End);
+    u32End = (u32End == std::string::npos) ? strSession.size() : u32End + 1;
+  }
+  pConn->strRx.append(strSession, u32Pos, u32End - u32Pos);
+  return u32End;
+}
+
+/*
+ * Replay the session once on a new connection, until the throttle quit
+ *
+ * \return false if the session was not decoded completely
+ */
+static bool replay(size_t u32ReadChunk, uint32_t u32Round)
+{
+  HostConnectionPtr pConn = HostStub_Connect(WITHROTTLE_PORT, IPAddress(192,168,4,100 + (u32Round % 100)));
+  uint32_t u32Start = millis();
+  size_t u32Pos = 0;
+  pConn->u32ReadChunk = u32ReadChunk;
+  while((!pConn->bStopped) && ((millis() - u32Start) < SESSION_TIMEOUT_MS))
+  {
+    u32Pos = nextSegment(pConn, u32Pos);
+    WiThrottle_Update();
+    Maerklin292xxIr_Update();
+    HostStub_AdvanceMillis(1);
+  }
+  if ((!pConn->bStopped) || (!pConn->strRx.empty()))
+  {
+    printf("session not finished, %u bytes left\n", (unsigned int)pConn->strRx.size());
+    return false;
+  }
+  if ((pConn->strTx.find("VN2.0") == std::string::npos) ||
+      (pConn->strTx.find("MT+S1<;>") == std::string::npos) ||
+      (pConn->strTx.find("MS+S7<;>") == std::string::npos))
+  {
+    printf("answers missing: %s\n", pConn->strTx.c_str());
+    return false;
+  }
+  return true;
+}
+
+static bool run(const char* pcName, size_t u32ReadChunk, uint32_t u32Rounds)
+{
+  uint32_t u32KeepAlives = HostStub_GetKeepAliveCount();
+  uint32_t u32Round;
+  double dSeconds;
+  auto start = std::chrono::steady_clock::now();
+  for(u32Round = 0; u32Round < u32Rounds; u32Round++)
+  {
+    if (!replay(u32ReadChunk, u32Round))
+    {
+      return false;
+    }
+  }
+  dSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("%-16s %8u commands in %.3f s: %10.0f commands/s, %.2f keep-alives per command\n",
+         pcName, u32Lines * u32Rounds, dSeconds, u32Lines * u32Rounds / dSeconds,
+         (double)(HostStub_GetKeepAliveCount() - u32KeepAlives) / (u32Lines * u32Rounds));
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  uint32_t u32Rounds = (argc > 2) ? (uint32_t)atoi(argv[2]) : 200;
+  bool bOk;
+
+  if ((argc < 2) || (!readSession(argv[1])))
+  {
+    fprintf(stderr, "usage: %s <session file> [rounds]\n", argv[0]);
+    return 2;
+  }
+  printf("session: %u commands, %u bytes\n", u32Lines, (unsigned int)strSession.size());
+
+  HostStub_SetMillis(1000);
+  Maerklin292xxIr_Init();
+  LocoDatabase_Init();
+  WiThrottle_Init(3);
+
+  bOk = run("segment reads", 1460, u32Rounds);
+  bOk = bOk && run("1 byte reads", 1, u32Rounds);
+  return bOk ? 0 : 1;
+}
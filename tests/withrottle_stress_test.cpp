@@ -0,0 +1,257 @@
+/**
+ *******************************************************************************
+ **\file withrottle_stress_test.cpp
+ **
+ ** Stress test of the WiThrottle client pool.
+ **
+ ** The pool is sized from the given free heap. The test fills it with
+ ** simulated throttles which drive shared locos at the same time, checks
+ ** that changes are pushed to every throttle holding a loco, that a
+ ** throttle is rejected while all slots are busy, that an idle throttle is
+ ** evicted for a new one, that slots are reused after hundreds of
+ ** quits and lost connections, and that lines sent behind a quit are not
+ ** decoded for the closed slot.
+ **
+ ** Usage: withrottle_stress_test <free heap> <expected pool size>
+ **
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <Arduino.h>
+#include <WiFi.h>
+#include "hoststub.h"
+#include "withrottle/withrottle.h"
+#include "maerklin_ir_gw/locodatabase.h"
+#include "maerklin_ir_gw/maerklin292xxir.h"
+
+#define WITHROTTLE_PORT 2560
+#define LOCO_COUNT 10
+#define DRIVE_LOOPS 3000
+#define HEARTBEAT_MS 2000
+#define CHURN_CYCLES 300
+
+typedef struct stc_sim_client
+{
+  HostConnectionPtr pConn;
+  int iLoco;
+  bool bHeartbeat;
+} stc_sim_client_t;
+
+static int iErrors = 0;
+static uint32_t u32NextIp = 1;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAIL line %d: ", __LINE__); printf(__VA_ARGS__); printf("\n"); iErrors++; } } while(0)
+
+static void loop(int iCount)
+{
+  int i;
+  for(i = 0; i < iCount; i++)
+  {
+    WiThrottle_Update();
+    Maerklin292xxIr_Update();
+    HostStub_AdvanceMillis(1);
+  }
+}
+
+static void send(stc_sim_client_t* pClient, const char* format, ...)
+{
+  char acLine[64];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(acLine, sizeof(acLine), format, args);
+  va_end(args);
+  pClient->pConn->strRx += acLine;
+  pClient->pConn->strRx += '\n';
+}
+
+static bool received(stc_sim_client_t* pClient, const char* pcText)
+{
+  return (pClient->pConn->strTx.find(pcText) != std::string::npos);
+}
+
+/*
+ * Connect a throttle, the connect is accepted by the next loop
+ */
+static stc_sim_client_t connectClient(int iLoco, bool bHeartbeat)
+{
+  stc_sim_client_t stcClient;
+  stcClient.pConn = HostStub_Connect(WITHROTTLE_PORT, IPAddress(10,0,(uint8_t)(u32NextIp >> 8),(uint8_t)u32NextIp));
+  stcClient.iLoco = iLoco;
+  stcClient.bHeartbeat = bHeartbeat;
+  u32NextIp++;
+  send(&stcClient, "NThrottle %u", u32NextIp);
+  send(&stcClient, "HU%08x", u32NextIp);
+  send(&stcClient, bHeartbeat ? "*+" : "*-");
+  send(&stcClient, "MT+S%d<;>S%d", iLoco, iLoco);
+  return stcClient;
+}
+
+static bool served(stc_sim_client_t* pClient)
+{
+  char acAcquired[24];
+  snprintf(acAcquired, sizeof(acAcquired), "MT+S%d<;>", pClient->iLoco);
+  return (!pClient->pConn->bStopped) && received(pClient, "VN2.0") && received(pClient, acAcquired);
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<stc_sim_client_t> clients;
+  uint32_t u32Pool;
+  uint32_t u32ExpectedPool;
+  uint32_t u32Heartbeat, u32Idle, u32Disconnected, u32LocosStopped;
+  uint32_t u32Quits = 0;
+  uint32_t u32Lost = 0;
+  uint32_t i;
+  int iLoop;
+
+  if (argc < 3)
+  {
+    fprintf(stderr, "usage: %s <free heap> <expected pool size>\n", argv[0]);
+    return 2;
+  }
+  u32ExpectedPool = (uint32_t)atoi(argv[2]);
+
+  HostStub_SetMillis(1000);
+  HostStub_SetFreeHeap((uint32_t)atoi(argv[1]));
+  Maerklin292xxIr_Init();
+  LocoDatabase_Init();
+  WiThrottle_Init(100);
+  WiThrottle_SetStopLocos(true);
+  u32Pool = WiThrottle_GetMaxClients();
+  CHECK(u32Pool == u32ExpectedPool, "pool size %u, expected %u", u32Pool, u32ExpectedPool);
+
+  //
+  // fill the pool, two throttles per loco if possible
+  //
+  for(i = 0; i < u32Pool; i++)
+  {
+    clients.push_back(connectClient((i % ((u32Pool + 1) / 2)) + 1, i != 0));
+    loop(1);
+  }
+  loop(10);
+  for(i = 0; i < u32Pool; i++)
+  {
+    CHECK(served(&clients[i]), "client %u not served", i);
+  }
+
+  //
+  // drive all locos at the same time, every change is pushed to the other throttle of a loco
+  //
+  srand(2560);
+  for(iLoop = 0; iLoop < DRIVE_LOOPS; iLoop++)
+  {
+    stc_sim_client_t* pClient = &clients[rand() % u32Pool];
+    if (pClient != &clients[0])
+    {
+      send(pClient, "MTAS%d<;>V%d", pClient->iLoco, rand() % 127);
+    }
+    if ((iLoop % HEARTBEAT_MS) == 0)
+    {
+      for(i = 1; i < u32Pool; i++)
+      {
+        send(&clients[i], "*");
+      }
+    }
+    loop(1);
+  }
+  for(i = 0; i < u32Pool; i++)
+  {
+    char acPush[24];
+    snprintf(acPush, sizeof(acPush), "MTAS%d<;>V", clients[i].iLoco);
+    CHECK(!clients[i].pConn->bStopped, "client %u closed while driving", i);
+    CHECK((i == 0) || received(&clients[i], acPush), "client %u got no speed of loco %d", i, clients[i].iLoco);
+  }
+  WiThrottle_GetCloseStats(&u32Heartbeat, &u32Idle, &u32Disconnected, &u32LocosStopped);
+  CHECK((u32Heartbeat == 0) && (u32Idle == 0) && (u32Disconnected == 0), "clients closed while driving");
+
+  //
+  // pool full and all throttles active: a new throttle is rejected
+  //
+  {
+    stc_sim_client_t stcExtra = connectClient(1, true);
+    loop(2);
+    CHECK(stcExtra.pConn->bStopped && stcExtra.pConn->strTx.empty(), "throttle accepted while the pool is full");
+    CHECK(WiThrottle_GetEvictedClients() == 0, "active throttle evicted");
+  }
+
+  //
+  // client 0 (no heartbeat) is idle for more than 10 s, a new throttle replaces it
+  //
+  for(iLoop = 0; iLoop < 11; iLoop++)
+  {
+    for(i = 1; i < u32Pool; i++)
+    {
+      send(&clients[i], "*");
+    }
+    loop(1000);
+  }
+  {
+    stc_sim_client_t stcNew = connectClient(1, true);
+    loop(2);
+    CHECK(served(&stcNew), "throttle not accepted after the idle time");
+    CHECK(clients[0].pConn->bStopped, "idle throttle not closed");
+    CHECK(WiThrottle_GetEvictedClients() == 1, "%u throttles evicted, expected 1", WiThrottle_GetEvictedClients());
+    clients[0] = stcNew;
+  }
+
+  //
+  // throttles quit or lose the connection, new ones take the slots
+  //
+  for(iLoop = 0; iLoop < CHURN_CYCLES; iLoop++)
+  {
+    i = rand() % u32Pool;
+    if (iLoop & 1)
+    {
+      send(&clients[i], "Q");
+      u32Quits++;
+    } else
+    {
+      clients[i].pConn->bConnected = false; //lost, e.g. phone left the WiFi
+      u32Lost++;
+    }
+    loop(2);
+    CHECK(clients[i].pConn->bStopped, "cycle %d: client %u not closed", iLoop, i);
+    clients[i] = connectClient((rand() % LOCO_COUNT) + 1, true);
+    loop(2);
+    CHECK(served(&clients[i]), "cycle %d: slot %u not reused", iLoop, i);
+    for(uint32_t j = 0; j < u32Pool; j++)
+    {
+      send(&clients[j], "*");
+    }
+  }
+  //
+  // lines behind Q in the same segment are not decoded for the closed slot
+  //
+  {
+    int iOther = (clients[0].iLoco % LOCO_COUNT) + 1;
+    int iSpeedBefore, iSpeedAfter;
+    uint32_t u32Functions;
+    char acAcquired[24];
+    LocoDatabase_GetState(iOther, &iSpeedBefore, &u32Functions);
+    send(&clients[0], "Q");
+    send(&clients[0], "MT+S%d<;>S%d", iOther, iOther);
+    send(&clients[0], "MTAS%d<;>V%d", iOther, (iSpeedBefore == 3) ? 0 : 126);
+    loop(2);
+    u32Quits++;
+    snprintf(acAcquired, sizeof(acAcquired), "MT+S%d<;>", iOther);
+    LocoDatabase_GetState(iOther, &iSpeedAfter, &u32Functions);
+    CHECK(clients[0].pConn->bStopped, "client not closed by Q");
+    CHECK(!received(&clients[0], acAcquired), "loco acquired after Q");
+    CHECK(iSpeedAfter == iSpeedBefore, "speed changed after Q, %d -> %d", iSpeedBefore, iSpeedAfter);
+    clients[0] = connectClient(iOther, true);
+    loop(2);
+    CHECK(served(&clients[0]), "slot not reused after Q");
+  }
+
+  WiThrottle_GetCloseStats(&u32Heartbeat, &u32Idle, &u32Disconnected, &u32LocosStopped);
+  CHECK(u32Disconnected == u32Lost, "%u lost connections counted, expected %u", u32Disconnected, u32Lost);
+  CHECK(u32Heartbeat == 0, "%u heartbeat timeouts", u32Heartbeat);
+  CHECK(WiThrottle_GetMaxClients() == u32Pool, "pool size changed");
+
+  printf("pool %u: %u quits, %u lost connections, %u locos stopped, %d errors\n", u32Pool, u32Quits, u32Lost, u32LocosStopped, iErrors);
+  return (iErrors == 0) ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+import argparse
+import http.client
+import json
+import socket
+import struct
+import time
+
+dictCommands = {
+        "stop":0,
+        "forward":1,
+        "backward":2,
+        "light":3,
+        "sound":4,
+        "speed":5,
+        "keepalive":6
+        }
+
+def buildPacket(seq, channel, command, arg, ack):
+    flags = 0x01 if ack else 0x00
+    channelByte = ord(channel) if channel else 0
+    return struct.pack("<cBHBBbB", b"M", flags, seq & 0xFFFF, channelByte, dictCommands[command], arg, 0)
+
+def sendCommand(sock, address, seq, channel, command, arg, ack, timeout):
+    packet = buildPacket(seq, channel, command, arg, ack)
+    start = time.perf_counter()
+    sock.sendto(packet, address)
+    if not ack:
+        return None
+    sock.settimeout(timeout)
+    while True:
+        try:
+            data, _ = sock.recvfrom(16)
+        except socket.timeout:
+            return None
+        if len(data) == 4:
+            magic, status, ackSeq = struct.unpack("<cBH", data)
+            if (magic == b"m") and (ackSeq == (seq & 0xFFFF)):
+                if status != 0:
+                    print("command rejected by gateway")
+                return time.perf_counter() - start
+
+def postCommand(host, channel, command, arg, timeout):
+    body = {"cmd":command}
+    if channel:
+        body["channel"] = channel
+    if command in ("speed", "sound"):
+        body["args"] = str(arg)
+    start = time.perf_counter()
+    try:
+        conn = http.client.HTTPConnection(host, 80, timeout=timeout)
+        conn.request("POST", "/api/cmd", json.dumps(body), {"Content-Type":"application/json"})
+        response = conn.getresponse()
+        response.read()
+        conn.close()
+    except (OSError, http.client.HTTPException):
+        return None
+    if response.status != 200:
+        return None
+    return time.perf_counter() - start
+
+def printStatistics(name, times, lost):
+    if times:
+        print("%-8s %d acknowledged, %d lost, round trip min %.1f ms avg %.1f ms max %.1f ms" % (name, len(times), lost, min(times), sum(times) / len(times), max(times)))
+    else:
+        print("%-8s no acknowledge received" % name)
+
+def main(host, port, channel, command, arg, ack, repeat, timeout, compareHttp):
+    address = (socket.gethostbyname(host), port)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    seq = int(time.time()) & 0xFFFF
+    times = []
+    lost = 0
+    for i in range(repeat):
+        rtt = sendCommand(sock, address, seq + i, channel, command, arg, ack, timeout)
+        if ack:
+            if rtt is None:
+                lost += 1
+            else:
+                times.append(rtt * 1000.0)
+    if ack and repeat > 0:
+        printStatistics("UDP", times, lost)
+    if compareHttp:
+        #same commands via POST /api/cmd, a new connection per command like a button of the web UI
+        times = []
+        lost = 0
+        for i in range(repeat):
+            rtt = postCommand(address[0], channel, command, arg, timeout)
+            if rtt is None:
+                lost += 1
+            else:
+                times.append(rtt * 1000.0)
+        printStatistics("HTTP", times, lost)
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Send a command to the IR gateway via UDP")
+    parser.add_argument("host", help="gateway host name or IP, e.g. maerklin292xx_gateway.local")
+    parser.add_argument("command", choices=dictCommands.keys())
+    parser.add_argument("arg", nargs="?", type=int, default=0, help="speed -3...3 or sound 1...3")
+    parser.add_argument("-c", "--channel", default="", help="channel A...J, current channel if not set")
+    parser.add_argument("-p", "--port", type=int, default=2561)
+    parser.add_argument("-a", "--ack", action="store_true", help="request acknowledge and print the round trip time")
+    parser.add_argument("-n", "--repeat", type=int, default=1, help="send the command n times")
+    parser.add_argument("-t", "--timeout", type=float, default=0.5, help="acknowledge timeout in s")
+    parser.add_argument("-b", "--compare-http", action="store_true", help="send the commands also via POST /api/cmd and compare the round trip times, implies -a")
+    args = parser.parse_args()
+    main(args.host, args.port, args.channel, args.command, args.arg, args.ack or args.compare_http, args.repeat, args.timeout, args.compare_http)